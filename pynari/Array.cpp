@@ -15,57 +15,244 @@
 // ======================================================================== //
 
 #include "pynari/Array.h"
+#include "pynari/parallel.h"
+#include <cmath>
 #include <cstdlib>
 
 namespace pynari {
 
+  /*! how to histogram values of type T in a single pass, before
+      their range is known: values get counted in 'numKeys' bins
+      that are ordered by value and together cover all of T's values
+      (exactly one value per bin for 8- and 16-bit types; for 32-bit
+      types, the upper 16 bits of an order-preserving bit pattern),
+      which then get re-binned once min and max are known */
+  template<typename T> struct HistogramKeys;
+  template<> struct HistogramKeys<uint8_t> {
+    enum { numKeys = 1<<8 };
+    static bool     valid(uint8_t) { return true; }
+    static uint32_t key(uint8_t v) { return v; }
+    static void range(uint32_t k, double &lo, double &hi) { lo = hi = k; }
+  };
+  template<> struct HistogramKeys<uint16_t> {
+    enum { numKeys = 1<<16 };
+    static bool     valid(uint16_t) { return true; }
+    static uint32_t key(uint16_t v) { return v; }
+    static void range(uint32_t k, double &lo, double &hi) { lo = hi = k; }
+  };
+  template<> struct HistogramKeys<uint32_t> {
+    enum { numKeys = 1<<16 };
+    static bool     valid(uint32_t) { return true; }
+    static uint32_t key(uint32_t v) { return v >> 16; }
+    static void range(uint32_t k, double &lo, double &hi)
+    { lo = double(k << 16); hi = double((k << 16) | 0xffff); }
+  };
+  template<> struct HistogramKeys<int32_t> {
+    enum { numKeys = 1<<16 };
+    static bool     valid(int32_t) { return true; }
+    static uint32_t key(int32_t v) { return (uint32_t(v) ^ 0x80000000u) >> 16; }
+    static void range(uint32_t k, double &lo, double &hi)
+    {
+      lo = double(int32_t((k << 16) ^ 0x80000000u));
+      hi = double(int32_t(((k << 16) | 0xffff) ^ 0x80000000u));
+    }
+  };
+  template<> struct HistogramKeys<float> {
+    enum { numKeys = 1<<16 };
+    static bool valid(float v) { return std::isfinite(v); }
+    static uint32_t key(float v)
+    {
+      uint32_t bits; memcpy(&bits,&v,sizeof(bits));
+      return ((bits & 0x80000000u) ? ~bits : (bits | 0x80000000u)) >> 16;
+    }
+    static float decode(uint32_t ordered)
+    {
+      uint32_t bits
+        = (ordered & 0x80000000u) ? (ordered & 0x7fffffffu) : ~ordered;
+      float v; memcpy(&v,&bits,sizeof(v));
+      return v;
+    }
+    static void range(uint32_t k, double &lo, double &hi)
+    { lo = decode(k << 16); hi = decode((k << 16) | 0xffff); }
+  };
+
+  /*! turns a histogram over HistogramKeys' bins into one of
+      'numBins' equally wide bins over [lower,upper]; keys whose range
+      straddles a bin boundary get split in proportion to the overlap */
+  template<typename T>
+  std::vector<uint64_t> rebinHistogram(const std::vector<uint64_t> &keyCounts,
+                                       double lower, double upper,
+                                       int numBins)
+  {
+    std::vector<double> bins(numBins,0.);
+    const double width = (upper-lower)/numBins;
+    auto binOf = [&](double v) {
+      return width > 0. ? std::min(numBins-1,std::max(0,int((v-lower)/width))) : 0;
+    };
+    for (uint32_t k=0;k<keyCounts.size();k++) {
+      if (!keyCounts[k]) continue;
+      double lo, hi;
+      HistogramKeys<T>::range(k,lo,hi);
+      lo = std::max(lo,lower);
+      hi = std::min(hi,upper);
+      const int first = binOf(lo), last = binOf(hi);
+      if (first == last || hi <= lo) {
+        bins[first] += keyCounts[k];
+        continue;
+      }
+      for (int b=first;b<=last;b++) {
+        const double overlap
+          = std::min(hi,lower+(b+1)*width) - std::max(lo,lower+b*width);
+        bins[b] += keyCounts[k] * std::max(0.,overlap) / (hi-lo);
+      }
+    }
+    // round such that the counts still add up to the total
+    std::vector<uint64_t> histogram(numBins);
+    double sum = 0.;
+    uint64_t rounded = 0;
+    for (int b=0;b<numBins;b++) {
+      sum += bins[b];
+      const uint64_t total = uint64_t(sum+.5);
+      histogram[b] = total-rounded;
+      rounded = total;
+    }
+    return histogram;
+  }
+  
+  /*! copies 'numElements' D-wide elements from 'in' to 'out', in
+      parallel; if 'stats' is non-null also gathers per-component
+      min/max (and, for scalars, a histogram) of what gets copied,
+      one cache-sized chunk at a time, right after copying it */
+  template<typename T, int D>
+  void copyArrayData(T *out, const T *in, uint64_t numElements,
+                     ArrayStats *stats, int histogramBins)
+  {
+    if (!stats) {
+      parallel_for_blocked(numElements,(1<<20)/(sizeof(T)*D)+1,
+                           [&](size_t begin, size_t end) {
+                             memcpy(out+begin*D,in+begin*D,
+                                    (end-begin)*D*sizeof(T));
+                           });
+      return;
+    }
+    
+    typedef HistogramKeys<T> Keys;
+    const bool withHistogram = (D == 1 && histogramBins > 0);
+    // one set of partial results per block - and only a few blocks,
+    // since each block has its own histogram
+    const size_t numBlocks = std::min<size_t>(numWorkerThreads(),
+                                              numElements/(64*1024)+1);
+    const size_t blockSize = (numElements+numBlocks-1)/numBlocks;
+    struct Partial {
+      uint64_t numValid = 0;
+      T lower[D], upper[D];
+      bool any[D];
+      std::vector<uint64_t> keyCounts;
+    };
+    std::vector<Partial> partials(numBlocks);
+    parallel_for_blocked
+      (numElements,blockSize,
+       [&](size_t begin, size_t end) {
+         Partial &partial = partials[begin/blockSize];
+         for (int d=0;d<D;d++) partial.any[d] = false;
+         if (withHistogram)
+           partial.keyCounts.resize(Keys::numKeys,0);
+         const size_t chunkSize = (16*1024)/(sizeof(T)*D)+1;
+         for (size_t chunkBegin=begin;chunkBegin<end;chunkBegin+=chunkSize) {
+           const size_t chunkEnd = std::min(end,chunkBegin+chunkSize);
+           memcpy(out+chunkBegin*D,in+chunkBegin*D,
+                  (chunkEnd-chunkBegin)*D*sizeof(T));
+           for (size_t i=chunkBegin;i<chunkEnd;i++)
+             for (int d=0;d<D;d++) {
+               const T v = in[i*D+d];
+               if (!Keys::valid(v)) continue;
+               partial.numValid++;
+               if (!partial.any[d]) {
+                 partial.lower[d] = partial.upper[d] = v;
+                 partial.any[d] = true;
+               } else {
+                 partial.lower[d] = std::min(partial.lower[d],v);
+                 partial.upper[d] = std::max(partial.upper[d],v);
+               }
+               if (withHistogram)
+                 partial.keyCounts[Keys::key(v)]++;
+             }
+         }
+       });
+
+    // merge
+    stats->numComponents = D;
+    stats->numValid = 0;
+    bool any[D];
+    for (int d=0;d<D;d++) any[d] = false;
+    std::vector<uint64_t> keyCounts(withHistogram ? Keys::numKeys : 0,0);
+    for (auto &partial : partials) {
+      stats->numValid += partial.numValid;
+      for (int d=0;d<D;d++) {
+        if (!partial.any[d]) continue;
+        stats->lower[d] = any[d] ? std::min(stats->lower[d],double(partial.lower[d]))
+                                 : double(partial.lower[d]);
+        stats->upper[d] = any[d] ? std::max(stats->upper[d],double(partial.upper[d]))
+                                 : double(partial.upper[d]);
+        any[d] = true;
+      }
+      for (size_t k=0;k<partial.keyCounts.size();k++)
+        keyCounts[k] += partial.keyCounts[k];
+    }
+    if (withHistogram)
+      stats->histogram = rebinHistogram<T>(keyCounts,stats->lower[0],
+                                           stats->upper[0],histogramBins);
+  }
+  
   template<typename T, int D>
   anari::Array importArrayT(anari::Device device,
                             ANARIDataType anariType,
                             const py::buffer_info &info,
                             const py::buffer &buffer,
-                            uint64_t const nDims)
+                            uint64_t const nDims,
+                            uint64_t &numBytes,
+                            uint64_t *dims,
+                            ArrayStats *stats,
+                            int histogramBins)
   {
     py::array_t<T> asArray = py::cast<py::array_t<T>>(buffer);
     uint64_t numScalarsInArray = 1;
     for (int i=0;i<info.ndim;i++) {
       numScalarsInArray *= (int)info.shape[i];
     }
+    py::buffer_info buf = asArray.request();
     anari::Array handle = 0;
+    // nothing below touches any python objects; let other python
+    // threads run while we create and fill the array
+    py::gil_scoped_release noGIL;
     if (nDims == 1) {
-      handle = anari::newArray1D(device,anariType,numScalarsInArray/D);
+      dims[0] = numScalarsInArray/D;
+      handle = anari::newArray1D(device,anariType,dims[0]);
     } else if (nDims == 2) {
-      if (info.ndim == 2 && D == 1)
-        handle = anari::newArray2D(device,anariType,
-                                   info.shape[1],
-                                   info.shape[0]);
-      else if (info.ndim == 3 && info.shape[2] == D)
-        handle = anari::newArray2D(device,anariType,
-                                   info.shape[1],
-                                   info.shape[0]);
-      else
+      if ((info.ndim == 2 && D == 1) ||
+          (info.ndim == 3 && info.shape[2] == D)) {
+        dims[0] = info.shape[1];
+        dims[1] = info.shape[0];
+        handle = anari::newArray2D(device,anariType,dims[0],dims[1]);
+      } else
         throw std::runtime_error("cannot create array of this dim and shape!?");
     } else if (nDims == 3) {
-      if (info.ndim == 3 && D == 1)
-        // this is an array of scalars
-        handle = anari::newArray3D(device,anariType,
-                                   info.shape[2],
-                                   info.shape[1],
-                                   info.shape[0]);
-      else if (info.ndim == 4 && info.shape[3] == D)
-        handle = anari::newArray3D(device,anariType,
-                                   info.shape[2],
-                                   info.shape[1],
-                                   info.shape[0]);
-      else
+      // either an array of scalars, or one of D-wide vectors
+      if ((info.ndim == 3 && D == 1) ||
+          (info.ndim == 4 && info.shape[3] == D)) {
+        dims[0] = info.shape[2];
+        dims[1] = info.shape[1];
+        dims[2] = info.shape[0];
+        handle = anari::newArray3D(device,anariType,dims[0],dims[1],dims[2]);
+      } else
         throw std::runtime_error("cannot create array of this dim and shape!?");
     } else {
       throw std::runtime_error("invalid array dimensionality");
     }
     void *ptr = anariMapArray(device,handle);
-    auto buf = asArray.request();
-    const T *elems = (T*)buf.ptr;
-    ::memcpy(ptr,elems,numScalarsInArray*sizeof(T));
+    const T *elems = (const T*)buf.ptr;
+    numBytes = numScalarsInArray*sizeof(T);
+    copyArrayData<T,D>((T*)ptr,elems,numScalarsInArray/D,stats,histogramBins);
     anariUnmapArray(device,handle);
     return handle;
   }
@@ -74,44 +261,62 @@ namespace pynari {
                            anari::DataType type,
                            const py::buffer_info &info,
                            const py::buffer &buffer,
-                           int const nDims)
+                           int const nDims,
+                           uint64_t &numBytes,
+                           uint64_t *dims,
+                           ArrayStats *stats,
+                           int histogramBins)
   {
     switch (type) {
     case ANARI_FLOAT32:
-      return importArrayT<float,1>(device,ANARI_FLOAT32,info,buffer,nDims);
+      return importArrayT<float,1>(device,ANARI_FLOAT32,info,buffer,nDims,numBytes,dims,stats,histogramBins);
     case ANARI_FLOAT32_VEC2:
-      return importArrayT<float,2>(device,ANARI_FLOAT32_VEC2,info,buffer,nDims);
+      return importArrayT<float,2>(device,ANARI_FLOAT32_VEC2,info,buffer,nDims,numBytes,dims,stats,histogramBins);
     case ANARI_FLOAT32_VEC3:
-      return importArrayT<float,3>(device,ANARI_FLOAT32_VEC3,info,buffer,nDims);
+      return importArrayT<float,3>(device,ANARI_FLOAT32_VEC3,info,buffer,nDims,numBytes,dims,stats,histogramBins);
     case ANARI_FLOAT32_VEC4:
-      return importArrayT<float,4>(device,ANARI_FLOAT32_VEC4,info,buffer,nDims);
+      return importArrayT<float,4>(device,ANARI_FLOAT32_VEC4,info,buffer,nDims,numBytes,dims,stats,histogramBins);
       
     case ANARI_UINT32:
-      return importArrayT<uint32_t,1>(device,ANARI_UINT32,info,buffer,nDims);
+      return importArrayT<uint32_t,1>(device,ANARI_UINT32,info,buffer,nDims,numBytes,dims,stats,histogramBins);
     case ANARI_UINT32_VEC2:
-      return importArrayT<uint32_t,2>(device,ANARI_UINT32_VEC2,info,buffer,nDims);
+      return importArrayT<uint32_t,2>(device,ANARI_UINT32_VEC2,info,buffer,nDims,numBytes,dims,stats,histogramBins);
     case ANARI_UINT32_VEC3:
-      return importArrayT<uint32_t,3>(device,ANARI_UINT32_VEC3,info,buffer,nDims);
+      return importArrayT<uint32_t,3>(device,ANARI_UINT32_VEC3,info,buffer,nDims,numBytes,dims,stats,histogramBins);
     case ANARI_UINT32_VEC4:
-      return importArrayT<uint32_t,4>(device,ANARI_UINT32_VEC4,info,buffer,nDims);
+      return importArrayT<uint32_t,4>(device,ANARI_UINT32_VEC4,info,buffer,nDims,numBytes,dims,stats,histogramBins);
 
     case ANARI_UINT8:
-      return importArrayT<uint8_t,1>(device,ANARI_UINT8,info,buffer,nDims);
+      return importArrayT<uint8_t,1>(device,ANARI_UINT8,info,buffer,nDims,numBytes,dims,stats,histogramBins);
     case ANARI_UINT8_VEC2:
-      return importArrayT<uint8_t,2>(device,ANARI_UINT8_VEC2,info,buffer,nDims);
+      return importArrayT<uint8_t,2>(device,ANARI_UINT8_VEC2,info,buffer,nDims,numBytes,dims,stats,histogramBins);
     case ANARI_UINT8_VEC3:
-      return importArrayT<uint8_t,3>(device,ANARI_UINT8_VEC3,info,buffer,nDims);
+      return importArrayT<uint8_t,3>(device,ANARI_UINT8_VEC3,info,buffer,nDims,numBytes,dims,stats,histogramBins);
     case ANARI_UINT8_VEC4:
-      return importArrayT<uint8_t,4>(device,ANARI_UINT8_VEC4,info,buffer,nDims);
+      return importArrayT<uint8_t,4>(device,ANARI_UINT8_VEC4,info,buffer,nDims,numBytes,dims,stats,histogramBins);
+
+    case ANARI_UFIXED8:
+      return importArrayT<uint8_t,1>(device,ANARI_UFIXED8,info,buffer,nDims,numBytes,dims,stats,histogramBins);
+
+    case ANARI_UINT16:
+      return importArrayT<uint16_t,1>(device,ANARI_UINT16,info,buffer,nDims,numBytes,dims,stats,histogramBins);
+    case ANARI_UINT16_VEC2:
+      return importArrayT<uint16_t,2>(device,ANARI_UINT16_VEC2,info,buffer,nDims,numBytes,dims,stats,histogramBins);
+    case ANARI_UINT16_VEC3:
+      return importArrayT<uint16_t,3>(device,ANARI_UINT16_VEC3,info,buffer,nDims,numBytes,dims,stats,histogramBins);
+    case ANARI_UINT16_VEC4:
+      return importArrayT<uint16_t,4>(device,ANARI_UINT16_VEC4,info,buffer,nDims,numBytes,dims,stats,histogramBins);
+    case ANARI_UFIXED16:
+      return importArrayT<uint16_t,1>(device,ANARI_UFIXED16,info,buffer,nDims,numBytes,dims,stats,histogramBins);
 
     case ANARI_INT32:
-      return importArrayT<uint32_t,1>(device,ANARI_INT32,info,buffer,nDims);
+      return importArrayT<int32_t,1>(device,ANARI_INT32,info,buffer,nDims,numBytes,dims,stats,histogramBins);
     case ANARI_INT32_VEC2:
-      return importArrayT<uint32_t,2>(device,ANARI_INT32_VEC2,info,buffer,nDims);
+      return importArrayT<int32_t,2>(device,ANARI_INT32_VEC2,info,buffer,nDims,numBytes,dims,stats,histogramBins);
     case ANARI_INT32_VEC3:
-      return importArrayT<uint32_t,3>(device,ANARI_INT32_VEC3,info,buffer,nDims);
+      return importArrayT<int32_t,3>(device,ANARI_INT32_VEC3,info,buffer,nDims,numBytes,dims,stats,histogramBins);
     case ANARI_INT32_VEC4:
-      return importArrayT<uint32_t,4>(device,ANARI_INT32_VEC4,info,buffer,nDims);
+      return importArrayT<int32_t,4>(device,ANARI_INT32_VEC4,info,buffer,nDims,numBytes,dims,stats,histogramBins);
     default:
       throw std::runtime_error("un-implemented array type of "+std::to_string(type));
     }
@@ -120,14 +325,30 @@ namespace pynari {
   Array::Array(Device::SP device,
                int dims,
                anari::DataType type,
-               const py::buffer &buffer)
+               const py::buffer &buffer,
+               bool computeStats,
+               int histogramBins)
     : Object(device),
       nDims(dims),
       elementType(type),
       numObjects(0)
   {
     py::buffer_info info = buffer.request();
-    this->handle = importArray(device->handle,type,info,buffer,nDims);
+    if (computeStats)
+      stats = std::make_shared<ArrayStats>();
+    this->handle = importArray(device->handle,type,info,buffer,nDims,
+                               dataBytes,this->dims,
+                               stats.get(),histogramBins);
+    // fixed-point values are in [0,1] as far as the device is concerned
+    const double fixedScale
+      = type == ANARI_UFIXED8  ? 1./255.
+      : type == ANARI_UFIXED16 ? 1./65535.
+      : 1.;
+    if (stats && fixedScale != 1.)
+      for (int d=0;d<stats->numComponents;d++) {
+        stats->lower[d] *= fixedScale;
+        stats->upper[d] *= fixedScale;
+      }
     PYNARI_TRACK_LEAKS(std::cout << "@pynari: created DATA-array"
                        << std::endl);
   }
@@ -137,9 +358,11 @@ namespace pynari {
                const std::vector<Object::SP> &objects)
     : Object(device),
       elementType(type),
-      numObjects(objects.size())
+      numObjects(objects.size()),
+      objects(objects)
   {
     nDims = 1;
+    dims[0] = objects.size();
     anari::Array1D array
       = anari::newArray1D(device->handle,
 # if 1
@@ -149,6 +372,7 @@ namespace pynari {
 # endif
                           objects.size());
     this->handle = array;
+    dataBytes = objects.size()*sizeof(ANARIObject);
     // do we need to release here?
     assertThisObjectIsValid();
     std::vector<ANARIObject> anariObjects;
@@ -164,11 +388,143 @@ namespace pynari {
     anariUnmapArray(device->handle,array);
   }
 
+  Array::Array(Device::SP device,
+               anari::DataType type,
+               const void *data,
+               size_t count)
+    : Object(device),
+      nDims(1),
+      elementType(type),
+      numObjects(0)
+  {
+    size_t elemSize = sizeOfType(type);
+    if (elemSize == 0)
+      throw std::runtime_error("#pynari: cannot create native array of type "
+                               +to_string(type));
+    this->handle = anari::newArray1D(device->handle,type,count);
+    dims[0] = count;
+    dataBytes = count*elemSize;
+    void *ptr = anariMapArray(device->handle,handle);
+    ::memcpy(ptr,data,dataBytes);
+    anariUnmapArray(device->handle,handle);
+  }
+
+  /*! deleter for shared arrays: drops the reference that kept the
+      array's memory alive */
+  static void releaseKeepAlive(const void *userData, const void *)
+  {
+    delete (std::shared_ptr<void> *)userData;
+  }
+  
+  Array::Array(Device::SP device,
+               anari::DataType type,
+               const std::vector<uint64_t> &dims,
+               const void *sharedMemory,
+               std::shared_ptr<void> keepAlive)
+    : Object(device),
+      nDims((int)dims.size()),
+      elementType(type),
+      numObjects(0)
+  {
+    size_t elemSize = sizeOfType(type);
+    if (elemSize == 0)
+      throw std::runtime_error("#pynari: cannot create native array of type "
+                               +to_string(type));
+    if (nDims > 3)
+      throw std::runtime_error("invalid array dimensionality");
+    dataBytes = elemSize;
+    for (int d=0;d<nDims;d++) {
+      this->dims[d] = dims[d];
+      dataBytes *= dims[d];
+    }
+    
+    this->sharedMemory = sharedMemory;
+    this->keepAlive    = keepAlive;
+    ANARIMemoryDeleter deleter = nullptr;
+    void *userData = nullptr;
+    if (sharedMemory && keepAlive) {
+      deleter  = releaseKeepAlive;
+      userData = new std::shared_ptr<void>(keepAlive);
+    }
+    switch (nDims) {
+    case 1:
+      handle = anariNewArray1D(device->handle,sharedMemory,deleter,userData,
+                               type,dims[0]);
+      break;
+    case 2:
+      handle = anariNewArray2D(device->handle,sharedMemory,deleter,userData,
+                               type,dims[0],dims[1]);
+      break;
+    case 3:
+      handle = anariNewArray3D(device->handle,sharedMemory,deleter,userData,
+                               type,dims[0],dims[1],dims[2]);
+      break;
+    default:
+      delete (std::shared_ptr<void> *)userData;
+      throw std::runtime_error("invalid array dimensionality");
+    }
+  }
+
+  /*! the numpy dtype to read anari arrays of given type as, and
+      how many components each element has */
+  static py::dtype readDType(anari::DataType type, int &numComponents)
+  {
+    // vector types directly follow their scalar type in anari's enum
+    const struct { anari::DataType base; const char *dtype; } scalars[] = {
+      { ANARI_FLOAT32,  "float32" },
+      { ANARI_FLOAT64,  "float64" },
+      { ANARI_INT32,    "int32" },
+      { ANARI_UINT32,   "uint32" },
+      { ANARI_UINT8,    "uint8" },
+      { ANARI_UFIXED8,  "uint8" },
+      { ANARI_UINT16,   "uint16" },
+      { ANARI_UFIXED16, "uint16" },
+    };
+    for (auto &scalar : scalars)
+      if (type >= scalar.base && type < scalar.base+4) {
+        numComponents = type-scalar.base+1;
+        return py::dtype(scalar.dtype);
+      }
+    if (type == ANARI_FLOAT32_MAT4) {
+      numComponents = 16;
+      return py::dtype("float32");
+    }
+    throw std::runtime_error("#pynari: cannot read arrays of type "
+                             +to_string(type));
+  }
+  
+  py::object Array::read()
+  {
+    if (isObjectType(elementType)) {
+      py::list result;
+      for (auto &object : objects)
+        result.append(object ? py::cast(object) : py::none());
+      return std::move(result);
+    }
+
+    int numComponents = 1;
+    py::dtype dtype = readDType(elementType,numComponents);
+    std::vector<ssize_t> shape;
+    for (int d=nDims-1;d>=0;--d)
+      shape.push_back((ssize_t)dims[d]);
+    if (numComponents > 1)
+      shape.push_back(numComponents);
+    py::array result(dtype,shape);
+    if (sharedMemory)
+      memcpy(result.mutable_data(),sharedMemory,dataBytes);
+    else {
+      void *out = result.mutable_data();
+      py::gil_scoped_release noGIL;
+      const void *mapped = anariMapArray(device->handle,handle);
+      memcpy(out,mapped,dataBytes);
+      anariUnmapArray(device->handle,handle);
+    }
+    return std::move(result);
+  }
+
   Array::~Array()
   {
     PYNARI_TRACK_LEAKS(std::cout << "#pynari: RELEASING array "
                        << (int*)this << ":" << (int*)handle << std::endl);
-    anariRelease(device->handle,handle);
-    handle = {};
   }
 }
@@ -20,17 +20,58 @@
 
 namespace pynari {
 
+  /*! statistics over an array's data, gathered while it gets
+      imported: per-component min and max, and - for scalar arrays -
+      a histogram over [min,max]. NaN and inf values are skipped */
+  struct ArrayStats {
+    int numComponents = 1;
+    /*! number of elements (or, for vectors, components) that got
+        counted, ie, weren't NaN or inf */
+    uint64_t numValid = 0;
+    double   lower[4] = { 0, 0, 0, 0 };
+    double   upper[4] = { 0, 0, 0, 0 };
+    std::vector<uint64_t> histogram;
+  };
+  
   struct Array : public Object {
     typedef std::shared_ptr<Array> SP;
     
+    /*! imports given (python) buffer as a 'dims'-dimensional array;
+        with 'computeStats' also fills in this array's 'stats' (with
+        a histogram of 'histogramBins' bins), in the same pass that
+        copies the data */
     Array(Device::SP device, int dims,
           anari::DataType type,
-          const py::buffer &buffer);
+          const py::buffer &buffer,
+          bool computeStats = false,
+          int histogramBins = 256);
     Array(Device::SP device, anari::DataType type,
           const std::vector<Object::SP> &list);
+    /*! creates a 1D array of 'count' elements of given (non-object)
+        type, and copies its data from native memory - for arrays
+        that pynari computes itself. Does not need the GIL */
+    Array(Device::SP device, anari::DataType type,
+          const void *data, size_t count);
+    /*! creates a 1D, 2D, or 3D array of given (non-object) type and
+        dims. If 'sharedMemory' is given the array is a shared array
+        that points straight at that memory, which 'keepAlive' has to
+        keep valid until the device releases the array; otherwise
+        it's an (empty) managed array for the caller to map and
+        fill. Does not need the GIL */
+    Array(Device::SP device, anari::DataType type,
+          const std::vector<uint64_t> &dims,
+          const void *sharedMemory = nullptr,
+          std::shared_ptr<void> keepAlive = {});
     virtual ~Array();
     std::string toString() const override { return "pynari::Array"; }
 
+    /*! returns a copy of this array's contents - as a numpy array
+        shaped like the one it got created from (slowest dimension
+        first, with vector components as last dimension) for data
+        arrays, or as a list of objects for object arrays */
+    py::object read();
+    size_t numBytes() const override { return dataBytes; }
+
     ANARIDataType anariType() const override
     {
       switch (nDims) {
@@ -43,8 +84,24 @@ namespace pynari {
     
     /*! number of DIMENSIONS of this array, NOT the 'size' */
     int          nDims  = -1;
+    /*! number of elements in each dimension; only the first 'nDims'
+        are meaningful */
+    uint64_t     dims[3] = { 1, 1, 1 };
     anari::DataType const elementType;
     int numObjects = 0;
+    /*! for arrays of objects: the objects in this array */
+    std::vector<Object::SP> objects;
+    /*! size of the array's data, in bytes */
+    uint64_t dataBytes = 0;
+    /*! for shared arrays: the app memory the array points to, and
+        whatever keeps that memory valid */
+    const void           *sharedMemory = nullptr;
+    std::shared_ptr<void> keepAlive;
+    /*! bumped whenever this array's contents get rewritten in place
+        (eg, by a TransferFunction), so copies of it know to update */
+    uint64_t dataVersion = 0;
+    /*! statistics over the imported data, if those got asked for */
+    std::shared_ptr<ArrayStats> stats;
   };
 
 }
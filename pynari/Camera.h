@@ -29,6 +29,7 @@ namespace pynari {
 
     std::string toString() const override { return "pynari::Camera<"+type+">"; }
     ANARIDataType anariType() const override { return ANARI_CAMERA; }
+    std::string subtype() const override { return type; }
     
     const std::string type;
   };
@@ -0,0 +1,156 @@
+// ======================================================================== //
+// Copyright 2024++ Ingo Wald                                               //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "pynari/Clone.h"
+#include "pynari/Context.h"
+#include "pynari/Array.h"
+#include <cstring>
+
+namespace pynari {
+
+  void Cloner::share(const Object::SP &source)
+  {
+    Entry &entry = entries[source.get()];
+    entry.source = source;
+    entry.clone  = source;
+  }
+    
+  void Cloner::setOverrides(const Object::SP &source,
+                            const std::vector<Param> &params)
+  {
+    Entry &entry = entries[source.get()];
+    if (entry.source.lock() != source)
+      entry = Entry{ source, {}, 0, {} };
+    entry.overrides = params;
+  }
+  
+  void Cloner::beginPass()
+  {
+    ++currentPass;
+    for (auto it = entries.begin(); it != entries.end(); )
+      if (it->second.source.expired())
+        it = entries.erase(it);
+      else
+        ++it;
+  }
+  
+  Object::SP Cloner::cloneArray(Array *source)
+  {
+    if (isObjectType(source->elementType)) {
+      std::vector<Object::SP> elements;
+      for (auto &element : source->objects)
+        elements.push_back(clone(element));
+      return target->create<Array>(source->elementType,elements);
+    }
+      
+    std::vector<uint64_t> dims(source->dims,source->dims+source->nDims);
+    if (source->sharedMemory)
+      // memory that outlives both arrays anyway (eg, a mapped file)
+      // can be shared by both devices
+      return target->create<Array>(source->elementType,dims,
+                                   source->sharedMemory,
+                                   source->keepAlive);
+      
+    Array::SP copy = target->create<Array>(source->elementType,dims);
+    copyArrayData(source,copy.get());
+    return copy;
+  }
+
+  void Cloner::copyArrayData(Array *source, Array *copy)
+  {
+    anari::Device sourceDevice = source->device->handle;
+    const void *in  = anariMapArray(sourceDevice,source->handle);
+    void       *out = anariMapArray(target->device->handle,copy->handle);
+    memcpy(out,in,source->dataBytes);
+    anariUnmapArray(target->device->handle,copy->handle);
+    anariUnmapArray(sourceDevice,source->handle);
+  }
+    
+  Object::SP Cloner::clone(const Object::SP &source)
+  {
+    Entry &entry = entries[source.get()];
+    if (entry.source.lock() != source)
+      // new object, or one that happens to live where a dead one did
+      entry = Entry{ source, {}, 0, std::move(entry.overrides) };
+    if (entry.clone == source || entry.pass == currentPass)
+      return entry.clone;
+    if (entry.pass < 0)
+      throw std::runtime_error("#pynari: cloneTo: cycle in scene graph");
+    entry.pass = -1;
+    
+    // arrays only ever change by getting their data rewritten in
+    // place, so once cloned that's all that might need updating
+    Array *array = dynamic_cast<Array *>(source.get());
+    if (array && entry.clone) {
+      if (entry.dataVersion != array->dataVersion) {
+        std::lock_guard<std::mutex> lock(array->mutex);
+        copyArrayData(array,(Array *)entry.clone.get());
+        entry.dataVersion = array->dataVersion;
+      }
+      entry.pass = currentPass;
+      return entry.clone;
+    }
+    
+    std::vector<Param> params = source->getShadowParams();
+    for (auto &p : params) {
+      if (!isObjectType(p.type) || !p.object) continue;
+      if (!p.ref)
+        throw std::runtime_error("#pynari: cloneTo: parameter '"+p.name
+                                 +"' refers to an object that was not"
+                                 " created through pynari");
+      p.ref    = clone(p.ref);
+      p.object = p.ref->handle;
+    }
+
+    // (references into an unordered_map stay valid while children
+    // get added to it)
+    for (auto &o : entry.overrides) {
+      bool found = false;
+      for (auto &p : params)
+        if (p.name == o.name) { p = o; found = true; }
+      if (!found) params.push_back(o);
+    }
+    if (!entry.clone && array) {
+      std::lock_guard<std::mutex> lock(array->mutex);
+      entry.clone       = cloneArray(array);
+      entry.dataVersion = array->dataVersion;
+    } else if (!entry.clone)
+      entry.clone = target->newObject(source->anariType(),source->subtype());
+    Object::SP copy = entry.clone;
+    
+    for (auto &p : params)
+      copy->setParam(p.name.c_str(),p.type,p.ptr(),p.ref);
+    copy->commit();
+    entry.pass = currentPass;
+    return copy;
+  }
+  
+  Object::SP Context::cloneObject(const Object::SP &source)
+  {
+    if (!source)
+      throw std::runtime_error("#pynari: cloneTo: nothing to clone");
+    py::gil_scoped_release noGIL;
+    return Cloner(this).clone(source);
+  }
+  
+  Object::SP Object::cloneTo(const std::shared_ptr<Context> &target)
+  {
+    if (!target)
+      throw std::runtime_error("#pynari: cloneTo: no target device given");
+    return target->cloneObject(shared_from_this());
+  }
+  
+}
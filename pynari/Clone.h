@@ -0,0 +1,74 @@
+// ======================================================================== //
+// Copyright 2024++ Ingo Wald                                               //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include "pynari/Object.h"
+#include <unordered_map>
+
+namespace pynari {
+
+  struct Context;
+  struct Array;
+  
+  /*! re-creates object graphs on another context's device, children
+      before parents. The cloner remembers what it cloned, so cloning
+      the same graph again only replays parameters that changed since
+      (which the target objects' shadow parameter caches elide
+      otherwise), and only clones objects that are new - this is how
+      scenes get kept in sync with other devices */
+  struct Cloner {
+    Cloner(Context *target) : target(target) {}
+
+    /*! returns the clone of 'source', creating it or bringing it up
+        to date with 'source' as needed. Must be called with the GIL
+        released */
+    Object::SP clone(const Object::SP &source);
+
+    /*! have 'clone(source)' return 'source' itself, without looking
+        at anything below it - for objects that are already on the
+        target device */
+    void share(const Object::SP &source);
+    
+    /*! params to set on the clone of 'source' instead of what
+        'source' has them set to */
+    void setOverrides(const Object::SP &source, const std::vector<Param> &params);
+
+    /*! start a new pass over the source graph: each object gets
+        brought up to date at most once per pass, and clones whose
+        source objects have died get dropped */
+    void beginPass();
+    
+    Context *const target;
+  private:
+    Object::SP cloneArray(Array *source);
+    void copyArrayData(Array *source, Array *copy);
+    
+    struct Entry {
+      std::weak_ptr<Object> source;
+      Object::SP            clone;
+      /*! pass in which this entry was last brought up to date; -1
+          while that is in progress */
+      int64_t               pass = 0;
+      std::vector<Param>    overrides;
+      /*! for arrays: the source's dataVersion when it was copied */
+      uint64_t              dataVersion = 0;
+    };
+    std::unordered_map<Object *,Entry> entries;
+    int64_t currentPass = 1;
+  };
+  
+}
@@ -125,6 +125,18 @@ namespace pynari {
       = std::make_shared<Device>(createDevice(explicitLibName,subName),this);
   }
     
+  Context::Context(const std::vector<std::string> &libNames,
+                   const std::string &subName)
+  {
+    if (libNames.empty())
+      throw std::runtime_error("#pynari: need at least one library to"
+                               " create a device");
+    this->device
+      = std::make_shared<Device>(createDevice(libNames[0],subName),this);
+    for (size_t i=1;i<libNames.size();i++)
+      workers.push_back(std::make_shared<Context>(libNames[i],subName));
+  }
+    
   Context::~Context()
   {
     PYNARI_TRACK_LEAKS(std::cout << "#pynari: ~Context is dying" << std::endl);
@@ -143,80 +155,123 @@ namespace pynari {
   std::shared_ptr<World>
   Context::newWorld()
   {
-    return std::make_shared<World>(device);
+    return create<World>();
   }
   
   std::shared_ptr<Frame>
   Context::newFrame()
   {
-    return std::make_shared<Frame>(device);
+    return create<Frame>();
   }
   
   std::shared_ptr<Geometry>
   Context::newGeometry(const std::string &type)
   {
-    return std::make_shared<Geometry>(device,type);
+    return create<Geometry>(type);
   }
   
   std::shared_ptr<Instance>
   Context::newInstance(const std::string &type)
   {
-    return std::make_shared<Instance>(device,type);
+    return create<Instance>(type);
   }
   
   std::shared_ptr<Renderer>
   Context::newRenderer(const std::string &type)
   {
-    return std::make_shared<Renderer>(device,type);
+    return create<Renderer>(type);
+  }
+  
+  std::shared_ptr<InstanceArray>
+  Context::newInstances(const std::shared_ptr<Group> &group,
+                        const py::object &_transforms)
+  {
+    if (!group)
+      throw std::runtime_error("#pynari: newInstances() needs a group");
+    std::vector<math::mat4> transforms = decodeTransforms(_transforms);
+
+    py::gil_scoped_release noGIL;
+    std::vector<Object::SP> instances(transforms.size());
+    for (size_t i=0;i<transforms.size();i++) {
+      Instance::SP inst = create<Instance>("transform");
+      inst->setParam("group",ANARI_GROUP,&group->handle,group);
+      inst->setParam("transform",ANARI_FLOAT32_MAT4,&transforms[i]);
+      inst->commit();
+      instances[i] = inst;
+    }
+    return create<InstanceArray>(instances);
   }
   
   std::shared_ptr<Camera>
   Context::newCamera(const std::string &type)
   {
-    return std::make_shared<Camera>(device,type);
+    return create<Camera>(type);
   }
   
   std::shared_ptr<Surface>
   Context::newSurface()
   {
-    return std::make_shared<Surface>(device);
+    return create<Surface>();
   }
   
   std::shared_ptr<Volume>
   Context::newVolume(const std::string &type)
   {
-    return std::make_shared<Volume>(device,type);
+    return create<Volume>(type);
   }
   
   std::shared_ptr<SpatialField>
   Context::newSpatialField(const std::string &type)
   {
-    return std::make_shared<SpatialField>(device,type);
+    return create<SpatialField>(type);
   }
   
   std::shared_ptr<Material>
   Context::newMaterial(const std::string &type)
   {
-    return std::make_shared<Material>(device,type);
+    return create<Material>(type);
   }
   
   std::shared_ptr<Sampler>
   Context::newSampler(const std::string &type)
   {
-    return std::make_shared<Sampler>(device,type);
+    return create<Sampler>(type);
   }
  
   std::shared_ptr<Light>
   Context::newLight(const std::string &type)
   {
-    return std::make_shared<Light>(device,type);
+    return create<Light>(type);
   }
  
+  Object::SP
+  Context::newObject(anari::DataType type, const std::string &subtype)
+  {
+    switch (type) {
+    case ANARI_WORLD:         return create<World>();
+    case ANARI_GROUP:         return create<Group>();
+    case ANARI_SURFACE:       return create<Surface>();
+    case ANARI_FRAME:         return create<Frame>();
+    case ANARI_INSTANCE:      return create<Instance>(subtype);
+    case ANARI_GEOMETRY:      return create<Geometry>(subtype);
+    case ANARI_MATERIAL:      return create<Material>(subtype);
+    case ANARI_SAMPLER:       return create<Sampler>(subtype);
+    case ANARI_SPATIAL_FIELD: return create<SpatialField>(subtype);
+    case ANARI_VOLUME:        return create<Volume>(subtype);
+    case ANARI_LIGHT:         return create<Light>(subtype);
+    case ANARI_CAMERA:        return create<Camera>(subtype);
+    case ANARI_RENDERER:      return create<Renderer>(subtype);
+    default:
+      throw std::runtime_error("#pynari: cannot create object of type "
+                               +to_string(type));
+    }
+  }
+  
   std::shared_ptr<Array>
   Context::newArray_objects(int type, const py::list &list)
   {
-    static bool warned = false;
-    if (warned == false) {
+    static std::atomic<bool> warned(false);
+    if (warned.exchange(true) == false) {
       std::cout
         << "#pynari: this python app using pynari just called Object::newArray()\n"
         << "#pynari: due to some changes in the ANARI SDK these calls are now (starting\n"
@@ -227,7 +282,6 @@ namespace pynari {
         << "#pynari: the better way would be for the app to swtich to the new\n"
         << "#pynari: intended behavior.\n"
         ;
-      warned = true;
     }
     return newArray1D_objects(type,list);
   }
@@ -241,20 +295,22 @@ namespace pynari {
       assert(object);
       objects.push_back(object);
     }
-    return std::make_shared<Array>(device,(anari::DataType)type,objects);
+    return create<Array>((anari::DataType)type,objects);
   }
   
   std::shared_ptr<Group>
   Context::newGroup(const py::list &list)
   {
-    return std::make_shared<Group>(device,list);
+    std::shared_ptr<Group> group = create<Group>(list);
+    group->commit();
+    return group;
   }
 
   std::shared_ptr<Array>
   Context::newArray(int type, const py::buffer &buffer)
   {
-    static bool warned = false;
-    if (warned == false) {
+    static std::atomic<bool> warned(false);
+    if (warned.exchange(true) == false) {
       std::cout
         << "#pynari: this python app using pynari just called Object::newArray()\n"
         << "#pynari: due to some changes in the ANARI SDK these calls are now (starting\n"
@@ -265,27 +321,85 @@ namespace pynari {
         << "#pynari: the better way would be for the app to swtich to the new\n"
         << "#pynari: intended behavior.\n"
         ;
-      warned = true;
     }
     return newArray1D(type,buffer);
   }
 
   std::shared_ptr<Array>
-  Context::newArray1D(int type, const py::buffer &buffer)
+  Context::newArray1D(int type, const py::buffer &buffer,
+                       bool stats, int histogramBins)
   {
-    return std::make_shared<Array>(device,1,(anari::DataType)type,buffer);
+    return create<Array>(1,(anari::DataType)type,buffer,
+                         stats,histogramBins);
   }
   
   std::shared_ptr<Array>
-  Context::newArray2D(int type, const py::buffer &buffer)
+  Context::newArray2D(int type, const py::buffer &buffer,
+                       bool stats, int histogramBins)
   {
-    return std::make_shared<Array>(device,2,(anari::DataType)type,buffer);
+    return create<Array>(2,(anari::DataType)type,buffer,
+                         stats,histogramBins);
   }
   
   std::shared_ptr<Array>
-  Context::newArray3D(int type, const py::buffer &buffer)
+  Context::newArray3D(int type, const py::buffer &buffer,
+                       bool stats, int histogramBins)
+  {
+    return create<Array>(3,(anari::DataType)type,buffer,
+                         stats,histogramBins);
+  }
+  
+  void Context::addFrameHook(const std::shared_ptr<FrameHook> &hook)
   {
-    return std::make_shared<Array>(device,3,(anari::DataType)type,buffer);
+    std::lock_guard<std::mutex> lock(frameHooksMutex);
+    frameHooks.push_back(hook);
+  }
+
+  void Context::runFrameHooks()
+  {
+    std::vector<std::shared_ptr<FrameHook>> live;
+    {
+      std::lock_guard<std::mutex> lock(frameHooksMutex);
+      size_t numLive = 0;
+      for (auto &weak : frameHooks)
+        if (std::shared_ptr<FrameHook> hook = weak.lock()) {
+          live.push_back(hook);
+          frameHooks[numLive++] = weak;
+        }
+      frameHooks.resize(numLive);
+    }
+    for (auto &hook : live)
+      hook->beforeFrame();
+  }
+  
+  Transaction::SP Context::transaction()
+  {
+    return std::make_shared<Transaction>(device);
+  }
+  
+  std::map<std::string,uint64_t> Context::getStats()
+  {
+    std::map<std::string,uint64_t> ret;
+    ret["paramsSet"]     = device->stats.paramsSet;
+    ret["paramsElided"]  = device->stats.paramsElided;
+    ret["commits"]       = device->stats.commits;
+    ret["commitsElided"] = device->stats.commitsElided;
+    ret["framesRendered"]     = device->stats.framesRendered;
+    ret["renderMicroseconds"] = device->stats.renderMicroseconds;
+    return ret;
+  }
+  
+  std::map<std::string,std::map<std::string,int64_t>>
+  Context::getLiveObjectStats()
+  {
+    std::map<std::string,std::map<std::string,int64_t>> ret;
+    for (auto it : device->registry.getTypeStats()) {
+      std::string typeName
+        = it.first == ANARI_UNKNOWN ? "ANARI_UNKNOWN" : to_string(it.first);
+      ret[typeName]["count"] = it.second.count;
+      ret[typeName]["bytes"] = it.second.numBytes;
+    }
+    return ret;
   }
   
   std::shared_ptr<Context> createContext(const std::string &libName,
@@ -294,6 +408,12 @@ namespace pynari {
     return std::make_shared<Context>(libName,subName);
   }
 
+  std::shared_ptr<Context> createMultiContext(const std::vector<std::string> &libNames,
+                                              const std::string &subName)
+  {
+    return std::make_shared<Context>(libNames,subName);
+  }
+
   /*! allows to query whether the user has already explicitly called
     contextDestroy. if so, any releases of handles are no longer
     valid because whatever they may have pointed to inside the
@@ -390,6 +510,9 @@ namespace pynari {
     
     device->release();
     device = nullptr;
+    for (auto &worker : workers)
+      worker->destroy();
+    workers.clear();
   }
 
   void Context::set_ulong(const char *name,
@@ -28,6 +28,7 @@ namespace pynari {
   struct Frame;
   struct Group;
   struct Instance;
+  struct InstanceArray;
   struct Geometry;
   struct Array;
   struct Material;
@@ -35,39 +36,169 @@ namespace pynari {
   struct SpatialField;
   struct Volume;
   struct Sampler;
+  struct SpatialFieldPyramid;
+  struct TimeSeriesField;
+
+  /*! native helpers that need to do something right before each
+      frame that gets rendered on their device (such as switching a
+      volume's field), see Context::addFrameHook() */
+  struct FrameHook {
+    virtual ~FrameHook() = default;
+    virtual void beforeFrame() = 0;
+  };
   
   struct Context {
     typedef std::shared_ptr<Context> SP;
     
     Context(const std::string &libName, const std::string &subName);
+    /*! a multi-device context: the first library's device is this
+        context's own device, on which all objects get created; each
+        further library gets a worker context, to which frames
+        rendered on this context get mirrored (see SortFirst) */
+    Context(const std::vector<std::string> &libNames, const std::string &subName);
     
     virtual ~Context();
 
     static SP create(const std::string &libName, const std::string &devName);
 
+    /*! creates a new pynari object on this context's device, and
+        registers it with that device's object registry - all pynari
+        objects have to get created through this */
+    template<typename T, typename... Args>
+    std::shared_ptr<T> create(Args&&... args)
+    {
+      std::shared_ptr<T> object
+        = std::make_shared<T>(device,std::forward<Args>(args)...);
+      device->registry.add(object.get());
+      return object;
+    }
+
     std::shared_ptr<World> newWorld();
+    /*! creates a (non-array) object of given anari type and subtype,
+        for native code that only knows those at runtime. Does not
+        need the GIL */
+    Object::SP newObject(anari::DataType type, const std::string &subtype);
     std::shared_ptr<Group> newGroup(const py::list &list);
     // std::shared_ptr<Group> newGroup(const py::list &list);
     std::shared_ptr<Frame> newFrame();
     std::shared_ptr<Geometry> newGeometry(const std::string &type); 
     std::shared_ptr<Instance> newInstance(const std::string &type);
+    /*! creates one 'transform' instance of given group for each of
+        the given (N,3,4) or (N,4,4) transforms, and returns them as
+        a single array of instances */
+    std::shared_ptr<InstanceArray> newInstances(const std::shared_ptr<Group> &group,
+                                                const py::object &transforms);
     std::shared_ptr<Camera> newCamera(const std::string &type);
     std::shared_ptr<Renderer> newRenderer(const std::string &type);
     std::shared_ptr<Surface> newSurface();
     std::shared_ptr<SpatialField> newSpatialField(const std::string &type);
     std::shared_ptr<Volume> newVolume(const std::string &type);
+    /*! builds a multi-resolution 'structuredRegular' field from
+        given (nz,ny,nx) data, with 'levels' levels, each 2x coarser
+        than the one before it (see SpatialFieldPyramid) */
+    std::shared_ptr<SpatialFieldPyramid>
+    newSpatialFieldPyramid(const py::buffer &data,
+                           int levels,
+                           const std::string &filter,
+                           const std::tuple<float,float,float> &origin,
+                           const std::tuple<float,float,float> &spacing);
+    /*! creates a 'structuredRegular' field that plays back a series
+        of time steps, prefetched in the background (see
+        TimeSeriesField) */
+    std::shared_ptr<TimeSeriesField>
+    newTimeSeriesField(const py::object &source,
+                       const std::tuple<uint64_t,uint64_t,uint64_t> &dims,
+                       const std::string &dtype,
+                       int numSteps,
+                       int prefetch,
+                       uint64_t memoryBudget,
+                       const std::tuple<float,float,float> &origin,
+                       const std::tuple<float,float,float> &spacing);
     std::shared_ptr<Sampler> newSampler(const std::string &type);
     std::shared_ptr<Array> newArray(int type, const py::buffer &buffer);
-    std::shared_ptr<Array> newArray1D(int type, const py::buffer &buffer);
-    std::shared_ptr<Array> newArray2D(int type, const py::buffer &buffer);
-    std::shared_ptr<Array> newArray3D(int type, const py::buffer &buffer);
+    /*! imports given buffer as a 1D, 2D, or 3D array; with 'stats',
+        also computes the array's ArrayStats while copying */
+    std::shared_ptr<Array> newArray1D(int type, const py::buffer &buffer,
+                                      bool stats = false,
+                                      int histogramBins = 256);
+    std::shared_ptr<Array> newArray2D(int type, const py::buffer &buffer,
+                                      bool stats = false,
+                                      int histogramBins = 256);
+    std::shared_ptr<Array> newArray3D(int type, const py::buffer &buffer,
+                                      bool stats = false,
+                                      int histogramBins = 256);
+    /*! quantizes a (nz,ny,nx) array of scalars to 'bits' (8 or 16)
+        bits over the given value range (or, if 'range' is None, the
+        data's min and max), and uploads it as a UFIXED8/UFIXED16
+        array. Returns a tuple of that array and the (lo,hi) range
+        that 0 and 1 in the quantized data correspond to */
+    py::tuple newArray3DQuantized(const py::buffer &data,
+                                  int bits,
+                                  const py::object &range);
     std::shared_ptr<Array> newArray_objects(int type,
                                             const py::list &list); 
     std::shared_ptr<Array> newArray1D_objects(int type,
                                             const py::list &list);
     std::shared_ptr<Material> newMaterial(const std::string &type);
+    /*! loads all arrays in a numpy .npz archive (or a single .npy
+        file), and returns them as a dict of pynari arrays, keyed by
+        name. Headers get parsed natively, compressed members get
+        inflated in parallel, and 'types' can map member names to the
+        anari type to load them as (default: float32 for floats,
+        int32/uint32 for (wider) ints, vector types if the last
+        dimension is 2, 3, or 4) */
+    py::dict loadArrays(const std::string &fileName, const py::dict &types);
+    /*! loads a float grid (given by name or index, or the first
+        float grid if None) from an uncompressed NanoVDB (.nvdb) file. If
+        'sparse' is true - or None and the device supports them - it
+        becomes a 'nanovdb' spatial field that uses the grid straight
+        out of the memory-mapped file; otherwise the grid's active
+        bounding box gets densified, in parallel, into a
+        'structuredRegular' field */
+    std::shared_ptr<SpatialField> loadNanoVDB(const std::string &fileName,
+                                              const py::object &grid,
+                                              const py::object &sparse);
+    /*! writes the whole object graph reachable from 'root' (usually
+        a world) - objects, their parameters, and array data - to a
+        binary .pnsc scene file */
+    void saveScene(const Object::SP &root, const std::string &fileName);
+    /*! rebuilds a scene written by saveScene(), and returns its root
+        object. Array data gets shared straight out of the
+        memory-mapped file rather than copied */
+    Object::SP loadScene(const std::string &fileName);
+    /*! re-creates given object - and everything it refers to,
+        possibly on another device - on this context's device, and
+        returns the copy */
+    Object::SP cloneObject(const Object::SP &source);
     std::shared_ptr<Light> newLight(const std::string &type);
 
+    /*! creates a whole set of spheres in one call: spheres get binned
+        by material, and each material that is used by any sphere
+        gets a single 'sphere' geometry (with per-sphere radius and
+        color, if specified) and surface. Without any materials, all
+        spheres use a single 'matte' one. Returns the list of those
+        surfaces. */
+    py::list newSphereSet(const py::buffer &positions,
+                          const py::object &radii,
+                          const py::object &colors,
+                          const py::object &materialIDs,
+                          const py::list &materials);
+
+    /*! create a transaction object for `with device.transaction():`
+        - all commits within that block get deferred, deduplicated,
+        and issued once (in dependency order) when the block exits */
+    Transaction::SP transaction();
+    
+    /*! returns a dictionary of pynari-side counters, such as how
+        many parameter sets and commits got elided because they
+        would not have changed anything */
+    std::map<std::string,uint64_t> getStats();
+
+    /*! returns, for each anari object type that has any live objects
+        on this device, how many such objects there are ('count'),
+        and how much array memory they hold ('bytes') */
+    std::map<std::string,std::map<std::string,int64_t>> getLiveObjectStats();
+    
     std::vector<std::string> getObjectSubtypes(int type);
     
     std::map<std::string/*desc*/,py::object>
@@ -91,6 +222,12 @@ namespace pynari {
                    uint64_t v);
     void commit();
 
+    /*! have given hook's beforeFrame() get called for every frame
+        rendered on this context, for as long as the hook lives */
+    void addFrameHook(const std::shared_ptr<FrameHook> &hook);
+    /*! calls beforeFrame() on all live frame hooks */
+    void runFrameHooks();
+
 #ifdef NDEBUG
     bool verbose = false;
 #else
@@ -98,9 +235,17 @@ namespace pynari {
 #endif
     
     Device::SP device;
-    std::mutex mutex;
+    /*! for multi-device contexts: the other devices' contexts */
+    std::vector<SP> workers;
+    std::vector<std::weak_ptr<FrameHook>> frameHooks;
+    std::mutex frameHooksMutex;
   };
 
   std::shared_ptr<Context> createContext(const std::string &libName,
 					 const std::string &devName="default");
+  /*! creates a multi-device context, with one device for each of the
+      given libraries; frames rendered on it get split across all of
+      them */
+  std::shared_ptr<Context> createMultiContext(const std::vector<std::string> &libNames,
+                                              const std::string &devName="default");
 }
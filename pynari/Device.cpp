@@ -17,6 +17,7 @@
 #include "pynari/Device.h"
 #include "pynari/Object.h"
 #include "pynari/Context.h"
+#include <algorithm>
 
 namespace pynari {
 
@@ -37,13 +38,17 @@ namespace pynari {
 
     // make sure to release all objects _before_ the device itself
     // gets released
-    std::set<Object *> copyOfCurrentObjects
-      = listOfAllObjectsCreatedOnThisDevice;
+    std::vector<Object::SP> currentObjects = registry.removeAll();
     if (context->verbose)
       std::cout << "#pynari: device being released - releasing "
-                << copyOfCurrentObjects.size() << " owned handles" << std::endl;
-    for (Object *obj : copyOfCurrentObjects)
+                << currentObjects.size() << " owned handles" << std::endl;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      deferredCommits.clear();
+    }
+    for (auto &obj : currentObjects)
       obj->release();
+    currentObjects.clear();
 
     // and finally, release the device itself
     if (context->verbose)
@@ -52,4 +57,92 @@ namespace pynari {
     handle = nullptr;
   }
   
+  /*! order in which objects get committed when closing a
+      transaction - anything that may get referenced by another
+      object has to get committed before that other object */
+  static int commitOrder(ANARIDataType type)
+  {
+    switch (type) {
+    case ANARI_ARRAY:
+    case ANARI_ARRAY1D:
+    case ANARI_ARRAY2D:
+    case ANARI_ARRAY3D:
+      return 0;
+    case ANARI_SAMPLER:
+    case ANARI_SPATIAL_FIELD:
+      return 1;
+    case ANARI_GEOMETRY:
+    case ANARI_MATERIAL:
+      return 2;
+    case ANARI_SURFACE:
+    case ANARI_VOLUME:
+    case ANARI_LIGHT:
+      return 3;
+    case ANARI_GROUP:
+      return 4;
+    case ANARI_INSTANCE:
+      return 5;
+    case ANARI_WORLD:
+      return 6;
+    default:
+      // cameras, renderers, frames
+      return 7;
+    }
+  }
+  
+  void Device::beginTransaction()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    transactionDepth++;
+  }
+  
+  void Device::endTransaction()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (transactionDepth <= 0)
+        throw std::runtime_error("#pynari: closing a transaction that was never opened");
+      if (--transactionDepth > 0)
+        return;
+    }
+    flushDeferredCommits();
+  }
+  
+  bool Device::deferCommit(Object *object)
+  {
+    // note: caller holds the object's lock
+    std::lock_guard<std::mutex> lock(mutex);
+    // re-check under the lock - another thread may have closed the
+    // last transaction (and flushed) since the caller looked
+    if (transactionDepth <= 0)
+      return false;
+    if (object->commitDeferred)
+      return true;
+    object->commitDeferred = true;
+    deferredCommits.push_back(object->shared_from_this());
+    return true;
+  }
+  
+  void Device::flushDeferredCommits()
+  {
+    std::vector<Object::SP> objects;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      objects.swap(deferredCommits);
+    }
+    std::stable_sort(objects.begin(),objects.end(),
+                     [](const Object::SP &a, const Object::SP &b)
+                     { return commitOrder(a->anariType())
+                         < commitOrder(b->anariType()); });
+    for (auto &obj : objects) {
+      std::lock_guard<std::mutex> lock(obj->mutex);
+      obj->commitDeferred = false;
+      // object may have gotten released while the transaction was open
+      if (!obj->handle || !handle) continue;
+      anariCommitParameters(handle,obj->handle);
+      obj->paramsChanged = false;
+      stats.commits++;
+    }
+  }
+  
 }
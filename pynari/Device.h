@@ -17,7 +17,7 @@
 #pragma once
 
 #include "pynari/common.h"
-#include <set>
+#include "pynari/ObjectRegistry.h"
 
 #define PYNARI_TRACK_LEAKS(a) /* nothing */
 
@@ -48,10 +48,68 @@ namespace pynari {
         has created */
     void release();
 
-    std::set<Object*> listOfAllObjectsCreatedOnThisDevice;
+    /*! open a new (possibly nested) transaction; while any
+        transaction is open, all object commits on this device get
+        deferred until the outermost transaction gets closed */
+    void beginTransaction();
+    
+    /*! close a transaction; if this was the outermost one this will
+        issue all commits that got deferred while it was open */
+    void endTransaction();
+
+    /*! defer committing given object until the current transaction
+        closes; each object gets committed at most once, no matter
+        how often it got committed during the transaction. Returns
+        false (and defers nothing) if no transaction is open, in
+        which case the caller has to commit right away */
+    bool deferCommit(Object *object);
+
+    /*! issue all currently deferred commits, in dependency order
+        (arrays first, then geometries, surfaces, groups, worlds,
+        etc) */
+    void flushDeferredCommits();
+
+    /*! all live objects created on this device */
+    ObjectRegistry registry;
+
+    /*! counters for how many parameter sets and commits actually
+        got passed to anari, and how many got elided by the shadow
+        parameter cache, and how many frames got rendered and how
+        long that took (in total, wall clock); see
+        Context::getStats() */
+    struct {
+      std::atomic<uint64_t> paramsSet     { 0 };
+      std::atomic<uint64_t> paramsElided  { 0 };
+      std::atomic<uint64_t> commits       { 0 };
+      std::atomic<uint64_t> commitsElided { 0 };
+      std::atomic<uint64_t> framesRendered     { 0 };
+      std::atomic<uint64_t> renderMicroseconds { 0 };
+    } stats;
+
+    /*! protects the transaction state below; objects lock their own
+        mutex before this one, never the other way around */
+    std::mutex mutex;
+    
+    /*! number of currently open transactions */
+    std::atomic<int> transactionDepth { 0 };
+    /*! objects whose commits got deferred during the current
+        transaction, in the order they were first committed */
+    std::vector<std::shared_ptr<Object>> deferredCommits;
     
     anari::Device handle = 0;
     Context *const context;
   };
 
+  /*! python-side handle for a device transaction, to be used as
+      `with device.transaction(): ...` */
+  struct Transaction {
+    typedef std::shared_ptr<Transaction> SP;
+    Transaction(Device::SP device) : device(device) {}
+    
+    void enter() { device->beginTransaction(); }
+    void exit()  { device->endTransaction(); }
+    
+    Device::SP device;
+  };
+
 }
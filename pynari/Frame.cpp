@@ -15,6 +15,9 @@
 // ======================================================================== //
 
 #include "pynari/Frame.h"
+#include "pynari/Context.h"
+#include "pynari/SortFirst.h"
+#include <chrono>
 #if PYNARI_HAVE_CUDA
 # include <cuda_runtime.h>
 #endif
@@ -25,18 +28,58 @@ namespace pynari {
     : Object(device)
   {
     handle = anari::newObject<anari::Frame>(device->handle);
-    anari::setParameter(device->handle, handle, "channel.color",
-                        (anari::DataType)ANARI_UFIXED8_RGBA_SRGB);
+    setParam("channel.color",(anari::DataType)ANARI_UFIXED8_RGBA_SRGB);
   }
 
   void Frame::render()
   {
+    const auto begin = std::chrono::steady_clock::now();
+    renderFrame();
+    const auto end = std::chrono::steady_clock::now();
+    device->stats.framesRendered++;
+    device->stats.renderMicroseconds
+      += std::chrono::duration_cast<std::chrono::microseconds>(end-begin).count();
+  }
+  
+  void Frame::renderFrame()
+  {
+    // eg, bound field pyramids pick their level based on whether
+    // the camera moved since the last frame
+    device->context->runFrameHooks();
+    
+    // rendering inside an open transaction: make sure whatever
+    // commits got deferred so far are visible to this frame
+    device->flushDeferredCommits();
+
+    // on a multi-device context, all devices render a part of this
+    // frame. This can't hold the frame's lock, because mirroring the
+    // frame to the other devices needs to read its parameters
+    std::shared_ptr<SortFirst> multi;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (!sortFirst && !device->context->workers.empty())
+        sortFirst = std::make_shared<SortFirst>(this);
+      multi = sortFirst;
+    }
+    if (multi) {
+      std::lock_guard<std::mutex> lock(multi->mutex);
+      multi->render();
+      return;
+    }
+    renderOnThisDevice();
+  }
+
+  void Frame::renderOnThisDevice()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
     anariRenderFrame(device->handle, (ANARIFrame)handle);
     anariFrameReady(device->handle, (ANARIFrame)handle, ANARI_WAIT);
   }
 
   uint64_t Frame::map(const std::string &channel)
   {
+    if (sortFirst && channel == "channel.color")
+      return (uint64_t)sortFirst->composite.data();
     ANARIDataType pixelType;
     uint32_t width, height;
     const void *ptr = anariMapFrame(device->handle, (ANARIFrame)handle,
@@ -46,6 +89,8 @@ namespace pynari {
   
   void Frame::unmap(const std::string &channel)
   {
+    if (sortFirst && channel == "channel.color")
+      return;
     anariUnmapFrame(device->handle, (ANARIFrame)handle, channel.c_str());
   }
 
@@ -56,10 +101,17 @@ namespace pynari {
     void *destPtr = (void *)devicePtr;
     uint32_t width, height;
     ANARIDataType pixelType;
-    const void *srcPtr
-      = anariMapFrame(device->handle,(ANARIFrame)this->handle,
-                      channel.c_str(),
-                      &width,&height,&pixelType);
+    const void *srcPtr;
+    if (sortFirst && channel == "channel.color") {
+      srcPtr    = sortFirst->composite.data();
+      width     = sortFirst->width;
+      height    = sortFirst->height;
+      pixelType = sortFirst->pixelType;
+    } else
+      srcPtr
+        = anariMapFrame(device->handle,(ANARIFrame)this->handle,
+                        channel.c_str(),
+                        &width,&height,&pixelType);
 
     if (pixelType == ANARI_UFIXED8_VEC4 ||
         pixelType == ANARI_UFIXED8_RGBA_SRGB)
@@ -72,24 +124,78 @@ namespace pynari {
          "'ANARI_UFIXED8_RGBA_SRGB'");
     
     cudaMemcpy(destPtr,srcPtr,numBytes,cudaMemcpyDefault);
-    anariUnmapFrame(device->handle,(ANARIFrame)handle,channel.c_str());
+    if (!sortFirst || channel != "channel.color")
+      anariUnmapFrame(device->handle,(ANARIFrame)handle,channel.c_str());
 #else
     throw std::runtime_error("pnari::Frame::readGPU() requires building with CUDA support");
 #endif
   }
   
+  void Frame::setPostProcess(float exposure,
+                             const std::string &tonemap,
+                             const py::object &gamma,
+                             bool quantize,
+                             bool dither)
+  {
+    PostProcess::ToneMap toneMap;
+    if (tonemap == "none")
+      toneMap = PostProcess::TONEMAP_NONE;
+    else if (tonemap == "reinhard")
+      toneMap = PostProcess::TONEMAP_REINHARD;
+    else if (tonemap == "aces")
+      toneMap = PostProcess::TONEMAP_ACES;
+    else
+      throw std::runtime_error("#pynari: unknown tonemap '"+tonemap
+                               +"' (valid are 'none', 'reinhard', and 'aces')");
+    PostProcess::Gamma gammaMode = PostProcess::GAMMA_NONE;
+    float gammaValue = 1.f;
+    if (py::isinstance<py::str>(gamma)) {
+      if (gamma.cast<std::string>() != "srgb")
+        throw std::runtime_error("#pynari: 'gamma' has to be 'srgb', None, "
+                                 "or a number");
+      gammaMode = PostProcess::GAMMA_SRGB;
+    } else if (!gamma.is_none()) {
+      gammaValue = gamma.cast<float>();
+      if (!(gammaValue > 0.f))
+        throw std::runtime_error("#pynari: 'gamma' has to be positive");
+      gammaMode = PostProcess::GAMMA_POWER;
+    }
+    postProcess = std::make_shared<PostProcess>(exposure,toneMap,
+                                                gammaMode,gammaValue,
+                                                quantize,dither);
+  }
+
+  void Frame::clearPostProcess()
+  {
+    postProcess = {};
+  }
+  
   py::object Frame::get(const std::string &channelName)
   {
     if (channelName == "channel.color") {
       uint32_t width, height;
       ANARIDataType pixelType;
 
-      const void *mapped
-        = anariMapFrame(device->handle,(ANARIFrame)this->handle,
-                        "channel.color",
-                        &width,&height,&pixelType);
+      const void *mapped;
+      std::shared_ptr<SortFirst> multi = sortFirst;
+      std::unique_lock<std::mutex> multiLock;
+      if (multi) {
+        multiLock = std::unique_lock<std::mutex>(multi->mutex);
+        mapped    = multi->composite.data();
+        width     = multi->width;
+        height    = multi->height;
+        pixelType = multi->pixelType;
+      } else
+        mapped
+          = anariMapFrame(device->handle,(ANARIFrame)this->handle,
+                          "channel.color",
+                          &width,&height,&pixelType);
       py::object frame;
-      if (pixelType == ANARI_FLOAT32_VEC4) {
+      PostProcess::SP post = postProcess;
+      if (pixelType == ANARI_FLOAT32_VEC4 && post) {
+        frame = post->apply((const float *)mapped,width,height);
+      }
+      else if (pixelType == ANARI_FLOAT32_VEC4) {
         frame
           = py::array_t<float>(
                                /* numpy shape */
@@ -120,7 +226,8 @@ namespace pynari {
                                  "'ANARI_UFIXED8_RGBA_SRGB'");
       }
 
-      anariUnmapFrame(device->handle,(ANARIFrame)handle,"channel.color");
+      if (!multi)
+        anariUnmapFrame(device->handle,(ANARIFrame)handle,"channel.color");
       return frame;
     }
 
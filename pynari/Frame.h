@@ -17,6 +17,7 @@
 #pragma once
 
 #include "pynari/Object.h"
+#include "pynari/PostProcess.h"
 
 namespace pynari {
 
@@ -26,6 +27,7 @@ namespace pynari {
   struct Camera;
   struct FrameBuffer;
   struct Data;
+  struct SortFirst;
   
   struct Frame : public Object {
     typedef std::shared_ptr<Frame> SP;
@@ -37,8 +39,16 @@ namespace pynari {
     ANARIDataType anariType() const override { return ANARI_FRAME; }
 
     /*! trigger rendering a frame; unlike native anari that not only
-        starts the frame, it also waits for it to finish */
+        starts the frame, it also waits for it to finish. If called
+        within an open transaction, all commits deferred so far get
+        issued before rendering. Counts towards the device's
+        'framesRendered' and 'renderMicroseconds' stats */
     void render();
+    /*! does the actual work for render() */
+    void renderFrame();
+    /*! render on this frame's own device only, even on a
+        multi-device context; commits have to be flushed already */
+    void renderOnThisDevice();
     uint64_t map(const std::string &channel);
     void unmap(const std::string &channel);
 
@@ -47,7 +57,25 @@ namespace pynari {
     /*! read a given frame buffer channel, and return it in a
         np::array of proper dimensions */
     py::object get(const std::string &channelName);
+
+    /*! sets up a post-processing chain (see PostProcess) that get()
+        applies to float (FLOAT32_VEC4) color buffers. 'tonemap' is
+        'none', 'reinhard', or 'aces'; 'gamma' is 'srgb', None, or
+        a number */
+    void setPostProcess(float exposure,
+                        const std::string &tonemap,
+                        const py::object &gamma,
+                        bool quantize,
+                        bool dither);
+    void clearPostProcess();
+    
+    /*! post-processing chain get() applies to float color buffers,
+        if any */
+    PostProcess::SP postProcess;
     
+    /*! for frames on multi-device contexts: renders and composites
+        this frame across all devices */
+    std::shared_ptr<SortFirst> sortFirst;
   };
 
 }
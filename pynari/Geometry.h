@@ -30,6 +30,7 @@ namespace pynari {
 
     std::string toString() const override { return "pynari::Geometry<"+type+">"; }
     ANARIDataType anariType() const override { return ANARI_GEOMETRY; }
+    std::string subtype() const override { return type; }
 
     const std::string type;
   };
@@ -18,6 +18,7 @@
 #include "pynari/Context.h"
 #include "pynari/Surface.h"
 #include "pynari/Volume.h"
+#include "pynari/Array.h"
 
 namespace pynari {
   
@@ -26,34 +27,44 @@ namespace pynari {
     : Object(device)
   {
     handle = anari::newObject<anari::Group>(device->handle);
-    std::vector<anari::Object> surfaces;
-    std::vector<anari::Object> volumes;
+    std::vector<Object::SP> surfaces;
+    std::vector<Object::SP> volumes;
     for (auto item : list) {
       Object::SP object = item.cast<Object::SP>();
       assert(object);
       
       Surface::SP surface = item.cast<Surface::SP>();
-      if (surface) { surfaces.push_back(surface->handle); continue; }
+      if (surface) { surfaces.push_back(surface); continue; }
       
       Volume::SP volume = item.cast<Volume::SP>();
-      if (volume) { volumes.push_back(volume->handle); continue; }
+      if (volume) { volumes.push_back(volume); continue; }
     }
 
-    if (!surfaces.empty())
-      anari::setParameterArray1D(device->handle, handle, "surface",
-                                 surfaces.data(),surfaces.size());
-    if (!volumes.empty())
-      anari::setParameterArray1D(device->handle, handle, "volume",
-                                 volumes.data(),volumes.size());
-    anari::commitParameters(device->handle,handle);
+    if (!surfaces.empty()) {
+      Array::SP array
+        = device->context->create<Array>(ANARI_SURFACE,surfaces);
+      setParam("surface",ANARI_ARRAY1D,&array->handle,array);
+    }
+    if (!volumes.empty()) {
+      Array::SP array
+        = device->context->create<Array>(ANARI_VOLUME,volumes);
+      setParam("volume",ANARI_ARRAY1D,&array->handle,array);
+    }
+    // note: committing happens in Context::newGroup(), once this
+    // object is owned by a shared-ptr, so that commit can get
+    // deferred if a transaction is open
+  }
+
+  Group::Group(Device::SP device)
+    : Object(device)
+  {
+    handle = anari::newObject<anari::Group>(device->handle);
   }
 
   Group::~Group()
   {
     std::cout << "#pynari: RELEASING group "
               << (int*)this << ":" << (int*)handle << std::endl;
-    anariRelease(device->handle,handle);
-    handle = {};
   }
   
 }
@@ -28,6 +28,9 @@ namespace pynari {
     
     Group(Device::SP device,
           const py::list &list);
+    /*! an empty group, for native code to set params on; does not
+        need the GIL */
+    Group(Device::SP device);
     virtual ~Group();
     
     std::string toString() const override { return "py_barn::Group"; }
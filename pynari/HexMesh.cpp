@@ -0,0 +1,211 @@
+// ======================================================================== //
+// Copyright 2024++ Ingo Wald                                               //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+#include "pynari/HexMesh.h"
+#include "pynari/Context.h"
+#include "pynari/Array.h"
+#include "pynari/SpatialField.h"
+#include "pynari/parallel.h"
+
+namespace pynari {
+
+  typedef py::array_t<float,py::array::c_style|py::array::forcecast>
+  FloatArray;
+  typedef py::array_t<uint8_t,py::array::c_style|py::array::forcecast>
+  ByteArray;
+
+  /*! VTK's cell type for hexahedra, which is what 'cell.type' uses */
+  enum { VTK_HEXAHEDRON = 12 };
+  
+  std::shared_ptr<SpatialField>
+  gridToHexMesh(const std::shared_ptr<Context> &context,
+                const py::buffer &_data,
+                const std::tuple<float,float,float> &_spacing,
+                const std::tuple<float,float,float> &_origin,
+                bool cellCentric,
+                const py::object &_mask)
+  {
+    FloatArray data = FloatArray::ensure(_data);
+    if (!data || data.ndim() != 3)
+      throw std::runtime_error
+        ("#pynari: gridToHexMesh: 'data' needs to be a 3D array of shape "
+         "(nz,ny,nx)");
+    const uint64_t n[3] = {
+      (uint64_t)data.shape(2), (uint64_t)data.shape(1), (uint64_t)data.shape(0)
+    };
+    uint64_t c[3], v[3];
+    for (int d=0;d<3;d++) {
+      c[d] = cellCentric ? n[d] : n[d]-1;
+      v[d] = c[d]+1;
+      if (n[d] == 0 || c[d] == 0)
+        throw std::runtime_error("#pynari: gridToHexMesh: grid has no cells");
+    }
+    const uint64_t numCells = c[0]*c[1]*c[2];
+    const uint64_t numVertices = v[0]*v[1]*v[2];
+    if (numVertices >= (1ull<<32) || 8*numCells >= (1ull<<32))
+      throw std::runtime_error("#pynari: gridToHexMesh: grid too large for "
+                               "32-bit indices");
+    
+    bool  keepAll = true;
+    float threshold = 0.f;
+    ByteArray mask;
+    if (py::isinstance<py::float_>(_mask) || py::isinstance<py::int_>(_mask)) {
+      keepAll   = false;
+      threshold = _mask.cast<float>();
+    } else if (!_mask.is_none()) {
+      keepAll = false;
+      mask    = ByteArray::ensure(_mask);
+      if (!mask || (uint64_t)mask.size() != numCells)
+        throw std::runtime_error("#pynari: gridToHexMesh: 'mask' needs to "
+                                 "have one entry per cell");
+    }
+    const math::float3 spacing(std::get<0>(_spacing),
+                               std::get<1>(_spacing),
+                               std::get<2>(_spacing));
+    const math::float3 origin(std::get<0>(_origin),
+                              std::get<1>(_origin),
+                              std::get<2>(_origin));
+    const float   *values   = data.data();
+    const uint8_t *maskData = mask ? mask.data() : nullptr;
+    
+    py::gil_scoped_release noGIL;
+
+    // linear index of the vertex at given corner of given cell
+    auto cornerOf = [&](uint64_t cell, int corner) {
+      const uint64_t x = cell % c[0], y = (cell / c[0]) % c[1], z = cell / (c[0]*c[1]);
+      // VTK hexahedron corner order: bottom face counter-clockwise,
+      // then the top face
+      static const int dx[8] = { 0,1,1,0,0,1,1,0 };
+      static const int dy[8] = { 0,0,1,1,0,0,1,1 };
+      static const int dz[8] = { 0,0,0,0,1,1,1,1 };
+      return x+dx[corner] + v[0]*((y+dy[corner]) + v[1]*(z+dz[corner]));
+    };
+
+    // ------------------------------------------------------------------
+    // which cells, and which of their vertices, to keep
+    // ------------------------------------------------------------------
+    uint64_t numOutCells = numCells, numOutVertices = numVertices;
+    std::vector<uint32_t> cellOffsets, vertexIDs;
+    if (!keepAll) {
+      std::vector<uint8_t> keep(numCells);
+      parallel_for(numCells,[&](size_t cell) {
+        if (maskData)
+          keep[cell] = maskData[cell] != 0;
+        else if (cellCentric)
+          keep[cell] = values[cell] > threshold;
+        else {
+          bool anyAbove = false;
+          for (int k=0;k<8;k++)
+            anyAbove |= values[cornerOf(cell,k)] > threshold;
+          keep[cell] = anyAbove;
+        }
+      });
+      cellOffsets.resize(numCells);
+      numOutCells = parallel_scan(numCells,[&](size_t cell)
+                                  { return (uint32_t)keep[cell]; },
+                                  cellOffsets.data());
+      if (numOutCells == 0)
+        throw std::runtime_error("#pynari: gridToHexMesh: mask dropped all "
+                                 "cells");
+      // a vertex is used if any of the (up to) 8 cells around it is
+      vertexIDs.resize(numVertices);
+      numOutVertices = parallel_scan(numVertices,[&](size_t vertex) {
+        const uint64_t x = vertex % v[0], y = (vertex / v[0]) % v[1], z = vertex / (v[0]*v[1]);
+        for (int k=0;k<8;k++) {
+          const int64_t cx = int64_t(x)-(k&1), cy = int64_t(y)-((k>>1)&1), cz = int64_t(z)-(k>>2);
+          if (cx < 0 || cy < 0 || cz < 0 ||
+              cx >= (int64_t)c[0] || cy >= (int64_t)c[1] || cz >= (int64_t)c[2])
+            continue;
+          if (keep[cx+c[0]*(cy+c[1]*cz)]) return 1u;
+        }
+        return 0u;
+      },vertexIDs.data());
+      // cells that got dropped get marked in the offsets, so the fill
+      // pass below doesn't need 'keep' any more
+      parallel_for(numCells,[&](size_t cell)
+                   { if (!keep[cell]) cellOffsets[cell] = ~0u; });
+    }
+    
+    // ------------------------------------------------------------------
+    // create the arrays, and fill them in place
+    // ------------------------------------------------------------------
+    anari::Device device = context->device->handle;
+    auto positionArray
+      = context->create<Array>(ANARI_FLOAT32_VEC3,std::vector<uint64_t>{ numOutVertices });
+    auto indexArray
+      = context->create<Array>(ANARI_UINT32,std::vector<uint64_t>{ 8*numOutCells });
+    auto cellIndexArray
+      = context->create<Array>(ANARI_UINT32,std::vector<uint64_t>{ numOutCells });
+    auto cellTypeArray
+      = context->create<Array>(ANARI_UINT8,std::vector<uint64_t>{ numOutCells });
+    auto dataArray
+      = context->create<Array>(ANARI_FLOAT32,std::vector<uint64_t>
+                               { cellCentric ? numOutCells : numOutVertices });
+    math::float3 *positions = (math::float3 *)anariMapArray(device,positionArray->handle);
+    uint32_t *indices       = (uint32_t *)anariMapArray(device,indexArray->handle);
+    uint32_t *cellIndices   = (uint32_t *)anariMapArray(device,cellIndexArray->handle);
+    uint8_t  *cellTypes     = (uint8_t *)anariMapArray(device,cellTypeArray->handle);
+    float    *outData       = (float *)anariMapArray(device,dataArray->handle);
+
+    parallel_for(numCells,[&](size_t cell) {
+      const uint32_t out = keepAll ? (uint32_t)cell : cellOffsets[cell];
+      if (out == ~0u) return;
+      cellIndices[out] = 8*out;
+      cellTypes[out]   = VTK_HEXAHEDRON;
+      for (int k=0;k<8;k++) {
+        const uint64_t vertex = cornerOf(cell,k);
+        indices[8*out+k] = keepAll ? (uint32_t)vertex : vertexIDs[vertex];
+      }
+      if (cellCentric)
+        outData[out] = values[cell];
+    });
+    parallel_for(numVertices,[&](size_t vertex) {
+      if (!keepAll && (vertex+1 < numVertices
+                       ? vertexIDs[vertex+1] == vertexIDs[vertex]
+                       : vertexIDs[vertex] == numOutVertices))
+        // not used by any cell that's kept
+        return;
+      const uint32_t out = keepAll ? (uint32_t)vertex : vertexIDs[vertex];
+      const uint64_t x = vertex % v[0], y = (vertex / v[0]) % v[1], z = vertex / (v[0]*v[1]);
+      positions[out] = math::float3(origin.x+x*spacing.x,
+                                    origin.y+y*spacing.y,
+                                    origin.z+z*spacing.z);
+      if (!cellCentric)
+        outData[out] = values[vertex];
+    });
+    
+    anariUnmapArray(device,positionArray->handle);
+    anariUnmapArray(device,indexArray->handle);
+    anariUnmapArray(device,cellIndexArray->handle);
+    anariUnmapArray(device,cellTypeArray->handle);
+    anariUnmapArray(device,dataArray->handle);
+
+    // ------------------------------------------------------------------
+    // and the field itself
+    // ------------------------------------------------------------------
+    auto field = context->create<SpatialField>("unstructured");
+    field->setParam("vertex.position",ANARI_ARRAY1D,&positionArray->handle,positionArray);
+    field->setParam("index",ANARI_ARRAY1D,&indexArray->handle,indexArray);
+    field->setParam("cell.index",ANARI_ARRAY1D,&cellIndexArray->handle,cellIndexArray);
+    field->setParam("cell.type",ANARI_ARRAY1D,&cellTypeArray->handle,cellTypeArray);
+    field->setParam(cellCentric ? "cell.data" : "vertex.data",
+                    ANARI_ARRAY1D,&dataArray->handle,dataArray);
+    field->commit();
+    return field;
+  }
+
+}
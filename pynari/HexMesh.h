@@ -0,0 +1,47 @@
+// ======================================================================== //
+// Copyright 2024++ Ingo Wald                                               //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+#pragma once
+
+#include "pynari/common.h"
+
+namespace pynari {
+
+  struct Context;
+  struct SpatialField;
+  
+  /*! turns a dense (nz,ny,nx) grid of scalars into an 'unstructured'
+      spatial field of hexahedra, with all of its arrays
+      ('vertex.position', 'index', 'cell.index', 'cell.type', and
+      either 'cell.data' or 'vertex.data') generated natively, in
+      parallel, and straight into the device's arrays. With
+      'cellCentric' each value is one cell (of size 'spacing');
+      otherwise values are the cells' corners. 'mask' can drop cells:
+      either a number (cells whose value - or, for vertex-centric
+      data, all of whose corner values - are <= that number get
+      dropped), or an array with one entry per cell (cells whose
+      entry is 0 get dropped); only vertices of cells that are kept
+      get emitted */
+  std::shared_ptr<SpatialField>
+  gridToHexMesh(const std::shared_ptr<Context> &context,
+                const py::buffer &data,
+                const std::tuple<float,float,float> &spacing,
+                const std::tuple<float,float,float> &origin,
+                bool cellCentric,
+                const py::object &mask);
+
+}
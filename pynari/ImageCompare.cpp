@@ -0,0 +1,392 @@
+// ======================================================================== //
+// Copyright 2024++ Ingo Wald                                               //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "pynari/ImageCompare.h"
+#include "pynari/parallel.h"
+#include <cmath>
+#include <limits>
+#define STB_IMAGE_STATIC
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb/stb_image.h"
+
+namespace pynari {
+
+  namespace {
+
+    /*! an RGB image, with three floats in [0,1] per pixel */
+    struct Image {
+      int width = 0, height = 0;
+      std::vector<float> rgb;
+      size_t numPixels() const { return size_t(width)*height; }
+    };
+
+    Image loadImageFile(const std::string &fileName)
+    {
+      Image image;
+      int numChannels = 0;
+      uint8_t *pixels = stbi_load(fileName.c_str(),&image.width,&image.height,
+                                  &numChannels,3);
+      if (!pixels)
+        throw std::runtime_error("#pynari: compareImages: could not load '"
+                                 +fileName+"'"
+                                 +(stbi_failure_reason()
+                                   ? std::string(" (")+stbi_failure_reason()+")"
+                                   : std::string()));
+      image.rgb.resize(3*image.numPixels());
+      for (size_t i=0;i<image.rgb.size();i++)
+        image.rgb[i] = pixels[i]*(1.f/255.f);
+      stbi_image_free(pixels);
+      return image;
+    }
+    
+    Image loadImage(const py::object &object, const char *what)
+    {
+      if (py::isinstance<py::str>(object))
+        return loadImageFile(object.cast<std::string>());
+      const std::string error
+        = std::string("#pynari: compareImages: '")+what+"' has to be "
+        "the name of an image file, or a (height,width), (height,width,3), "
+        "or (height,width,4) array of uint8 or float32";
+      if (!py::isinstance<py::buffer>(object))
+        throw std::runtime_error(error);
+      py::buffer_info info = object.cast<py::buffer>().request();
+      const bool isByte  = info.format == py::format_descriptor<uint8_t>::format();
+      const bool isFloat = info.format == py::format_descriptor<float>::format();
+      const int numChannels
+        = info.ndim == 2 ? 1
+        : info.ndim == 3 ? (int)info.shape[2]
+        : 0;
+      if (!(isByte || isFloat) ||
+          !(numChannels == 1 || numChannels == 3 || numChannels == 4))
+        throw std::runtime_error(error);
+
+      Image image;
+      image.height = (int)info.shape[0];
+      image.width  = (int)info.shape[1];
+      image.rgb.resize(3*image.numPixels());
+      const uint8_t *base = (const uint8_t *)info.ptr;
+      const ssize_t channelStride = numChannels == 1 ? 0 : info.strides[2];
+      parallel_for(image.height,[&](size_t y) {
+        for (int x=0;x<image.width;x++) {
+          const uint8_t *pixel = base+y*info.strides[0]+x*info.strides[1];
+          float *out = image.rgb.data()+3*(y*image.width+x);
+          for (int c=0;c<3;c++) {
+            const uint8_t *value = pixel+c*channelStride;
+            out[c] = isByte
+              ? *value*(1.f/255.f)
+              : std::min(1.f,std::max(0.f,*(const float *)value));
+          }
+        }
+      },16);
+      return image;
+    }
+
+    /*! sum of f(i) over all i in [0,numItems), over all worker
+        threads; always adds up in the same order, so results don't
+        depend on the number of threads */
+    template<typename F>
+    double sumOf(size_t numItems, F &&f)
+    {
+      const size_t blockSize = 64*1024;
+      std::vector<double> blockSums((numItems+blockSize-1)/blockSize,0.);
+      parallel_for_blocked(numItems,blockSize,
+                           [&](size_t begin, size_t end) {
+                             double sum = 0.;
+                             for (size_t i=begin;i<end;i++) sum += f(i);
+                             blockSums[begin/blockSize] = sum;
+                           });
+      double sum = 0.;
+      for (auto blockSum : blockSums) sum += blockSum;
+      return sum;
+    }
+
+    /*! samples of a gaussian of std deviation 'sigma' (order 0), or
+        of its first (order 1) or second (order 2) derivative, over
+        [-3 sigma,+3 sigma]. Positive weights sum up to 1, and so do
+        negative ones, to -1 */
+    std::vector<float> gaussianKernel(float sigma, int order)
+    {
+      const int radius = std::max(1,(int)ceilf(3.f*sigma));
+      std::vector<float> kernel(2*radius+1);
+      for (int i=-radius;i<=radius;i++) {
+        const float x = float(i);
+        const float g = expf(-x*x/(2.f*sigma*sigma));
+        kernel[i+radius]
+          = order == 0 ? g
+          : order == 1 ? -x*g
+          :              (x*x/(sigma*sigma)-1.f)*g;
+      }
+      float positive = 0.f, negative = 0.f;
+      for (auto w : kernel) (w > 0.f ? positive : negative) += w;
+      for (auto &w : kernel) w = w > 0.f ? w/positive : w/-negative;
+      return kernel;
+    }
+
+    /*! convolves a (width x height) single-channel image with the
+        separable kernel kx (along x) times ky (along y), clamping
+        at the borders. 'in' and 'out' can be the same */
+    void convolve(const float *in, float *out, int width, int height,
+                  const std::vector<float> &kx,
+                  const std::vector<float> &ky)
+    {
+      const int rx = int(kx.size()/2), ry = int(ky.size()/2);
+      std::vector<float> tmp(size_t(width)*height);
+      parallel_for(height,[&](size_t y) {
+        const float *row = in+y*width;
+        float *t = tmp.data()+y*width;
+        for (int x=0;x<width;x++) {
+          float sum = 0.f;
+          if (x >= rx && x+rx < width)
+            for (int i=-rx;i<=rx;i++)
+              sum += kx[i+rx]*row[x+i];
+          else
+            for (int i=-rx;i<=rx;i++)
+              sum += kx[i+rx]*row[std::min(width-1,std::max(0,x+i))];
+          t[x] = sum;
+        }
+      },16);
+      parallel_for(height,[&](size_t y) {
+        float *o = out+y*width;
+        std::fill(o,o+width,0.f);
+        for (int j=-ry;j<=ry;j++) {
+          const int sy = std::min(height-1,std::max(0,int(y)+j));
+          const float *t = tmp.data()+size_t(sy)*width;
+          const float k = ky[j+ry];
+          for (int x=0;x<width;x++)
+            o[x] += k*t[x];
+        }
+      },16);
+    }
+
+    /*! mean structural similarity of the two images' (Rec.601) luma,
+        with 11x11 gaussian (sigma=1.5) windows */
+    double computeSSIM(const Image &a, const Image &b)
+    {
+      const size_t N = a.numPixels();
+      std::vector<float> x(N), y(N), xx(N), yy(N), xy(N);
+      parallel_for(N,[&](size_t i) {
+        const float *ca = a.rgb.data()+3*i, *cb = b.rgb.data()+3*i;
+        x[i] = .299f*ca[0]+.587f*ca[1]+.114f*ca[2];
+        y[i] = .299f*cb[0]+.587f*cb[1]+.114f*cb[2];
+        xx[i] = x[i]*x[i];
+        yy[i] = y[i]*y[i];
+        xy[i] = x[i]*y[i];
+      });
+      const auto g = gaussianKernel(1.5f,0);
+      for (auto channel : { &x, &y, &xx, &yy, &xy })
+        convolve(channel->data(),channel->data(),a.width,a.height,g,g);
+      const double C1 = .01*.01, C2 = .03*.03;
+      return sumOf(N,[&](size_t i) {
+        const double mx = x[i], my = y[i];
+        const double sxx = xx[i]-mx*mx, syy = yy[i]-my*my, sxy = xy[i]-mx*my;
+        return ((2.*mx*my+C1)*(2.*sxy+C2))
+          /    ((mx*mx+my*my+C1)*(sxx+syy+C2));
+      })/N;
+    }
+
+    // ------------------------------------------------------------------
+    // FLIP-style error
+    // ------------------------------------------------------------------
+
+    /*! D65 white point, in XYZ */
+    const float whiteX = .950428545f, whiteY = 1.f, whiteZ = 1.088900371f;
+
+    inline float srgbToLinear(float v)
+    {
+      return v <= .04045f ? v/12.92f : powf((v+.055f)/1.055f,2.4f);
+    }
+
+    inline void linearToXYZ(const float *rgb, float &X, float &Y, float &Z)
+    {
+      X = .4124564f*rgb[0] + .3575761f*rgb[1] + .1804375f*rgb[2];
+      Y = .2126729f*rgb[0] + .7151522f*rgb[1] + .0721750f*rgb[2];
+      Z = .0193339f*rgb[0] + .1191920f*rgb[1] + .9503041f*rgb[2];
+    }
+    
+    /*! L*a*b* of given (linear) RGB color, with a and b scaled by
+        .01 L (the Hunt effect, as FLIP does) */
+    inline void linearToHuntLab(const float *rgb, float *lab)
+    {
+      float X, Y, Z;
+      linearToXYZ(rgb,X,Y,Z);
+      auto f = [](float t) {
+        const float delta = 6.f/29.f;
+        return t > delta*delta*delta ? cbrtf(t) : t/(3.f*delta*delta)+4.f/29.f;
+      };
+      const float fx = f(X/whiteX), fy = f(Y/whiteY), fz = f(Z/whiteZ);
+      lab[0] = 116.f*fy-16.f;
+      lab[1] = .01f*lab[0]*500.f*(fx-fy);
+      lab[2] = .01f*lab[0]*200.f*(fy-fz);
+    }
+
+    inline float hyab(const float *a, const float *b)
+    {
+      return fabsf(a[0]-b[0]) + sqrtf((a[1]-b[1])*(a[1]-b[1])
+                                      +(a[2]-b[2])*(a[2]-b[2]));
+    }
+    
+    /*! what FLIP compares of one image: its colors after CSF-like
+        filtering, in Hunt-adjusted L*a*b*, and the magnitude of its
+        edges and points (first and second derivatives) in luminance */
+    struct FlipFeatures {
+      std::vector<float> lab, edges, points;
+    };
+
+    FlipFeatures flipFeatures(const Image &image, float ppd)
+    {
+      const int w = image.width, h = image.height;
+      const size_t N = image.numPixels();
+      FlipFeatures ff;
+      // YCxCz (opponent color space that FLIP filters in), and
+      // luminance for the feature detectors
+      std::vector<float> ycc[3] = {
+        std::vector<float>(N), std::vector<float>(N), std::vector<float>(N)
+      };
+      std::vector<float> luminance(N);
+      parallel_for(N,[&](size_t i) {
+        float rgb[3], X, Y, Z;
+        for (int c=0;c<3;c++) rgb[c] = srgbToLinear(image.rgb[3*i+c]);
+        linearToXYZ(rgb,X,Y,Z);
+        ycc[0][i] = 116.f*Y/whiteY-16.f;
+        ycc[1][i] = 500.f*(X/whiteX-Y/whiteY);
+        ycc[2][i] = 200.f*(Y/whiteY-Z/whiteZ);
+        luminance[i] = Y/whiteY;
+      });
+      // contrast sensitivity of each channel, approximated by a
+      // single gaussian each, using the widths of FLIP's CSFs
+      const float b[3] = { .0047f, .0053f, .04f };
+      const float pi = 3.14159265f;
+      for (int c=0;c<3;c++) {
+        const auto g = gaussianKernel(ppd*sqrtf(b[c]/(2.f*pi*pi)),0);
+        convolve(ycc[c].data(),ycc[c].data(),w,h,g,g);
+      }
+      ff.lab.resize(3*N);
+      parallel_for(N,[&](size_t i) {
+        const float Yn = (ycc[0][i]+16.f)/116.f;
+        const float X = (ycc[1][i]/500.f+Yn)*whiteX;
+        const float Y = Yn*whiteY;
+        const float Z = (Yn-ycc[2][i]/200.f)*whiteZ;
+        float rgb[3] = {
+          3.2404542f*X - 1.5371385f*Y - 0.4985314f*Z,
+          -.9692660f*X + 1.8760108f*Y + 0.0415560f*Z,
+          0.0556434f*X - 0.2040259f*Y + 1.0572252f*Z
+        };
+        for (int c=0;c<3;c++) rgb[c] = std::min(1.f,std::max(0.f,rgb[c]));
+        linearToHuntLab(rgb,ff.lab.data()+3*i);
+      });
+
+      const float sigma = .5f*.082f*ppd;
+      const auto g  = gaussianKernel(sigma,0);
+      for (int order=1;order<=2;order++) {
+        const auto d = gaussianKernel(sigma,order);
+        std::vector<float> dx(N), dy(N);
+        convolve(luminance.data(),dx.data(),w,h,d,g);
+        convolve(luminance.data(),dy.data(),w,h,g,d);
+        auto &magnitude = order == 1 ? ff.edges : ff.points;
+        magnitude.resize(N);
+        parallel_for(N,[&](size_t i) {
+          magnitude[i] = sqrtf(dx[i]*dx[i]+dy[i]*dy[i]);
+        });
+      }
+      return ff;
+    }
+
+    /*! per-pixel FLIP-style error between the two images, in [0,1] */
+    std::vector<float> computeFlip(const Image &a, const Image &b, float ppd)
+    {
+      const FlipFeatures fa = flipFeatures(a,ppd);
+      const FlipFeatures fb = flipFeatures(b,ppd);
+
+      // color differences get normalized by the largest one there
+      // can be, between (pure) green and blue, and remapped to give
+      // more weight to small differences
+      const float qc = .7f, pc = .4f, pt = .95f;
+      const float green[3] = { 0.f, 1.f, 0.f }, blue[3] = { 0.f, 0.f, 1.f };
+      float greenLab[3], blueLab[3];
+      linearToHuntLab(green,greenLab);
+      linearToHuntLab(blue,blueLab);
+      const float cmax = powf(hyab(greenLab,blueLab),qc);
+      
+      const size_t N = a.numPixels();
+      std::vector<float> error(N);
+      parallel_for(N,[&](size_t i) {
+        const float dc = powf(hyab(fa.lab.data()+3*i,fb.lab.data()+3*i),qc);
+        const float colorError
+          = std::min(1.f, dc < pc*cmax
+                     ? pt/(pc*cmax)*dc
+                     : pt+(dc-pc*cmax)/(cmax-pc*cmax)*(1.f-pt));
+        const float featureError
+          = sqrtf(std::min(1.f,std::max(fabsf(fa.edges[i]-fb.edges[i]),
+                                        fabsf(fa.points[i]-fb.points[i]))
+                           *.70710678f));
+        error[i] = powf(colorError,1.f-featureError);
+      });
+      return error;
+    }
+    
+  }
+  
+  py::dict compareImages(const py::object &_image,
+                         const py::object &_reference,
+                         float ppd,
+                         bool errorMap)
+  {
+    if (!(ppd > 0.f))
+      throw std::runtime_error("#pynari: compareImages: 'ppd' has to be "
+                               "positive");
+    const Image image     = loadImage(_image,"image");
+    const Image reference = loadImage(_reference,"reference");
+    if (image.width != reference.width || image.height != reference.height)
+      throw std::runtime_error
+        ("#pynari: compareImages: image is "+std::to_string(image.width)
+         +"x"+std::to_string(image.height)+" pixels, but reference is "
+         +std::to_string(reference.width)+"x"
+         +std::to_string(reference.height));
+    if (image.numPixels() == 0)
+      throw std::runtime_error("#pynari: compareImages: images are empty");
+
+    double mse, ssim, flip;
+    std::vector<float> flipError;
+    {
+      py::gil_scoped_release noGIL;
+      const size_t N = image.numPixels();
+      mse = sumOf(3*N,[&](size_t i) {
+        const double d = image.rgb[i]-reference.rgb[i];
+        return d*d;
+      })/(3*N);
+      ssim = computeSSIM(image,reference);
+      flipError = computeFlip(image,reference,ppd);
+      flip = sumOf(N,[&](size_t i) { return (double)flipError[i]; })/N;
+    }
+    
+    py::dict result;
+    result["width"]  = image.width;
+    result["height"] = image.height;
+    result["mse"]    = mse;
+    result["psnr"]   = mse > 0.
+      ? 10.*log10(1./mse)
+      : std::numeric_limits<double>::infinity();
+    result["ssim"]   = ssim;
+    result["flip"]   = flip;
+    if (errorMap) {
+      py::array_t<float> map({(size_t)image.height,(size_t)image.width});
+      memcpy(map.mutable_data(),flipError.data(),flipError.size()*sizeof(float));
+      result["flip_map"] = map;
+    }
+    return result;
+  }
+  
+}
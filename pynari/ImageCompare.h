@@ -0,0 +1,46 @@
+// ======================================================================== //
+// Copyright 2024++ Ingo Wald                                               //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include "pynari/common.h"
+
+namespace pynari {
+
+  /*! compares a rendered image against a reference one, and returns
+      a dict with their 'mse' and 'psnr' (over RGB, in dB; inf if
+      identical), 'ssim' (mean structural similarity of their luma,
+      over 11x11 gaussian windows), and 'flip' (mean of a FLIP-style
+      perceptual error in [0,1] - colors compared in a Hunt-adjusted
+      L*a*b* space after CSF-like filtering for a viewer at 'ppd'
+      pixels per degree, boosted where edges or points differ). This
+      follows the structure of NVIDIA's FLIP, but is a simplified
+      version of it, so values are comparable across runs, not to
+      other FLIP implementations. With 'errorMap', also returns the
+      per-pixel flip error as a (height,width) float array
+      ('flip_map').
+
+      Images are (height,width), (height,width,3), or
+      (height,width,4) arrays of uint8 or float32 (in [0,1]) that
+      hold display-encoded (sRGB) values, or names of image files to
+      load; alpha gets ignored. All metrics get computed natively,
+      over all worker threads, without the GIL */
+  py::dict compareImages(const py::object &image,
+                         const py::object &reference,
+                         float ppd,
+                         bool errorMap);
+
+}
@@ -0,0 +1,322 @@
+// ======================================================================== //
+// Copyright 2024++ Ingo Wald                                               //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "pynari/Inflate.h"
+#include <cstring>
+
+namespace pynari {
+  namespace {
+
+    const int maxCodeBits = 15;
+    
+    inline void inflateError(const char *what)
+    {
+      throw std::runtime_error(std::string("#pynari: inflate: ")+what);
+    }
+
+    /*! canonical huffman code; codes of up to 'fastBits' bits get
+        decoded with a single table lookup, longer ones bit by bit */
+    struct Huffman {
+      enum { fastBits = 10 };
+      
+      /*! returns number of unused codes (>0 for an incomplete
+          code); throws if over-subscribed */
+      int build(const uint8_t *lengths, int numSymbols);
+
+      /*! (length<<9)|symbol for each fastBits-bit (reversed) code
+          prefix, 0 if the code is longer than fastBits */
+      uint16_t fast[1<<fastBits];
+      uint16_t count[maxCodeBits+1];
+      uint16_t symbol[288];
+    };
+    
+    int Huffman::build(const uint8_t *lengths, int numSymbols)
+    {
+      memset(count,0,sizeof(count));
+      memset(fast,0,sizeof(fast));
+      for (int s=0;s<numSymbols;s++) count[lengths[s]]++;
+      if (count[0] == numSymbols) return 0;
+
+      int left = 1;
+      for (int len=1;len<=maxCodeBits;len++) {
+        left = 2*left - count[len];
+        if (left < 0) inflateError("over-subscribed huffman code");
+      }
+
+      int offset[maxCodeBits+1];
+      offset[1] = 0;
+      for (int len=1;len<maxCodeBits;len++)
+        offset[len+1] = offset[len] + count[len];
+      for (int s=0;s<numSymbols;s++)
+        if (lengths[s]) symbol[offset[lengths[s]]++] = (uint16_t)s;
+
+      int code = 0, index = 0;
+      for (int len=1;len<=maxCodeBits;len++) {
+        for (int i=0;i<count[len];i++, code++) {
+          int s = symbol[index++];
+          if (len > fastBits) continue;
+          // stream stores codes msb-first, but we read lsb-first
+          int reversed = 0;
+          for (int b=0;b<len;b++)
+            reversed |= ((code >> b) & 1) << (len-1-b);
+          for (int j=reversed;j<(1<<fastBits);j+=(1<<len))
+            fast[j] = (uint16_t)((len << 9) | s);
+        }
+        code <<= 1;
+      }
+      return left;
+    }
+
+    const uint16_t lengthBase[29] = {
+      3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+      35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+    const uint8_t lengthExtra[29] = {
+      0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+      3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+    const uint16_t distBase[30] = {
+      1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+      257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+      8193, 12289, 16385, 24577 };
+    const uint8_t distExtra[30] = {
+      0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+      7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+    struct Inflater {
+      Inflater(const uint8_t *in, size_t inSize, uint8_t *out, size_t outSize)
+        : in(in), inSize(inSize), out(out), outSize(outSize)
+      {}
+
+      void run();
+      
+      /*! make sure there's at least n bits in the bit buffer; reading
+          past the end of input pads with zeroes, which is only an
+          error if those padding bits actually get consumed */
+      inline void need(int n)
+      {
+        while (bitCount < n) {
+          uint64_t byte = 0;
+          if (inPos < inSize) byte = in[inPos++]; else numPadBytes++;
+          bitBuf |= byte << bitCount;
+          bitCount += 8;
+        }
+      }
+      inline uint32_t bits(int n)
+      {
+        if (n == 0) return 0;
+        need(n);
+        uint32_t v = (uint32_t)(bitBuf & ((1ull<<n)-1));
+        bitBuf >>= n;
+        bitCount -= n;
+        return v;
+      }
+      int  decode(const Huffman &h);
+      void stored();
+      void codes(const Huffman &lengthCode, const Huffman &distCode);
+      void dynamicTables(Huffman &lengthCode, Huffman &distCode);
+      
+      const uint8_t *const in;
+      const size_t         inSize;
+      size_t               inPos = 0;
+      size_t               numPadBytes = 0;
+      uint64_t             bitBuf = 0;
+      int                  bitCount = 0;
+      uint8_t *const       out;
+      const size_t         outSize;
+      size_t               outPos = 0;
+    };
+
+    int Inflater::decode(const Huffman &h)
+    {
+      need(maxCodeBits);
+      uint16_t entry = h.fast[bitBuf & ((1<<Huffman::fastBits)-1)];
+      if (entry) {
+        int len = entry >> 9;
+        bitBuf >>= len;
+        bitCount -= len;
+        return entry & 511;
+      }
+      int code = 0, first = 0, index = 0;
+      for (int len=1;len<=maxCodeBits;len++) {
+        code |= bits(1);
+        int count = h.count[len];
+        if (code - count < first)
+          return h.symbol[index + (code - first)];
+        index += count;
+        first += count;
+        first <<= 1;
+        code  <<= 1;
+      }
+      inflateError("invalid huffman code");
+      return -1;
+    }
+
+    void Inflater::stored()
+    {
+      // skip to byte boundary
+      bits(bitCount & 7);
+      uint32_t len  = bits(16);
+      uint32_t nlen = bits(16);
+      if (len != (~nlen & 0xffff))
+        inflateError("corrupt stored block");
+      if (outPos + len > outSize)
+        inflateError("output exceeds expected size");
+      // whatever is still in the bit buffer are whole bytes
+      while (len && bitCount >= 8) {
+        out[outPos++] = (uint8_t)bits(8);
+        --len;
+      }
+      if (inPos + len > inSize)
+        inflateError("unexpected end of input");
+      memcpy(out+outPos,in+inPos,len);
+      outPos += len;
+      inPos  += len;
+    }
+
+    void Inflater::codes(const Huffman &lengthCode, const Huffman &distCode)
+    {
+      while (true) {
+        int s = decode(lengthCode);
+        if (s < 256) {
+          if (outPos >= outSize)
+            inflateError("output exceeds expected size");
+          out[outPos++] = (uint8_t)s;
+          continue;
+        }
+        if (s == 256) return;
+        s -= 257;
+        if (s >= 29) inflateError("invalid length symbol");
+        size_t len = lengthBase[s] + bits(lengthExtra[s]);
+        int d = decode(distCode);
+        if (d >= 30) inflateError("invalid distance symbol");
+        size_t dist = distBase[d] + bits(distExtra[d]);
+        if (dist > outPos)
+          inflateError("distance too far back");
+        if (outPos + len > outSize)
+          inflateError("output exceeds expected size");
+        // source and destination may overlap, so byte by byte
+        const uint8_t *src = out+outPos-dist;
+        uint8_t *dst = out+outPos;
+        for (size_t i=0;i<len;i++) dst[i] = src[i];
+        outPos += len;
+      }
+    }
+
+    void Inflater::dynamicTables(Huffman &lengthCode, Huffman &distCode)
+    {
+      static const uint8_t order[19] = {
+        16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+      int numLengths = bits(5) + 257;
+      int numDists   = bits(5) + 1;
+      int numCodes   = bits(4) + 4;
+      if (numLengths > 286 || numDists > 30)
+        inflateError("bad dynamic block counts");
+
+      uint8_t lengths[286+30] = { 0 };
+      for (int i=0;i<numCodes;i++)
+        lengths[order[i]] = (uint8_t)bits(3);
+      Huffman lencode;
+      if (lencode.build(lengths,19) != 0)
+        inflateError("incomplete code length code");
+      
+      int index = 0;
+      while (index < numLengths + numDists) {
+        int s = decode(lencode);
+        if (s < 16) {
+          lengths[index++] = (uint8_t)s;
+          continue;
+        }
+        uint8_t len = 0;
+        int repeat;
+        if (s == 16) {
+          if (index == 0) inflateError("repeat with no first length");
+          len = lengths[index-1];
+          repeat = 3 + bits(2);
+        } else if (s == 17)
+          repeat = 3 + bits(3);
+        else
+          repeat = 11 + bits(7);
+        if (index + repeat > numLengths + numDists)
+          inflateError("too many code lengths");
+        while (repeat--) lengths[index++] = len;
+      }
+      if (lengths[256] == 0)
+        inflateError("no end-of-block code");
+
+      // only a single-code distance code may be incomplete
+      int left = lengthCode.build(lengths,numLengths);
+      if (left > 0 && numLengths - lengthCode.count[0] != 1)
+        inflateError("incomplete literal/length code");
+      left = distCode.build(lengths+numLengths,numDists);
+      if (left > 0 && numDists - distCode.count[0] != 1)
+        inflateError("incomplete distance code");
+    }
+
+    const Huffman &fixedLengthCode(bool dist)
+    {
+      static struct Fixed {
+        Fixed()
+        {
+          uint8_t lengths[288];
+          int s = 0;
+          for (;s<144;s++) lengths[s] = 8;
+          for (;s<256;s++) lengths[s] = 9;
+          for (;s<280;s++) lengths[s] = 7;
+          for (;s<288;s++) lengths[s] = 8;
+          lengthCode.build(lengths,288);
+          for (s=0;s<30;s++) lengths[s] = 5;
+          distCode.build(lengths,30);
+        }
+        Huffman lengthCode, distCode;
+      } fixed;
+      return dist ? fixed.distCode : fixed.lengthCode;
+    }
+    
+    void Inflater::run()
+    {
+      bool last;
+      do {
+        last = bits(1);
+        switch (bits(2)) {
+        case 0:
+          stored();
+          break;
+        case 1:
+          codes(fixedLengthCode(false),fixedLengthCode(true));
+          break;
+        case 2: {
+          Huffman lengthCode, distCode;
+          dynamicTables(lengthCode,distCode);
+          codes(lengthCode,distCode);
+        } break;
+        default:
+          inflateError("invalid block type");
+        }
+        if (8*numPadBytes > (size_t)bitCount)
+          inflateError("unexpected end of input");
+      } while (!last);
+      if (outPos != outSize)
+        inflateError("output smaller than expected size");
+    }
+    
+  }
+  
+  void inflate(const uint8_t *in, size_t inSize,
+               uint8_t *out, size_t outSize)
+  {
+    Inflater(in,inSize,out,outSize).run();
+  }
+  
+}
@@ -0,0 +1,30 @@
+// ======================================================================== //
+// Copyright 2024++ Ingo Wald                                               //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include "pynari/common.h"
+
+namespace pynari {
+
+  /*! decompresses a raw DEFLATE (RFC 1951) stream - as used in
+      zip/npz archives - into 'out', which has to be exactly as large
+      as the uncompressed data. Throws on malformed input, or if the
+      stream doesn't decompress to exactly 'outSize' bytes */
+  void inflate(const uint8_t *in, size_t inSize,
+               uint8_t *out, size_t outSize);
+  
+}
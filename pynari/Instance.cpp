@@ -27,5 +27,63 @@ namespace pynari {
     handle = anari::newObject<anari::Instance>(device->handle,type.c_str());
   }
 
+  InstanceArray::InstanceArray(Device::SP device,
+                               const std::vector<Object::SP> &instances)
+    : Array(device,ANARI_INSTANCE,instances)
+  {}
+
+  void InstanceArray::setTransforms(const anari::math::mat4 *transforms,
+                                    const uint32_t *indices,
+                                    size_t count)
+  {
+    // check all indices before touching any instance, so a bad index
+    // doesn't leave the update half-applied
+    if (indices)
+      for (size_t i=0;i<count;i++)
+        if (indices[i] >= objects.size())
+          throw std::runtime_error
+            ("#pynari: invalid instance index "+std::to_string(indices[i]));
+    for (size_t i=0;i<count;i++) {
+      size_t instID = indices ? indices[i] : i;
+      Object::SP inst = objects[instID];
+      inst->setParam("transform",ANARI_FLOAT32_MAT4,&transforms[i]);
+      inst->commit();
+    }
+  }
+
+  void InstanceArray::updateTransforms(const py::object &_transforms,
+                                       const py::object &_indices)
+  {
+    std::vector<anari::math::mat4> transforms = decodeTransforms(_transforms);
+    if (_indices.is_none()) {
+      if (transforms.size() != objects.size())
+        throw std::runtime_error
+          ("#pynari: updateTransforms() without indices needs exactly "
+           "one transform per instance");
+      py::gil_scoped_release noGIL;
+      setTransforms(transforms.data(),nullptr,transforms.size());
+      return;
+    }
+    // read as int64 first: a forcecast straight to uint32 would wrap
+    // negative indices around to (valid-looking) large ones
+    auto indices
+      = py::array_t<int64_t,py::array::c_style|py::array::forcecast>
+      ::ensure(_indices);
+    if (!indices || (size_t)indices.size() != transforms.size())
+      throw std::runtime_error
+        ("#pynari: updateTransforms() needs exactly one index per "
+         "transform");
+    std::vector<uint32_t> idx(indices.size());
+    for (size_t i=0;i<idx.size();i++) {
+      int64_t index = indices.data()[i];
+      if (index < 0 || (uint64_t)index >= objects.size())
+        throw std::runtime_error
+          ("#pynari: invalid instance index "+std::to_string(index));
+      idx[i] = (uint32_t)index;
+    }
+    py::gil_scoped_release noGIL;
+    setTransforms(transforms.data(),idx.data(),transforms.size());
+  }
+
 }
 
@@ -18,6 +18,7 @@
 
 #include "pynari/common.h"
 #include "pynari/Group.h"
+#include "pynari/Array.h"
 
 namespace pynari {
 
@@ -32,9 +33,36 @@ namespace pynari {
 
     std::string toString() const override { return "py_barn::Instance<"+type+">"; }
     ANARIDataType anariType() const override { return ANARI_INSTANCE; }
+    std::string subtype() const override { return type; }
     
     const std::string type;
     
   };
 
+  /*! an array of 'transform' instances that all instantiate the same
+      group, as created by Context::newInstances(); can be used
+      wherever an array of instances is expected (eg, as a world's
+      'instance' parameter), and allows for updating many of its
+      instances' transforms in a single call */
+  struct InstanceArray : public Array {
+    typedef std::shared_ptr<InstanceArray> SP;
+
+    InstanceArray(Device::SP device,
+                  const std::vector<Object::SP> &instances);
+    
+    std::string toString() const override { return "pynari::InstanceArray"; }
+
+    /*! set (and commit) new transforms for either all instances (if
+        'indices' is None), or for the instances with given
+        indices */
+    void updateTransforms(const py::object &transforms,
+                          const py::object &indices);
+
+    /*! set and commit the transforms of given instances, without the
+        GIL */
+    void setTransforms(const anari::math::mat4 *transforms,
+                       const uint32_t *indices,
+                       size_t count);
+  };
+
 }
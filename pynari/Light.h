@@ -29,6 +29,7 @@ namespace pynari {
     
     std::string toString() const override { return "py_barn::Light"; }
     ANARIDataType anariType() const override { return ANARI_LIGHT; }
+    std::string subtype() const override { return type; }
     
     const std::string type;
   };
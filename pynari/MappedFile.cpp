@@ -0,0 +1,103 @@
+// ======================================================================== //
+// Copyright 2024++ Ingo Wald                                               //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "pynari/MappedFile.h"
+#ifdef _WIN32
+# include <windows.h>
+#else
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
+namespace pynari {
+
+  MappedFile::SP MappedFile::open(const std::string &fileName)
+  {
+    return std::make_shared<MappedFile>(fileName);
+  }
+  
+#ifdef _WIN32
+  MappedFile::MappedFile(const std::string &fileName)
+  {
+    HANDLE file = CreateFileA(fileName.c_str(),GENERIC_READ,FILE_SHARE_READ,
+                              NULL,OPEN_EXISTING,FILE_ATTRIBUTE_NORMAL,NULL);
+    if (file == INVALID_HANDLE_VALUE)
+      throw std::runtime_error("#pynari: could not open '"+fileName+"'");
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file,&fileSize)) {
+      CloseHandle(file);
+      throw std::runtime_error("#pynari: could not stat '"+fileName+"'");
+    }
+    size = (size_t)fileSize.QuadPart;
+    if (size > 0) {
+      HANDLE mapping = CreateFileMappingA(file,NULL,PAGE_READONLY,0,0,NULL);
+      if (!mapping) {
+        CloseHandle(file);
+        throw std::runtime_error("#pynari: could not map '"+fileName+"'");
+      }
+      data = (const uint8_t *)MapViewOfFile(mapping,FILE_MAP_READ,0,0,0);
+      if (!data) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        throw std::runtime_error("#pynari: could not map '"+fileName+"'");
+      }
+      mappingHandle = mapping;
+    }
+    // only store the handles once nothing can throw any more - the
+    // destructor doesn't run for a constructor that threw
+    fileHandle = file;
+  }
+
+  MappedFile::~MappedFile()
+  {
+    if (data) UnmapViewOfFile(data);
+    if (mappingHandle) CloseHandle((HANDLE)mappingHandle);
+    if (fileHandle) CloseHandle((HANDLE)fileHandle);
+  }
+#else
+  MappedFile::MappedFile(const std::string &fileName)
+  {
+    int fd = ::open(fileName.c_str(),O_RDONLY);
+    if (fd < 0)
+      throw std::runtime_error("#pynari: could not open '"+fileName+"'");
+    struct stat st;
+    if (fstat(fd,&st) != 0) {
+      close(fd);
+      throw std::runtime_error("#pynari: could not stat '"+fileName+"'");
+    }
+    size = (size_t)st.st_size;
+    if (size > 0) {
+      void *mem = mmap(nullptr,size,PROT_READ,MAP_PRIVATE,fd,0);
+      if (mem == MAP_FAILED) {
+        close(fd);
+        throw std::runtime_error("#pynari: could not map '"+fileName+"'");
+      }
+      data = (const uint8_t *)mem;
+    }
+    // the mapping stays valid after the descriptor is closed
+    close(fd);
+  }
+
+  MappedFile::~MappedFile()
+  {
+    if (data)
+      munmap((void *)data,size);
+  }
+#endif
+
+}
@@ -0,0 +1,44 @@
+// ======================================================================== //
+// Copyright 2024++ Ingo Wald                                               //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include "pynari/common.h"
+
+namespace pynari {
+
+  /*! a file that is memory-mapped (read-only) for as long as this
+      object lives; arrays that point straight into the mapping can
+      hold on to its shared-ptr to keep it mapped */
+  struct MappedFile {
+    typedef std::shared_ptr<MappedFile> SP;
+
+    /*! map given file; throws if that isn't possible */
+    static SP open(const std::string &fileName);
+    
+    MappedFile(const std::string &fileName);
+    ~MappedFile();
+
+    const uint8_t *data = nullptr;
+    size_t         size = 0;
+  private:
+#ifdef _WIN32
+    void *fileHandle    = nullptr;
+    void *mappingHandle = nullptr;
+#endif
+  };
+
+}
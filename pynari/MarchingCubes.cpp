@@ -0,0 +1,378 @@
+// ======================================================================== //
+// Copyright 2024++ Ingo Wald                                               //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+#include "pynari/MarchingCubes.h"
+#include "pynari/Context.h"
+#include "pynari/Array.h"
+#include "pynari/parallel.h"
+
+namespace pynari {
+  namespace {
+
+    typedef py::array_t<float,py::array::c_style|py::array::forcecast>
+    FloatArray;
+
+    /* a cell's corner i is at offset (i&1,(i>>1)&1,(i>>2)&1); its
+       edge e goes from corner edgeCorner[e] along axis edgeAxis[e] */
+    const int edgeCorner[12] = { 0,2,4,6, 0,1,4,5, 0,1,2,3 };
+    const int edgeAxis[12]   = { 0,0,0,0, 1,1,1,1, 2,2,2,2 };
+
+    inline int edgeBetween(int c0, int c1)
+    {
+      const int lo = std::min(c0,c1), axis = (c0 ^ c1) == 1 ? 0 : (c0 ^ c1) == 2 ? 1 : 2;
+      for (int e=0;e<12;e++)
+        if (edgeCorner[e] == lo && edgeAxis[e] == axis) return e;
+      return -1;
+    }
+    
+    inline bool edgesShareFace(int e0, int e1)
+    {
+      const int corners[4] = {
+        edgeCorner[e0], edgeCorner[e0] | (1<<edgeAxis[e0]),
+        edgeCorner[e1], edgeCorner[e1] | (1<<edgeAxis[e1])
+      };
+      for (int axis=0;axis<3;axis++) {
+        const int side = (corners[0] >> axis) & 1;
+        bool allOnFace = true;
+        for (int i=1;i<4;i++)
+          allOnFace &= ((corners[i] >> axis) & 1) == side;
+        if (allOnFace) return true;
+      }
+      return false;
+    }
+    
+    /*! the triangles (as triplets of edges) for one cube
+        configuration, with bit i set if corner i is inside (>= the
+        isovalue) */
+    struct CubeCase {
+      int     numTriangles = 0;
+      uint8_t edges[10*3];
+    };
+
+    /*! builds the marching cubes case table, instead of spelling it
+        out: on each face of the cube, each edge where the surface
+        enters the face (walking around the face counter-clockwise,
+        seen from outside) gets connected to the next edge where it
+        leaves it; on ambiguous faces this keeps the inside corners
+        separated, which neighboring cells - that see the same face
+        - agree on, so the surface stays watertight. The resulting
+        (oriented) loops of edges then get triangulated as fans */
+    std::vector<CubeCase> buildCases()
+    {
+      std::vector<CubeCase> cases(256);
+      for (int config=0;config<256;config++) {
+        auto inside = [&](int corner) { return (config >> corner) & 1; };
+        int next[12];
+        for (int e=0;e<12;e++) next[e] = -1;
+        for (int axis=0;axis<3;axis++)
+          for (int side=0;side<2;side++) {
+            const int u = (axis+1)%3, v = (axis+2)%3;
+            int corners[4] = {
+              (side<<axis),
+              (side<<axis)|(1<<u),
+              (side<<axis)|(1<<u)|(1<<v),
+              (side<<axis)|(1<<v)
+            };
+            // counter-clockwise seen from outside; the face on the
+            // low side of an axis looks the other way
+            if (!side) std::swap(corners[1],corners[3]);
+            for (int k=0;k<4;k++) {
+              if (inside(corners[k]) || !inside(corners[(k+1)%4])) continue;
+              for (int j=1;j<4;j++) {
+                const int a = corners[(k+j)%4], b = corners[(k+j+1)%4];
+                if (inside(a) && !inside(b)) {
+                  next[edgeBetween(corners[k],corners[(k+1)%4])] = edgeBetween(a,b);
+                  break;
+                }
+              }
+            }
+          }
+        CubeCase &cc = cases[config];
+        bool done[12] = {};
+        for (int first=0;first<12;first++) {
+          if (next[first] < 0 || done[first]) continue;
+          std::vector<int> loop;
+          for (int e=first;!done[e];e=next[e]) {
+            done[e] = true;
+            loop.push_back(e);
+          }
+          // start the fan at an edge none of whose diagonals lies in
+          // a face of the cube: on an ambiguous face, the cell on the
+          // other side might pick the same diagonal, which would make
+          // the surface non-manifold
+          const size_t n = loop.size();
+          size_t start = 0;
+          for (size_t s=0;s<n;s++) {
+            bool ok = true;
+            for (size_t i=2;i+1<n;i++)
+              ok &= !edgesShareFace(loop[s],loop[(s+i)%n]);
+            if (ok) { start = s; break; }
+          }
+          for (size_t i=1;i+1<n;i++) {
+            cc.edges[3*cc.numTriangles+0] = loop[start];
+            cc.edges[3*cc.numTriangles+1] = loop[(start+i)%n];
+            cc.edges[3*cc.numTriangles+2] = loop[(start+i+1)%n];
+            cc.numTriangles++;
+          }
+        }
+      }
+      return cases;
+    }
+
+    const std::vector<CubeCase> &cubeCases()
+    {
+      static std::vector<CubeCase> cases = buildCases();
+      return cases;
+    }
+
+    /*! one isosurface over the grid */
+    struct IsoSurface {
+      IsoSurface(const float *values, const uint64_t dims[3], float isovalue)
+        : values(values), isovalue(isovalue),
+          nx(dims[0]), ny(dims[1]), nz(dims[2])
+      {}
+
+      inline bool inside(uint64_t idx) const { return values[idx] >= isovalue; }
+      inline uint64_t index(uint64_t x, uint64_t y, uint64_t z) const
+      { return x+nx*(y+ny*z); }
+      
+      /*! bit 'axis' is set if the grid edge from given point along
+          that axis crosses the surface */
+      inline int crossings(uint64_t x, uint64_t y, uint64_t z) const
+      {
+        const uint64_t idx = index(x,y,z);
+        const bool in = inside(idx);
+        return
+          (x+1 < nx && inside(idx+1)     != in ? 1 : 0) |
+          (y+1 < ny && inside(idx+nx)    != in ? 2 : 0) |
+          (z+1 < nz && inside(idx+nx*ny) != in ? 4 : 0);
+      }
+      inline int config(uint64_t x, uint64_t y, uint64_t z) const
+      {
+        int config = 0;
+        for (int c=0;c<8;c++)
+          config |= int(inside(index(x+(c&1),y+((c>>1)&1),z+(c>>2)))) << c;
+        return config;
+      }
+      
+      /*! counts vertices and triangles, without storing anything */
+      void count(uint64_t &numVertices, uint64_t &numTriangles) const
+      {
+        std::atomic<uint64_t> vertices { 0 }, triangles { 0 };
+        parallel_for(ny*nz,[&](size_t row) {
+          const uint64_t y = row % ny, z = row / ny;
+          uint64_t rowVertices = 0, rowTriangles = 0;
+          for (uint64_t x=0;x<nx;x++) {
+            const int c = crossings(x,y,z);
+            rowVertices += (c&1)+((c>>1)&1)+(c>>2);
+            if (x+1 < nx && y+1 < ny && z+1 < nz)
+              rowTriangles += cubeCases()[config(x,y,z)].numTriangles;
+          }
+          vertices  += rowVertices;
+          triangles += rowTriangles;
+        },16);
+        numVertices  = vertices;
+        numTriangles = triangles;
+      }
+
+      /*! central differences (one-sided at the boundary), in index
+          space */
+      math::float3 gradient(uint64_t x, uint64_t y, uint64_t z) const
+      {
+        const uint64_t n[3] = { nx, ny, nz }, p[3] = { x, y, z };
+        const uint64_t stride[3] = { 1, nx, nx*ny };
+        const uint64_t idx = index(x,y,z);
+        float g[3];
+        for (int d=0;d<3;d++) {
+          const uint64_t lo = p[d] > 0      ? idx-stride[d] : idx;
+          const uint64_t hi = p[d]+1 < n[d] ? idx+stride[d] : idx;
+          g[d] = (hi == lo) ? 0.f : (values[hi]-values[lo]) / float((hi-lo)/stride[d]);
+        }
+        return math::float3(g[0],g[1],g[2]);
+      }
+
+      /*! writes this surface's vertices (starting at
+          'vertexBase') and triangles (starting at 'triangleBase'),
+          using 'vertexOffsets' (one per grid point) as scratch
+          space */
+      void write(uint32_t vertexBase, uint64_t triangleBase,
+                 const math::float3 &origin, const math::float3 &spacing,
+                 std::vector<uint32_t> &vertexOffsets,
+                 math::float3 *positions, math::float3 *normals,
+                 math::uint3 *indices) const
+      {
+        // each grid point owns the (up to) three edges going up from
+        // it, so it knows where its vertices go
+        parallel_scan(nx*ny*nz,[&](size_t idx) {
+          const int c = crossings(idx%nx,(idx/nx)%ny,idx/(nx*ny));
+          return uint32_t((c&1)+((c>>1)&1)+(c>>2));
+        },vertexOffsets.data());
+        parallel_for(ny*nz,[&](size_t row) {
+          const uint64_t y = row % ny, z = row / ny;
+          for (uint64_t x=0;x<nx;x++) {
+            const int c = crossings(x,y,z);
+            if (!c) continue;
+            const uint64_t idx = index(x,y,z);
+            uint32_t out = vertexBase+vertexOffsets[idx];
+            const math::float3 g0 = gradient(x,y,z);
+            for (int axis=0;axis<3;axis++) {
+              if (!(c & (1<<axis))) continue;
+              const uint64_t other = idx + (axis==0 ? 1 : axis==1 ? nx : nx*ny);
+              const float v0 = values[idx], v1 = values[other];
+              const float t = (isovalue-v0)/(v1-v0);
+              float p[3] = { float(x), float(y), float(z) };
+              p[axis] += t;
+              positions[out] = math::float3(origin.x+p[0]*spacing.x,
+                                            origin.y+p[1]*spacing.y,
+                                            origin.z+p[2]*spacing.z);
+              const math::float3 g1 = gradient(x+(axis==0),y+(axis==1),z+(axis==2));
+              // gradient in world space, pointing to lower values
+              math::float3 n((1.f-t)*g0.x+t*g1.x,(1.f-t)*g0.y+t*g1.y,(1.f-t)*g0.z+t*g1.z);
+              n = math::float3(-n.x/spacing.x,-n.y/spacing.y,-n.z/spacing.z);
+              const float len = sqrtf(n.x*n.x+n.y*n.y+n.z*n.z);
+              normals[out] = len > 0.f
+                ? math::float3(n.x/len,n.y/len,n.z/len)
+                : math::float3(0.f,0.f,0.f);
+              out++;
+            }
+          }
+        },16);
+
+        // then triangles: count them per row of cells, so each row
+        // knows where its triangles go
+        const uint64_t numRows = (ny-1)*(nz-1);
+        std::vector<uint64_t> rowOffsets(numRows);
+        parallel_scan(numRows,[&](size_t row) {
+          const uint64_t y = row % (ny-1), z = row / (ny-1);
+          uint64_t rowTriangles = 0;
+          for (uint64_t x=0;x+1<nx;x++)
+            rowTriangles += cubeCases()[config(x,y,z)].numTriangles;
+          return rowTriangles;
+        },rowOffsets.data());
+        parallel_for(numRows,[&](size_t row) {
+          const uint64_t y = row % (ny-1), z = row / (ny-1);
+          uint64_t out = triangleBase+rowOffsets[row];
+          for (uint64_t x=0;x+1<nx;x++) {
+            const CubeCase &cc = cubeCases()[config(x,y,z)];
+            if (!cc.numTriangles) continue;
+            uint32_t edgeVertex[12];
+            for (int e=0;e<12;e++) {
+              const int corner = edgeCorner[e], axis = edgeAxis[e];
+              const uint64_t px = x+(corner&1), py = y+((corner>>1)&1), pz = z+(corner>>2);
+              const int c = crossings(px,py,pz);
+              if (!(c & (1<<axis))) continue;
+              // edges are numbered in axis order within a point
+              edgeVertex[e] = vertexBase+vertexOffsets[index(px,py,pz)]
+                + (axis > 0 && (c & 1)) + (axis > 1 && (c & 2));
+            }
+            for (int t=0;t<cc.numTriangles;t++)
+              indices[out++] = math::uint3(edgeVertex[cc.edges[3*t+0]],
+                                            edgeVertex[cc.edges[3*t+1]],
+                                            edgeVertex[cc.edges[3*t+2]]);
+          }
+        },4);
+      }
+      
+      const float   *values;
+      const float    isovalue;
+      const uint64_t nx, ny, nz;
+    };
+    
+  }
+  
+  py::dict marchingCubes(const std::shared_ptr<Context> &context,
+                         const py::buffer &_data,
+                         const py::object &_isovalues,
+                         const std::tuple<float,float,float> &_spacing,
+                         const std::tuple<float,float,float> &_origin)
+  {
+    FloatArray data = FloatArray::ensure(_data);
+    if (!data || data.ndim() != 3)
+      throw std::runtime_error
+        ("#pynari: marchingCubes: 'data' needs to be a 3D array of shape "
+         "(nz,ny,nx)");
+    const uint64_t dims[3] = {
+      (uint64_t)data.shape(2), (uint64_t)data.shape(1), (uint64_t)data.shape(0)
+    };
+    if (dims[0] < 2 || dims[1] < 2 || dims[2] < 2)
+      throw std::runtime_error("#pynari: marchingCubes: grid has no cells");
+    std::vector<float> isovalues;
+    if (py::isinstance<py::sequence>(_isovalues))
+      for (auto iso : _isovalues) isovalues.push_back(iso.cast<float>());
+    else
+      isovalues.push_back(_isovalues.cast<float>());
+    const math::float3 spacing(std::get<0>(_spacing),
+                               std::get<1>(_spacing),
+                               std::get<2>(_spacing));
+    const math::float3 origin(std::get<0>(_origin),
+                              std::get<1>(_origin),
+                              std::get<2>(_origin));
+    const float *values = data.data();
+
+    Array::SP positionArray, normalArray, indexArray;
+    {
+      py::gil_scoped_release noGIL;
+      std::vector<IsoSurface> surfaces;
+      for (float iso : isovalues)
+        surfaces.push_back(IsoSurface(values,dims,iso));
+
+      // count first, so all surfaces can go straight into the same
+      // arrays
+      std::vector<uint64_t> vertexBase(surfaces.size()+1,0);
+      std::vector<uint64_t> triangleBase(surfaces.size()+1,0);
+      for (size_t i=0;i<surfaces.size();i++) {
+        uint64_t numVertices, numTriangles;
+        surfaces[i].count(numVertices,numTriangles);
+        vertexBase[i+1]   = vertexBase[i]+numVertices;
+        triangleBase[i+1] = triangleBase[i]+numTriangles;
+      }
+      const uint64_t numVertices  = vertexBase.back();
+      const uint64_t numTriangles = triangleBase.back();
+      if (numVertices >= (1ull<<32))
+        throw std::runtime_error("#pynari: marchingCubes: surface has too "
+                                 "many vertices for 32-bit indices");
+      if (numTriangles > 0) {
+        anari::Device device = context->device->handle;
+        positionArray = context->create<Array>
+          (ANARI_FLOAT32_VEC3,std::vector<uint64_t>{ numVertices });
+        normalArray = context->create<Array>
+          (ANARI_FLOAT32_VEC3,std::vector<uint64_t>{ numVertices });
+        indexArray = context->create<Array>
+          (ANARI_UINT32_VEC3,std::vector<uint64_t>{ numTriangles });
+        math::float3 *positions = (math::float3 *)anariMapArray(device,positionArray->handle);
+        math::float3 *normals   = (math::float3 *)anariMapArray(device,normalArray->handle);
+        math::uint3 *indices   = (math::uint3 *)anariMapArray(device,indexArray->handle);
+        std::vector<uint32_t> vertexOffsets(dims[0]*dims[1]*dims[2]);
+        for (size_t i=0;i<surfaces.size();i++)
+          surfaces[i].write((uint32_t)vertexBase[i],triangleBase[i],
+                            origin,spacing,vertexOffsets,
+                            positions,normals,indices);
+        anariUnmapArray(device,positionArray->handle);
+        anariUnmapArray(device,normalArray->handle);
+        anariUnmapArray(device,indexArray->handle);
+      }
+    }
+    py::dict result;
+    if (indexArray) {
+      result["vertex.position"] = py::make_tuple((int)ANARI_ARRAY1D,positionArray);
+      result["vertex.normal"]   = py::make_tuple((int)ANARI_ARRAY1D,normalArray);
+      result["primitive.index"] = py::make_tuple((int)ANARI_ARRAY1D,indexArray);
+    }
+    return result;
+  }
+  
+}
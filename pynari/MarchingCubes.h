@@ -0,0 +1,43 @@
+// ======================================================================== //
+// Copyright 2024++ Ingo Wald                                               //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+#pragma once
+
+#include "pynari/common.h"
+
+namespace pynari {
+
+  struct Context;
+  
+  /*! extracts the isosurface(s) of a dense (nz,ny,nx) grid of
+      scalars, for one or more isovalues, as a single triangle mesh,
+      using marching cubes. Runs over all worker threads; vertices
+      on grid edges get shared between all the cells that use
+      them. Normals come from the grid's (interpolated) gradient,
+      and point towards lower values, as does each triangle's
+      winding. Returns the mesh's 'vertex.position', 'vertex.normal',
+      and 'primitive.index' arrays as a dict in the same format as
+      Object.getParameters(), which can go straight into a 'triangle'
+      geometry's setParameters(); or an empty dict if the surface is
+      empty */
+  py::dict marchingCubes(const std::shared_ptr<Context> &context,
+                         const py::buffer &data,
+                         const py::object &isovalues,
+                         const std::tuple<float,float,float> &spacing,
+                         const std::tuple<float,float,float> &origin);
+
+}
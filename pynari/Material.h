@@ -28,6 +28,7 @@ namespace pynari {
     virtual ~Material();
     std::string toString() const override { return "pynari::Material"; }
     ANARIDataType anariType() const override { return ANARI_MATERIAL; }
+    std::string subtype() const override { return type; }
     
     const std::string type;
   };
@@ -0,0 +1,365 @@
+// ======================================================================== //
+// Copyright 2024++ Ingo Wald                                               //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "pynari/MeshOptimizer.h"
+#include "pynari/parallel.h"
+#include "pynari/morton.h"
+#include <cmath>
+
+namespace pynari {
+
+  typedef py::array_t<float,py::array::c_style|py::array::forcecast>
+  FloatArray;
+  typedef py::array_t<uint32_t,py::array::c_style|py::array::forcecast>
+  IndexArray;
+
+  static const uint32_t invalidID = 0xffffffffu;
+
+  /*! one per-vertex input attribute */
+  struct Attribute {
+    FloatArray   array;
+    const float *data;
+    int          numComponents;
+  };
+
+  /*! all the per-vertex data that decides whether two vertices can
+      get welded */
+  struct WeldKeys {
+    /*! (quantized, if welding with an epsilon) position of each
+        vertex; -0 and +0 map to the same key */
+    std::vector<int64_t>     pos;
+    const std::vector<Attribute> *attributes;
+
+    bool equal(size_t a, size_t b) const
+    {
+      if (pos[3*a+0] != pos[3*b+0] ||
+          pos[3*a+1] != pos[3*b+1] ||
+          pos[3*a+2] != pos[3*b+2])
+        return false;
+      for (auto &attr : *attributes) {
+        const int n = attr.numComponents;
+        if (memcmp(attr.data+n*a,attr.data+n*b,n*sizeof(float)))
+          return false;
+      }
+      return true;
+    }
+
+    uint64_t hash(size_t i) const
+    {
+      uint64_t h = 0xcbf29ce484222325ull;
+      auto mix = [&](uint64_t v) {
+        h ^= v + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+      };
+      mix(pos[3*i+0]); mix(pos[3*i+1]); mix(pos[3*i+2]);
+      for (auto &attr : *attributes)
+        for (int c=0;c<attr.numComponents;c++) {
+          uint32_t bits;
+          memcpy(&bits,attr.data+attr.numComponents*i+c,sizeof(bits));
+          mix(bits);
+        }
+      return h;
+    }
+  };
+
+  static int64_t positionKey(float f, float weldEpsilon)
+  {
+    if (weldEpsilon > 0.f)
+      return (int64_t)std::floor(f/weldEpsilon);
+    if (f == 0.f)
+      return 0;
+    uint32_t bits;
+    memcpy(&bits,&f,sizeof(bits));
+    return bits;
+  }
+
+  /*! for each vertex, the lowest-numbered vertex it is identical
+      to */
+  static std::vector<uint32_t> weldVertices(const WeldKeys &keys,
+                                            size_t numVertices)
+  {
+    std::vector<std::pair<uint64_t,uint32_t>> sorted(numVertices);
+    parallel_for(numVertices,
+                 [&](size_t i) { sorted[i] = { keys.hash(i), (uint32_t)i }; });
+    parallel_sort(sorted);
+
+    // vertices with the same hash are now next to each other (and in
+    // ascending order); find those runs ...
+    std::vector<size_t> runBegin;
+    for (size_t i=0;i<numVertices;i++)
+      if (i == 0 || sorted[i].first != sorted[i-1].first)
+        runBegin.push_back(i);
+    runBegin.push_back(numVertices);
+
+    // ... and within each run, map each vertex to the first one it
+    // is actually identical to (hashes may collide)
+    std::vector<uint32_t> canonical(numVertices);
+    parallel_for(runBegin.size()-1,
+                 [&](size_t run) {
+                   size_t begin = runBegin[run], end = runBegin[run+1];
+                   for (size_t i=begin;i<end;i++) {
+                     uint32_t vi = sorted[i].second;
+                     canonical[vi] = vi;
+                     for (size_t j=begin;j<i;j++) {
+                       uint32_t vj = sorted[j].second;
+                       if (canonical[vj] == vj && keys.equal(vi,vj)) {
+                         canonical[vi] = vj;
+                         break;
+                       }
+                     }
+                   }
+                 },256);
+    return canonical;
+  }
+
+  static bool zeroArea(const math::float3 &a,
+                       const math::float3 &b,
+                       const math::float3 &c)
+  {
+    const float e0[3] = { b.x-a.x, b.y-a.y, b.z-a.z };
+    const float e1[3] = { c.x-a.x, c.y-a.y, c.z-a.z };
+    return
+      e0[1]*e1[2]-e0[2]*e1[1] == 0.f &&
+      e0[2]*e1[0]-e0[0]*e1[2] == 0.f &&
+      e0[0]*e1[1]-e0[1]*e1[0] == 0.f;
+  }
+
+  struct Triangle {
+    uint32_t v[3];
+    uint32_t inputID;
+  };
+
+  py::dict optimizeMesh(const py::buffer &_vertices,
+                        const py::object &_indices,
+                        const py::list &_attributes,
+                        float weldEpsilon)
+  {
+    FloatArray vertexArray = FloatArray::ensure(_vertices);
+    if (!vertexArray || vertexArray.size() % 3)
+      throw std::runtime_error
+        ("#pynari: mesh.optimize: 'vertices' need to be an array of float3s");
+    const size_t numVertices = vertexArray.size() / 3;
+    if (numVertices >= invalidID)
+      throw std::runtime_error("#pynari: mesh.optimize: too many vertices");
+    const math::float3 *vertices = (const math::float3 *)vertexArray.data();
+
+    IndexArray indexArray;
+    if (!_indices.is_none()) {
+      indexArray = IndexArray::ensure(_indices);
+      if (!indexArray || indexArray.size() % 3)
+        throw std::runtime_error
+          ("#pynari: mesh.optimize: 'indices' need to be an array of int3s");
+    } else if (numVertices % 3)
+      throw std::runtime_error
+        ("#pynari: mesh.optimize: without indices, the number of vertices "
+         "needs to be a multiple of 3");
+    const size_t numInputTriangles
+      = indexArray ? indexArray.size()/3 : numVertices/3;
+    const uint32_t *indices = indexArray ? indexArray.data() : nullptr;
+
+    std::vector<Attribute> attributes;
+    std::vector<std::vector<ssize_t>> attributeShapes;
+    for (auto item : _attributes) {
+      Attribute attr;
+      attr.array = FloatArray::ensure(item);
+      if (!attr.array || attr.array.size() == 0 || numVertices == 0
+          || attr.array.size() % numVertices)
+        throw std::runtime_error
+          ("#pynari: mesh.optimize: every attribute needs to have one "
+           "entry per vertex");
+      attr.data = attr.array.data();
+      attr.numComponents = int(attr.array.size() / numVertices);
+      attributeShapes.push_back
+        (std::vector<ssize_t>(attr.array.shape(),
+                              attr.array.shape()+attr.array.ndim()));
+      attributes.push_back(attr);
+    }
+
+    std::vector<math::float3> outVertices;
+    std::vector<uint32_t>     outIndices;
+    std::vector<std::vector<float>> outAttributes(attributes.size());
+    std::vector<uint32_t>     vertexRemap(numVertices,invalidID);
+    std::vector<uint32_t>     triangleRemap;
+    {
+      py::gil_scoped_release noGIL;
+
+      // ------------------------------------------------------------------
+      // weld vertices
+      // ------------------------------------------------------------------
+      WeldKeys keys;
+      keys.attributes = &attributes;
+      keys.pos.resize(3*numVertices);
+      parallel_for(numVertices,
+                   [&](size_t i) {
+                     for (int d=0;d<3;d++)
+                       keys.pos[3*i+d] = positionKey(vertices[i][d],weldEpsilon);
+                   });
+      std::vector<uint32_t> canonical = weldVertices(keys,numVertices);
+
+      // ------------------------------------------------------------------
+      // remap triangles, and drop degenerate ones
+      // ------------------------------------------------------------------
+      std::vector<Triangle> triangles(numInputTriangles);
+      std::vector<uint8_t>  valid(numInputTriangles);
+      parallel_for(numInputTriangles,
+                   [&](size_t t) {
+                     Triangle &tri = triangles[t];
+                     tri.inputID = (uint32_t)t;
+                     for (int k=0;k<3;k++) {
+                       uint32_t idx = indices ? indices[3*t+k] : uint32_t(3*t+k);
+                       if (idx >= numVertices)
+                         throw std::runtime_error
+                           ("#pynari: mesh.optimize: index out of range in "
+                            "triangle #"+std::to_string(t));
+                       tri.v[k] = canonical[idx];
+                     }
+                     // rotate so the smallest index comes first,
+                     // keeping the winding order - that way
+                     // duplicates have the exact same indices
+                     while (tri.v[0] > tri.v[1] || tri.v[0] > tri.v[2])
+                       std::rotate(tri.v,tri.v+1,tri.v+3);
+                     const math::float3 &a = vertices[tri.v[0]];
+                     const math::float3 &b = vertices[tri.v[1]];
+                     const math::float3 &c = vertices[tri.v[2]];
+                     valid[t]
+                       =  tri.v[0] != tri.v[1]
+                       && tri.v[1] != tri.v[2]
+                       && tri.v[0] != tri.v[2]
+                       && !zeroArea(a,b,c);
+                   });
+      {
+        size_t numValid = 0;
+        for (size_t t=0;t<numInputTriangles;t++)
+          if (valid[t]) triangles[numValid++] = triangles[t];
+        triangles.resize(numValid);
+      }
+
+      // ------------------------------------------------------------------
+      // drop duplicate triangles, keeping the first one
+      // ------------------------------------------------------------------
+      auto sameVertices = [](const Triangle &a, const Triangle &b) {
+        return a.v[0] == b.v[0] && a.v[1] == b.v[1] && a.v[2] == b.v[2];
+      };
+      parallel_sort(triangles,
+                    [](const Triangle &a, const Triangle &b) {
+                      if (a.v[0] != b.v[0]) return a.v[0] < b.v[0];
+                      if (a.v[1] != b.v[1]) return a.v[1] < b.v[1];
+                      if (a.v[2] != b.v[2]) return a.v[2] < b.v[2];
+                      return a.inputID < b.inputID;
+                    });
+      {
+        size_t numUnique = 0;
+        for (size_t t=0;t<triangles.size();t++)
+          if (t == 0 || !sameVertices(triangles[t],triangles[t-1]))
+            triangles[numUnique++] = triangles[t];
+        triangles.resize(numUnique);
+      }
+
+      // ------------------------------------------------------------------
+      // sort triangles along a morton curve over their centroids
+      // ------------------------------------------------------------------
+      const float inf = std::numeric_limits<float>::infinity();
+      math::float3 lower(+inf,+inf,+inf), upper(-inf,-inf,-inf);
+      for (auto &tri : triangles)
+        for (int k=0;k<3;k++)
+          for (int d=0;d<3;d++) {
+            lower[d] = std::min(lower[d],vertices[tri.v[k]][d]);
+            upper[d] = std::max(upper[d],vertices[tri.v[k]][d]);
+          }
+      std::vector<std::pair<uint64_t,uint32_t>> order(triangles.size());
+      parallel_for(triangles.size(),
+                   [&](size_t t) {
+                     const Triangle &tri = triangles[t];
+                     math::float3 centroid;
+                     for (int d=0;d<3;d++)
+                       centroid[d] = (vertices[tri.v[0]][d]
+                                      + vertices[tri.v[1]][d]
+                                      + vertices[tri.v[2]][d]) * (1.f/3.f);
+                     order[t] = { mortonCode(centroid,lower,upper),
+                                  (uint32_t)t };
+                   });
+      parallel_sort(order);
+
+      // ------------------------------------------------------------------
+      // number vertices in order of first use, and emit everything
+      // ------------------------------------------------------------------
+      std::vector<uint32_t> newID(numVertices,invalidID);
+      std::vector<uint32_t> usedVertices;
+      outIndices.resize(3*triangles.size());
+      triangleRemap.resize(triangles.size());
+      for (size_t t=0;t<order.size();t++) {
+        const Triangle &tri = triangles[order[t].second];
+        for (int k=0;k<3;k++) {
+          uint32_t &id = newID[tri.v[k]];
+          if (id == invalidID) {
+            id = (uint32_t)usedVertices.size();
+            usedVertices.push_back(tri.v[k]);
+          }
+          outIndices[3*t+k] = id;
+        }
+        triangleRemap[t] = tri.inputID;
+      }
+      const size_t numOutVertices = usedVertices.size();
+      outVertices.resize(numOutVertices);
+      for (size_t a=0;a<attributes.size();a++)
+        outAttributes[a].resize(numOutVertices*attributes[a].numComponents);
+      parallel_for(numOutVertices,
+                   [&](size_t i) {
+                     uint32_t in = usedVertices[i];
+                     outVertices[i] = vertices[in];
+                     for (size_t a=0;a<attributes.size();a++) {
+                       const int n = attributes[a].numComponents;
+                       memcpy(outAttributes[a].data()+n*i,
+                              attributes[a].data+n*in,
+                              n*sizeof(float));
+                     }
+                   });
+      parallel_for(numVertices,
+                   [&](size_t i) { vertexRemap[i] = newID[canonical[i]]; });
+    }
+
+    // ------------------------------------------------------------------
+    // and hand everything back as numpy arrays
+    // ------------------------------------------------------------------
+    const ssize_t numOutVertices  = (ssize_t)outVertices.size();
+    const ssize_t numOutTriangles = (ssize_t)triangleRemap.size();
+    py::dict result;
+    result["vertices"]
+      = py::array_t<float>(std::vector<ssize_t>{numOutVertices,3},
+                           (const float *)outVertices.data());
+    result["indices"]
+      = py::array_t<uint32_t>(std::vector<ssize_t>{numOutTriangles,3},
+                              outIndices.data());
+    py::list attributesOut;
+    for (size_t a=0;a<attributes.size();a++) {
+      // keep the input's shape if it had one row per vertex
+      std::vector<ssize_t> shape = attributeShapes[a];
+      if (shape[0] == (ssize_t)numVertices)
+        shape[0] = numOutVertices;
+      else if (attributes[a].numComponents == 1)
+        shape = { numOutVertices };
+      else
+        shape = { numOutVertices, attributes[a].numComponents };
+      attributesOut.append(py::array_t<float>(shape,outAttributes[a].data()));
+    }
+    result["attributes"] = attributesOut;
+    result["vertex_remap"]
+      = py::array_t<uint32_t>(vertexRemap.size(),vertexRemap.data());
+    result["triangle_remap"]
+      = py::array_t<uint32_t>(triangleRemap.size(),triangleRemap.data());
+    return result;
+  }
+
+}
@@ -0,0 +1,50 @@
+// ======================================================================== //
+// Copyright 2024++ Ingo Wald                                               //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include "pynari/common.h"
+
+namespace pynari {
+
+  /*! cleans up a triangle mesh before it gets uploaded:
+
+      - welds vertices that have the same position (or, if
+        weldEpsilon > 0, fall into the same weldEpsilon-sized grid
+        cell) and exactly the same attributes;
+
+      - drops degenerate (two or more identical vertices, or zero
+        area) and duplicate (same vertices in the same winding order)
+        triangles;
+
+      - reorders triangles along a morton curve over their centroids,
+        and vertices in order of first use, for better memory
+        locality during BVH build and traversal.
+
+      'vertices' is an (N,3) float array, 'indices' an (M,3) int
+      array or None for a non-indexed triangle soup, and 'attributes'
+      a list of per-vertex arrays with N rows each. Returns a dict
+      with the new 'vertices', 'indices' (uint32), and 'attributes'
+      arrays, plus 'vertex_remap' (for each input vertex, the output
+      vertex it became, or 0xffffffff if it got dropped) and
+      'triangle_remap' (for each output triangle, the input triangle
+      it came from) */
+  py::dict optimizeMesh(const py::buffer &vertices,
+                        const py::object &indices,
+                        const py::list &attributes,
+                        float weldEpsilon);
+
+}
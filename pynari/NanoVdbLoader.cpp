@@ -0,0 +1,440 @@
+// ======================================================================== //
+// Copyright 2024++ Ingo Wald                                               //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+#include "pynari/Context.h"
+#include "pynari/Array.h"
+#include "pynari/SpatialField.h"
+#include "pynari/MappedFile.h"
+#include "pynari/parallel.h"
+#include <cstring>
+#include <limits>
+
+/* reads NanoVDB (.nvdb) files without needing the NanoVDB headers;
+   all offsets below are those of NanoVDB's (version 32.x) in-memory
+   grid layout, which is also what its files store if uncompressed */
+
+namespace pynari {
+  namespace {
+
+    inline void nvdbError(const std::string &fileName, const std::string &what)
+    {
+      throw std::runtime_error("#pynari: loadNanoVDB('"+fileName+"'): "+what);
+    }
+
+    inline uint16_t readU16(const uint8_t *p)
+    { uint16_t v; memcpy(&v,p,sizeof(v)); return v; }
+    inline uint32_t readU32(const uint8_t *p)
+    { uint32_t v; memcpy(&v,p,sizeof(v)); return v; }
+    inline uint64_t readU64(const uint8_t *p)
+    { uint64_t v; memcpy(&v,p,sizeof(v)); return v; }
+    inline int32_t readI32(const uint8_t *p)
+    { int32_t v; memcpy(&v,p,sizeof(v)); return v; }
+    inline int64_t readI64(const uint8_t *p)
+    { int64_t v; memcpy(&v,p,sizeof(v)); return v; }
+    inline float readF32(const uint8_t *p)
+    { float v; memcpy(&v,p,sizeof(v)); return v; }
+    inline double readF64(const uint8_t *p)
+    { double v; memcpy(&v,p,sizeof(v)); return v; }
+
+    /*! whether [begin,begin+count) lies within [0,size); written such
+        that neither sum can overflow for arbitrary (untrusted) file
+        offsets */
+    inline bool inBounds(uint64_t begin, uint64_t count, uint64_t size)
+    { return begin <= size && count <= size-begin; }
+
+    /*! all nanovdb magic numbers are "NanoVDB" followed by a digit */
+    inline bool isNanoVdbMagic(const uint8_t *p)
+    { return memcmp(p,"NanoVDB",7) == 0; }
+    
+    enum {
+      FILE_HEADER_SIZE = 16,
+      FILE_META_SIZE   = 176,
+      GRID_DATA_SIZE   = 672,
+      GRID_TYPE_FLOAT  = 1,
+      CODEC_NONE       = 0,
+      
+      // root, with float values, and its tiles
+      ROOT_DATA_SIZE   = 64,
+      ROOT_TILE_SIZE   = 32,
+      // upper and lower internal nodes, and leaves; each as
+      // (log2 of dims, log2 of the size of what it covers)
+      UPPER_LOG2DIM    = 5, UPPER_TOTAL = 12,
+      LOWER_LOG2DIM    = 4, LOWER_TOTAL = 7,
+      LEAF_LOG2DIM     = 3, LEAF_TOTAL  = 3,
+      LEAF_VALUES      = 96,
+      LEAF_SIZE        = LEAF_VALUES+4*512,
+    };
+    /*! offsets of an internal node's child mask and table, and its
+        size, given its log2 dims */
+    inline size_t childMaskOffset(int log2dim) { return 32+(1u<<(3*log2dim))/8; }
+    inline size_t tableOffset(int log2dim) { return 64+2*(1u<<(3*log2dim))/8; }
+    inline size_t nodeSize(int log2dim) { return tableOffset(log2dim)+8*(1u<<(3*log2dim)); }
+    
+    inline bool maskBit(const uint8_t *mask, uint32_t n)
+    { return (mask[n>>3] >> (n&7)) & 1; }
+
+    /*! the one grid of a file that gets loaded */
+    struct NanoVdbGrid {
+      std::string    name;
+      /*! the grid's (in-memory layout) data, and its size */
+      const uint8_t *data = nullptr;
+      size_t         size = 0;
+      int            type = 0;
+    };
+
+    /*! checks that the root (with its tile table) and all node
+        arrays of a float grid's tree lie within the grid, so neither
+        we nor the device ever read past it */
+    void checkTree(const std::string &fileName, const NanoVdbGrid &grid)
+    {
+      const uint8_t *tree = grid.data+GRID_DATA_SIZE;
+      const uint64_t treeSize = grid.size-GRID_DATA_SIZE;
+      const uint64_t rootOffset = readU64(tree+24);
+      if (!inBounds(rootOffset,ROOT_DATA_SIZE,treeSize))
+        nvdbError(fileName,"grid '"+grid.name+"' has a corrupt root");
+      const uint64_t tableSize = readU32(tree+rootOffset+24);
+      if (!inBounds(rootOffset,ROOT_DATA_SIZE+tableSize*ROOT_TILE_SIZE,treeSize))
+        nvdbError(fileName,"grid '"+grid.name+"' has a corrupt root");
+      // node counts are 32-bit, so none of the products can overflow
+      const struct { int offset; int count; uint64_t size; } nodes[] = {
+        { 0,  32, LEAF_SIZE },
+        { 8,  36, nodeSize(LOWER_LOG2DIM) },
+        { 16, 40, nodeSize(UPPER_LOG2DIM) },
+      };
+      for (auto &node : nodes) {
+        const uint64_t count = readU32(tree+node.count);
+        if (count != 0 &&
+            !inBounds(readU64(tree+node.offset),count*node.size,treeSize))
+          nvdbError(fileName,"grid '"+grid.name+"' has corrupt tree nodes");
+      }
+    }
+
+    /*! finds the grid with given name (or, if that's empty, the
+        index'th grid, or - if that's negative - the first float grid)
+        in the file */
+    NanoVdbGrid findGrid(const std::string &fileName,
+                         const MappedFile &file,
+                         const std::string &gridName,
+                         int gridIndex)
+    {
+      // a file is a sequence of segments, each of which is a header,
+      // the meta data and names of all its grids, then the grids
+      size_t pos = 0;
+      int index = 0;
+      std::vector<std::string> names;
+      while (inBounds(pos,FILE_HEADER_SIZE,file.size)) {
+        const uint8_t *header = file.data+pos;
+        if (!isNanoVdbMagic(header))
+          nvdbError(fileName,"not a nanovdb file");
+        const uint32_t version = readU32(header+8);
+        if ((version >> 21) != 32)
+          nvdbError(fileName,"unsupported nanovdb version "
+                    +std::to_string(version >> 21)+"."
+                    +std::to_string((version >> 10) & 0x7ff));
+        const int gridCount = readU16(header+12);
+        const int codec     = readU16(header+14);
+        pos += FILE_HEADER_SIZE;
+
+        std::vector<NanoVdbGrid> grids(gridCount);
+        std::vector<uint64_t>    fileSizes(gridCount);
+        for (auto &grid : grids) {
+          if (!inBounds(pos,FILE_META_SIZE,file.size))
+            nvdbError(fileName,"file truncated");
+          const uint8_t *meta = file.data+pos;
+          grid.size = readU64(meta+0);
+          fileSizes[&grid-grids.data()] = readU64(meta+8);
+          grid.type = readU32(meta+32);
+          const uint32_t nameSize = readU32(meta+136);
+          pos += FILE_META_SIZE;
+          if (!inBounds(pos,nameSize,file.size))
+            nvdbError(fileName,"file truncated");
+          grid.name = std::string((const char *)file.data+pos,
+                                  strnlen((const char *)file.data+pos,nameSize));
+          pos += nameSize;
+        }
+        for (int i=0;i<gridCount;i++) {
+          NanoVdbGrid &grid = grids[i];
+          if (!inBounds(pos,fileSizes[i],file.size))
+            nvdbError(fileName,"file truncated");
+          grid.data = file.data+pos;
+          pos += fileSizes[i];
+          names.push_back("'"+grid.name+"'");
+          const bool match
+            = !gridName.empty() ? grid.name == gridName
+            : gridIndex >= 0    ? index == gridIndex
+            :                     grid.type == GRID_TYPE_FLOAT;
+          index++;
+          if (!match)
+            continue;
+          if (codec != CODEC_NONE)
+            nvdbError(fileName,"grid '"+grid.name+"' is compressed; only "
+                      "uncompressed nanovdb files are supported");
+          if (grid.type != GRID_TYPE_FLOAT)
+            nvdbError(fileName,"grid '"+grid.name+"' is not a float grid");
+          // (uncompressed grids are stored as is, so the grid has to
+          // fit the part of the file it was stored in)
+          if (grid.size < GRID_DATA_SIZE+64 || grid.size > fileSizes[i]
+              || !isNanoVdbMagic(grid.data))
+            nvdbError(fileName,"grid '"+grid.name+"' is corrupt");
+          checkTree(fileName,grid);
+          return grid;
+        }
+      }
+      std::string list;
+      for (auto &name : names) list += (list.empty()?"":", ")+name;
+      nvdbError(fileName,"no "
+                +(!gridName.empty() ? "grid '"+gridName+"'"
+                  : gridIndex >= 0  ? "grid "+std::to_string(gridIndex)
+                  :                   std::string("float grid"))
+                +" in file (grids are: "+list+")");
+      return {};
+    }
+
+    /*! writes a float grid's values into a dense array that covers
+        [lower,lower+dims) in index space; everything that is neither
+        in a leaf nor a tile becomes the background value */
+    struct Densifier {
+      Densifier(const uint8_t *grid, const int32_t lower[3],
+                const uint64_t dims[3], float *out)
+        : tree(grid+GRID_DATA_SIZE), out(out)
+      {
+        for (int d=0;d<3;d++) {
+          this->lower[d] = lower[d];
+          this->dims[d] = dims[d];
+        }
+        root = tree+readU64(tree+24);
+        background = readF32(root+28);
+      }
+
+      /*! fills the part of the index-space cube [begin,begin+size)
+          that overlaps the output with 'value' */
+      void fillBox(const int32_t begin[3], int32_t size, float value,
+                   bool inParallel)
+      {
+        auto fillSlice = [&](size_t z) {
+          for (int32_t y=0;y<size;y++) {
+            const int32_t row[3] = { begin[0], begin[1]+y, begin[2]+int32_t(z) };
+            fillRow(row,size,value);
+          }
+        };
+        if (inParallel)
+          parallel_for(size,fillSlice,1);
+        else
+          for (int32_t z=0;z<size;z++) fillSlice(z);
+      }
+
+      /*! fills the part of the row [begin,begin+size) (along x) that
+          overlaps the output with 'value' */
+      void fillRow(const int32_t begin[3], int32_t size, float value)
+      {
+        const int64_t y = int64_t(begin[1]) - lower[1];
+        const int64_t z = int64_t(begin[2]) - lower[2];
+        if (y < 0 || y >= (int64_t)dims[1] || z < 0 || z >= (int64_t)dims[2])
+          return;
+        const int64_t lo = std::max<int64_t>(begin[0],lower[0]) - lower[0];
+        const int64_t hi = std::min<int64_t>(int64_t(begin[0])+size,
+                                             int64_t(lower[0])+dims[0]) - lower[0];
+        if (lo < hi)
+          std::fill(out+lo+dims[0]*(y+dims[1]*z),
+                    out+hi+dims[0]*(y+dims[1]*z),value);
+      }
+
+      /*! fills all of an internal node's tiles that aren't background */
+      void fillTiles(const uint8_t *node, int log2dim, int childTotal,
+                     bool inParallel)
+      {
+        const int32_t origin[3] = {
+          readI32(node+0) & ~((1<<(childTotal+log2dim))-1),
+          readI32(node+4) & ~((1<<(childTotal+log2dim))-1),
+          readI32(node+8) & ~((1<<(childTotal+log2dim))-1)
+        };
+        const uint8_t *childMask = node+childMaskOffset(log2dim);
+        const uint8_t *table     = node+tableOffset(log2dim);
+        const uint32_t dim = 1u<<log2dim;
+        for (uint32_t n=0;n<dim*dim*dim;n++) {
+          if (maskBit(childMask,n)) continue;
+          const float value = readF32(table+8*n);
+          if (value == background) continue;
+          // tables are x-major
+          const int32_t begin[3] = {
+            origin[0]+int32_t((n >> (2*log2dim))       << childTotal),
+            origin[1]+int32_t(((n >> log2dim) & (dim-1)) << childTotal),
+            origin[2]+int32_t((n & (dim-1))             << childTotal)
+          };
+          fillBox(begin,1<<childTotal,value,inParallel);
+        }
+      }
+
+      /*! copies one leaf's values (which are x-major) */
+      void copyLeaf(const uint8_t *leaf)
+      {
+        int64_t origin[3];
+        for (int d=0;d<3;d++)
+          origin[d] = (readI32(leaf+4*d) & ~7) - int64_t(lower[d]);
+        const uint8_t *values = leaf+LEAF_VALUES;
+        for (int x=0;x<8;x++) {
+          const int64_t ox = origin[0]+x;
+          if (ox < 0 || ox >= (int64_t)dims[0]) continue;
+          for (int y=0;y<8;y++) {
+            const int64_t oy = origin[1]+y;
+            if (oy < 0 || oy >= (int64_t)dims[1]) continue;
+            for (int z=0;z<8;z++) {
+              const int64_t oz = origin[2]+z;
+              if (oz < 0 || oz >= (int64_t)dims[2]) continue;
+              out[ox+dims[0]*(oy+dims[1]*oz)]
+                = readF32(values+4*((x<<6)|(y<<3)|z));
+            }
+          }
+        }
+      }
+
+      void run()
+      {
+        const uint64_t numVoxels = dims[0]*dims[1]*dims[2];
+        parallel_for_blocked(numVoxels,1<<20,[&](size_t begin, size_t end) {
+          std::fill(out+begin,out+end,background);
+        });
+
+        // tiles of the root and the upper nodes are large, so fill
+        // those one after another, each in parallel ...
+        const uint32_t tableSize = readU32(root+24);
+        for (uint32_t i=0;i<tableSize;i++) {
+          const uint8_t *tile = root+ROOT_DATA_SIZE+i*ROOT_TILE_SIZE;
+          if (readI64(tile+8) != 0) continue;
+          const float value = readF32(tile+20);
+          if (value == background) continue;
+          const uint64_t key = readU64(tile+0);
+          const uint32_t mask = (1u<<21)-1;
+          const int32_t begin[3] = {
+            int32_t(uint32_t((key >> 42) & mask) << UPPER_TOTAL),
+            int32_t(uint32_t((key >> 21) & mask) << UPPER_TOTAL),
+            int32_t(uint32_t(key & mask) << UPPER_TOTAL)
+          };
+          fillBox(begin,1<<UPPER_TOTAL,value,true);
+        }
+        const uint32_t numUpper = readU32(tree+32+8);
+        const uint8_t *upperNodes = tree+readU64(tree+16);
+        for (uint32_t i=0;i<numUpper;i++)
+          fillTiles(upperNodes+i*nodeSize(UPPER_LOG2DIM),
+                    UPPER_LOG2DIM,LOWER_TOTAL,true);
+        // ... while lower nodes' tiles and leaves are small enough to
+        // do one node per task
+        const uint32_t numLower = readU32(tree+32+4);
+        const uint8_t *lowerNodes = tree+readU64(tree+8);
+        parallel_for(numLower,[&](size_t i) {
+          fillTiles(lowerNodes+i*nodeSize(LOWER_LOG2DIM),
+                    LOWER_LOG2DIM,LEAF_TOTAL,false);
+        },16);
+        const uint32_t numLeaves = readU32(tree+32);
+        const uint8_t *leaves = tree+readU64(tree+0);
+        parallel_for(numLeaves,[&](size_t i) {
+          copyLeaf(leaves+i*LEAF_SIZE);
+        },64);
+      }
+
+      const uint8_t *tree;
+      const uint8_t *root;
+      float         *out;
+      float          background;
+      int32_t        lower[3];
+      uint64_t       dims[3];
+    };
+    
+  }
+
+  std::shared_ptr<SpatialField>
+  Context::loadNanoVDB(const std::string &fileName,
+                       const py::object &gridSelector,
+                       const py::object &sparse)
+  {
+    std::string gridName;
+    int gridIndex = -1;
+    if (py::isinstance<py::str>(gridSelector))
+      gridName = gridSelector.cast<std::string>();
+    else if (!gridSelector.is_none())
+      gridIndex = gridSelector.cast<int>();
+    
+    bool useSparse;
+    {
+      std::vector<std::string> subtypes = getObjectSubtypes(ANARI_SPATIAL_FIELD);
+      const bool haveSparse
+        = std::find(subtypes.begin(),subtypes.end(),"nanovdb") != subtypes.end();
+      if (sparse.is_none())
+        useSparse = haveSparse;
+      else {
+        useSparse = sparse.cast<bool>();
+        if (useSparse && !haveSparse)
+          nvdbError(fileName,"device does not support 'nanovdb' spatial fields");
+      }
+    }
+    
+    py::gil_scoped_release noGIL;
+    MappedFile::SP file = MappedFile::open(fileName);
+    NanoVdbGrid grid = findGrid(fileName,*file,gridName,gridIndex);
+
+    if (useSparse) {
+      // hand the device the grid itself, straight out of the mapped
+      // file
+      auto array = create<Array>(ANARI_UINT8,std::vector<uint64_t>{ grid.size },
+                                 grid.data,file);
+      auto field = create<SpatialField>("nanovdb");
+      field->setParam("data",ANARI_ARRAY1D,&array->handle,array);
+      field->commit();
+      return field;
+    }
+
+    // densify the root's (index space) bounding box of active values
+    const uint8_t *tree = grid.data+GRID_DATA_SIZE;
+    const uint8_t *root = tree+readU64(tree+24);
+    int32_t lower[3];
+    uint64_t dims[3];
+    for (int d=0;d<3;d++) {
+      lower[d] = readI32(root+4*d);
+      const int32_t upper = readI32(root+12+4*d);
+      if (upper < lower[d])
+        nvdbError(fileName,"grid '"+grid.name+"' has no active values");
+      dims[d] = uint64_t(int64_t(upper)-lower[d]+1);
+    }
+    // each of the dims fits 33 bits, but their product may not fit
+    // anything; reject what couldn't even be addressed
+    const uint64_t maxVoxels = std::numeric_limits<size_t>::max()/sizeof(float);
+    if (dims[0] > maxVoxels/dims[1] || dims[0]*dims[1] > maxVoxels/dims[2])
+      nvdbError(fileName,"grid '"+grid.name+"' is too large to densify");
+    auto array = create<Array>(ANARI_FLOAT32,
+                               std::vector<uint64_t>{ dims[0],dims[1],dims[2] });
+    float *out = (float *)anariMapArray(device->handle,array->handle);
+    Densifier(grid.data,lower,dims,out).run();
+    anariUnmapArray(device->handle,array->handle);
+
+    // index-to-world map; nanovdb stores it as a 3x3 matrix (of
+    // which we only use the diagonal, ie, scale) plus translation
+    const uint8_t *map = grid.data+296;
+    math::float3 spacing((float)readF64(map+88+0*8),
+                         (float)readF64(map+88+4*8),
+                         (float)readF64(map+88+8*8));
+    math::float3 origin((float)readF64(map+232+0)+lower[0]*spacing.x,
+                        (float)readF64(map+232+8)+lower[1]*spacing.y,
+                        (float)readF64(map+232+16)+lower[2]*spacing.z);
+    auto field = create<SpatialField>("structuredRegular");
+    field->setParam("origin",ANARI_FLOAT32_VEC3,&origin);
+    field->setParam("spacing",ANARI_FLOAT32_VEC3,&spacing);
+    field->setParam("data",ANARI_ARRAY3D,&array->handle,array);
+    field->commit();
+    return field;
+  }
+  
+}
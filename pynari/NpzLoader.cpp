@@ -0,0 +1,512 @@
+// ======================================================================== //
+// Copyright 2024++ Ingo Wald                                               //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "pynari/Context.h"
+#include "pynari/Array.h"
+#include "pynari/Inflate.h"
+#include "pynari/MappedFile.h"
+#include "pynari/parallel.h"
+#include <cstring>
+
+namespace pynari {
+  namespace {
+
+    inline void npyError(const std::string &fileName, const std::string &what)
+    {
+      throw std::runtime_error("#pynari: loadArrays('"+fileName+"'): "+what);
+    }
+    
+    inline uint16_t readU16(const uint8_t *p)
+    { return uint16_t(p[0]) | (uint16_t(p[1]) << 8); }
+    inline uint32_t readU32(const uint8_t *p)
+    { return uint32_t(readU16(p)) | (uint32_t(readU16(p+2)) << 16); }
+    inline uint64_t readU64(const uint8_t *p)
+    { return uint64_t(readU32(p)) | (uint64_t(readU32(p+4)) << 32); }
+
+    /*! whether [begin,begin+count) lies within [0,size); written such
+        that neither sum can overflow for arbitrary (untrusted) file
+        offsets */
+    inline bool inBounds(uint64_t begin, uint64_t count, uint64_t size)
+    { return begin <= size && count <= size-begin; }
+
+    /*! what the header of a .npy blob says about its data */
+    struct NpyHeader {
+      /*! numpy's type 'kind' - 'f', 'i', 'u', or 'b' */
+      char kind = 0;
+      int  scalarSize = 0;
+      bool byteSwap = false;
+      bool fortranOrder = false;
+      std::vector<uint64_t> shape;
+      /*! offset of the data from the start of the .npy blob */
+      size_t dataOffset = 0;
+    };
+
+    /*! one .npy blob to load - either the whole file, or one member
+        of a .npz archive */
+    struct NpyMember {
+      std::string    name;
+      /*! compression method as per zip: 0 is stored, 8 is deflate */
+      int            method = 0;
+      const uint8_t *compressed = nullptr;
+      size_t         compressedSize = 0;
+      /*! the (uncompressed) .npy blob */
+      const uint8_t *begin = nullptr;
+      size_t         size = 0;
+      std::shared_ptr<std::vector<uint8_t>> inflated;
+      
+      NpyHeader       header;
+      anari::DataType type = ANARI_UNKNOWN;
+      std::vector<uint64_t> dims;
+      size_t          numScalars = 0;
+      Array::SP       array;
+    };
+
+    /*! finds the value string following given key in a .npy header
+        dict, i.e., everything up to the next ',' or '}' that isn't
+        within parentheses */
+    std::string headerValue(const std::string &header, const std::string &key)
+    {
+      size_t pos = header.find("'"+key+"'");
+      if (pos == header.npos) pos = header.find("\""+key+"\"");
+      if (pos == header.npos) return "";
+      pos = header.find(':',pos);
+      if (pos == header.npos) return "";
+      std::string value;
+      int depth = 0;
+      for (++pos;pos<header.size();pos++) {
+        char c = header[pos];
+        if (c == '(') depth++;
+        if (c == ')') depth--;
+        if (depth == 0 && (c == ',' || c == '}')) break;
+        if (c != ' ' && c != '\'' && c != '"') value += c;
+      }
+      return value;
+    }
+    
+    NpyHeader parseNpyHeader(const std::string &fileName,
+                             const std::string &name,
+                             const uint8_t *npy, size_t size)
+    {
+      if (size < 10 || memcmp(npy,"\x93NUMPY",6) != 0)
+        npyError(fileName,"'"+name+"' is not a .npy array");
+      NpyHeader result;
+      size_t headerLen;
+      if (npy[6] == 1) {
+        headerLen = readU16(npy+8);
+        result.dataOffset = 10+headerLen;
+      } else {
+        if (size < 12) npyError(fileName,"truncated header in '"+name+"'");
+        headerLen = readU32(npy+8);
+        result.dataOffset = 12+headerLen;
+      }
+      if (result.dataOffset > size)
+        npyError(fileName,"truncated header in '"+name+"'");
+      std::string header((const char *)npy+result.dataOffset-headerLen,headerLen);
+
+      std::string descr = headerValue(header,"descr");
+      if (descr.size() < 3)
+        npyError(fileName,"unsupported dtype '"+descr+"' in '"+name+"'");
+      // assume a little-endian host, like all platforms anari runs on
+      result.byteSwap   = (descr[0] == '>');
+      result.kind       = descr[1];
+      result.scalarSize = atoi(descr.c_str()+2);
+      // only accept what convert() can handle, so nothing can fail
+      // once arrays got created and mapped
+      const int size = result.scalarSize;
+      const bool supported
+        = result.kind == 'f' ? (size == 4 || size == 8)
+        : result.kind == 'b' ? (size == 1)
+        : (result.kind == 'i' || result.kind == 'u')
+        ? (size == 1 || size == 2 || size == 4 || size == 8)
+        : false;
+      if (!supported)
+        npyError(fileName,"unsupported dtype '"+descr+"' in '"+name+"'");
+      
+      result.fortranOrder = (headerValue(header,"fortran_order") == "True");
+      
+      std::string shape = headerValue(header,"shape");
+      for (size_t pos=0;pos<shape.size();) {
+        if (!isdigit(shape[pos])) { pos++; continue; }
+        size_t end = pos;
+        while (end < shape.size() && isdigit(shape[end])) end++;
+        result.shape.push_back(std::stoull(shape.substr(pos,end-pos)));
+        pos = end;
+      }
+      return result;
+    }
+
+    /*! the anari scalar type numpy data of given kind and size gets
+        loaded as if the user didn't ask for anything else */
+    anari::DataType defaultScalarType(const NpyHeader &h)
+    {
+      switch (h.kind) {
+      case 'f':
+        if (h.scalarSize == 4 || h.scalarSize == 8) return ANARI_FLOAT32;
+        break;
+      case 'i':
+        if (h.scalarSize <= 8) return ANARI_INT32;
+        break;
+      case 'u':
+        if (h.scalarSize == 1) return ANARI_UINT8;
+        if (h.scalarSize == 2) return ANARI_UINT16;
+        if (h.scalarSize <= 8) return ANARI_UINT32;
+        break;
+      case 'b':
+        if (h.scalarSize == 1) return ANARI_UINT8;
+        break;
+      }
+      return ANARI_UNKNOWN;
+    }
+
+    /*! splits an anari (vector) type into its scalar type and number
+        of components; returns false for anything we can't load into */
+    bool splitVectorType(anari::DataType type,
+                         anari::DataType &scalarType, int &numComponents)
+    {
+      // vector types directly follow their scalar type in anari's enum
+      for (anari::DataType base : { ANARI_FLOAT32, ANARI_INT32, ANARI_UINT32,
+                                    ANARI_UINT8, ANARI_UINT16,
+                                    ANARI_UFIXED8, ANARI_UFIXED16 })
+        if (type >= base && type < base+4) {
+          scalarType    = base;
+          numComponents = type-base+1;
+          return true;
+        }
+      return false;
+    }
+    
+    template<typename Src>
+    inline Src loadScalar(const uint8_t *src, bool byteSwap)
+    {
+      Src v;
+      if (byteSwap) {
+        uint8_t swapped[sizeof(Src)];
+        for (size_t i=0;i<sizeof(Src);i++)
+          swapped[i] = src[sizeof(Src)-1-i];
+        memcpy(&v,swapped,sizeof(Src));
+      } else
+        memcpy(&v,src,sizeof(Src));
+      return v;
+    }
+    
+    template<typename Dst, typename Src>
+    void convertT(const uint8_t *src, bool byteSwap, Dst *dst, size_t count)
+    {
+      parallel_for_blocked
+        (count,64*1024,
+         [&](size_t begin, size_t end) {
+           for (size_t i=begin;i<end;i++)
+             dst[i] = (Dst)loadScalar<Src>(src+i*sizeof(Src),byteSwap);
+         });
+    }
+
+    template<typename Dst>
+    void convertTo(const NpyHeader &h, const uint8_t *src, Dst *dst, size_t count)
+    {
+      switch (h.kind == 'b' ? 'u' : h.kind) {
+      case 'f':
+        if (h.scalarSize == 4) return convertT<Dst,float>(src,h.byteSwap,dst,count);
+        if (h.scalarSize == 8) return convertT<Dst,double>(src,h.byteSwap,dst,count);
+        break;
+      case 'i':
+        if (h.scalarSize == 1) return convertT<Dst,int8_t>(src,h.byteSwap,dst,count);
+        if (h.scalarSize == 2) return convertT<Dst,int16_t>(src,h.byteSwap,dst,count);
+        if (h.scalarSize == 4) return convertT<Dst,int32_t>(src,h.byteSwap,dst,count);
+        if (h.scalarSize == 8) return convertT<Dst,int64_t>(src,h.byteSwap,dst,count);
+        break;
+      case 'u':
+        if (h.scalarSize == 1) return convertT<Dst,uint8_t>(src,h.byteSwap,dst,count);
+        if (h.scalarSize == 2) return convertT<Dst,uint16_t>(src,h.byteSwap,dst,count);
+        if (h.scalarSize == 4) return convertT<Dst,uint32_t>(src,h.byteSwap,dst,count);
+        if (h.scalarSize == 8) return convertT<Dst,uint64_t>(src,h.byteSwap,dst,count);
+        break;
+      }
+      throw std::runtime_error("#pynari: cannot convert numpy dtype '"
+                               +std::string(1,h.kind)
+                               +std::to_string(h.scalarSize)+"'");
+    }
+
+    /*! converts 'count' numpy scalars to given anari scalar type */
+    void convert(const NpyHeader &h, const uint8_t *src,
+                 anari::DataType scalarType, void *dst, size_t count)
+    {
+      switch (scalarType) {
+      case ANARI_FLOAT32:
+        return convertTo(h,src,(float *)dst,count);
+      case ANARI_INT32:
+        return convertTo(h,src,(int32_t *)dst,count);
+      case ANARI_UINT32:
+        return convertTo(h,src,(uint32_t *)dst,count);
+      case ANARI_UINT8:
+      case ANARI_UFIXED8:
+        return convertTo(h,src,(uint8_t *)dst,count);
+      case ANARI_UINT16:
+      case ANARI_UFIXED16:
+        return convertTo(h,src,(uint16_t *)dst,count);
+      default:
+        throw std::runtime_error("#pynari: cannot load arrays of type "
+                                 +to_string(scalarType));
+      }
+    }
+
+    /*! whether numpy data with given header can be used as anari
+        data of given scalar type as is */
+    bool sameLayout(const NpyHeader &h, anari::DataType scalarType)
+    {
+      if (h.byteSwap) return false;
+      switch (scalarType) {
+      case ANARI_FLOAT32:
+        return h.kind == 'f' && h.scalarSize == 4;
+      case ANARI_INT32:
+        return h.kind == 'i' && h.scalarSize == 4;
+      case ANARI_UINT32:
+        return h.kind == 'u' && h.scalarSize == 4;
+      case ANARI_UINT8:
+      case ANARI_UFIXED8:
+        return (h.kind == 'u' || h.kind == 'b') && h.scalarSize == 1;
+      case ANARI_UINT16:
+      case ANARI_UFIXED16:
+        return h.kind == 'u' && h.scalarSize == 2;
+      default:
+        return false;
+      }
+    }
+
+    /*! collects the .npy members of a .npz (zip) archive */
+    std::vector<NpyMember> listNpzMembers(const std::string &fileName,
+                                          const MappedFile &file)
+    {
+      const uint8_t *data = file.data;
+      const size_t   size = file.size;
+      // end-of-central-directory record is at the very end, followed
+      // by a comment of at most 64k
+      if (size < 22) npyError(fileName,"not a zip/npz archive");
+      size_t eocd = size-22;
+      while (readU32(data+eocd) != 0x06054b50) {
+        if (eocd == 0 || size-eocd > 22+0xffff)
+          npyError(fileName,"not a zip/npz archive");
+        --eocd;
+      }
+      uint64_t numEntries = readU16(data+eocd+10);
+      uint64_t dirOffset  = readU32(data+eocd+16);
+      if (numEntries == 0xffff || dirOffset == 0xffffffff) {
+        // zip64 - numpy writes those for large arrays
+        if (eocd < 20 || readU32(data+eocd-20) != 0x07064b50)
+          npyError(fileName,"missing zip64 locator");
+        uint64_t eocd64 = readU64(data+eocd-20+8);
+        if (!inBounds(eocd64,56,size) || readU32(data+eocd64) != 0x06064b50)
+          npyError(fileName,"corrupt zip64 directory");
+        numEntries = readU64(data+eocd64+32);
+        dirOffset  = readU64(data+eocd64+48);
+      }
+
+      std::vector<NpyMember> members;
+      uint64_t pos = dirOffset;
+      for (uint64_t entry=0;entry<numEntries;entry++) {
+        if (!inBounds(pos,46,size) || readU32(data+pos) != 0x02014b50)
+          npyError(fileName,"corrupt zip directory");
+        uint16_t flags      = readU16(data+pos+8);
+        uint16_t method     = readU16(data+pos+10);
+        uint64_t compSize   = readU32(data+pos+20);
+        uint64_t npySize    = readU32(data+pos+24);
+        uint16_t nameLen    = readU16(data+pos+28);
+        uint16_t extraLen   = readU16(data+pos+30);
+        uint16_t commentLen = readU16(data+pos+32);
+        uint64_t offset     = readU32(data+pos+42);
+        if (!inBounds(pos+46,uint64_t(nameLen)+extraLen+commentLen,size))
+          npyError(fileName,"corrupt zip directory");
+        std::string name((const char *)data+pos+46,nameLen);
+
+        // zip64 extra field holds whichever of these didn't fit
+        const uint8_t *extra = data+pos+46+nameLen;
+        for (size_t e=0;e+4<=extraLen;) {
+          uint16_t id  = readU16(extra+e);
+          uint16_t len = readU16(extra+e+2);
+          if (e+4+len > extraLen)
+            npyError(fileName,"corrupt zip64 extra field for '"+name+"'");
+          if (id == 0x0001) {
+            const uint8_t *field = extra+e+4;
+            const uint8_t *end   = field+len;
+            for (uint64_t *value : { &npySize, &compSize, &offset }) {
+              if (*value != 0xffffffff) continue;
+              if (end-field < 8)
+                npyError(fileName,"corrupt zip64 extra field for '"+name+"'");
+              *value = readU64(field);
+              field += 8;
+            }
+          }
+          e += 4+len;
+        }
+        pos += 46+nameLen+extraLen+commentLen;
+
+        const std::string suffix = ".npy";
+        if (name.size() <= suffix.size() ||
+            name.compare(name.size()-suffix.size(),suffix.size(),suffix) != 0)
+          continue;
+        if (flags & 1)
+          npyError(fileName,"'"+name+"' is encrypted");
+        if (method != 0 && method != 8)
+          npyError(fileName,"'"+name+"' uses unsupported compression method "
+                   +std::to_string(method));
+        if (!inBounds(offset,30,size) || readU32(data+offset) != 0x04034b50)
+          npyError(fileName,"corrupt local header for '"+name+"'");
+        uint64_t dataBegin
+          = offset+30+readU16(data+offset+26)+readU16(data+offset+28);
+        if (!inBounds(dataBegin,compSize,size))
+          npyError(fileName,"'"+name+"' is truncated");
+        // a stored member's .npy blob *is* its compressed data, so the
+        // two sizes have to agree - else we'd read past the member
+        if (method == 0 && npySize != compSize)
+          npyError(fileName,"inconsistent sizes for stored '"+name+"'");
+        
+        NpyMember member;
+        member.name           = name.substr(0,name.size()-suffix.size());
+        member.method         = method;
+        member.compressed     = data+dataBegin;
+        member.compressedSize = compSize;
+        member.size           = npySize;
+        if (method == 0) member.begin = member.compressed;
+        members.push_back(member);
+      }
+      return members;
+    }
+
+    /*! figures out the anari type and dims a member gets loaded as */
+    void chooseLayout(const std::string &fileName, NpyMember &member,
+                      anari::DataType requestedType)
+    {
+      const NpyHeader &h = member.header;
+      std::vector<uint64_t> shape = h.shape;
+      if (shape.empty()) shape.push_back(1);
+      if (h.fortranOrder && shape.size() > 1)
+        npyError(fileName,"'"+member.name+"' is stored in fortran order;"
+                 " save it with np.ascontiguousarray() instead");
+      
+      anari::DataType scalarType;
+      int numComponents = 1;
+      if (requestedType != ANARI_UNKNOWN) {
+        if (!splitVectorType(requestedType,scalarType,numComponents))
+          npyError(fileName,"cannot load '"+member.name+"' as "
+                   +to_string(requestedType));
+        if (numComponents > 1 && shape.back() != (uint64_t)numComponents)
+          npyError(fileName,"shape of '"+member.name+"' doesn't match "
+                   +to_string(requestedType));
+      } else {
+        scalarType = defaultScalarType(h);
+        if (scalarType == ANARI_UNKNOWN)
+          npyError(fileName,"unsupported dtype of '"+member.name+"'");
+        if (shape.size() > 1 && shape.back() >= 2 && shape.back() <= 4)
+          numComponents = (int)shape.back();
+      }
+      if (numComponents > 1) shape.pop_back();
+      if (shape.size() > 3)
+        npyError(fileName,"'"+member.name+"' has too many dimensions");
+
+      member.type = scalarType+numComponents-1;
+      // (checked against the blob size as we go, so a bogus shape
+      // can't overflow the product)
+      const uint64_t maxScalars = (member.size-h.dataOffset)/h.scalarSize;
+      member.numScalars = numComponents;
+      for (auto dim : shape) {
+        if (dim != 0 && member.numScalars > maxScalars/dim)
+          npyError(fileName,"'"+member.name+"' is truncated");
+        member.numScalars *= dim;
+      }
+      if (member.numScalars > maxScalars)
+        npyError(fileName,"'"+member.name+"' is truncated");
+      // numpy is slowest-dimension-first, anari the other way around
+      member.dims.assign(shape.rbegin(),shape.rend());
+    }
+  }
+
+  py::dict Context::loadArrays(const std::string &fileName,
+                               const py::dict &types)
+  {
+    std::map<std::string,anari::DataType> requestedTypes;
+    for (auto item : types)
+      requestedTypes[py::cast<std::string>(item.first)]
+        = py::cast<int>(item.second);
+
+    std::vector<NpyMember> members;
+    {
+      py::gil_scoped_release noGIL;
+      MappedFile::SP file = MappedFile::open(fileName);
+      
+      if (file->size >= 6 && memcmp(file->data,"\x93NUMPY",6) == 0) {
+        // a single .npy file; name it after the file
+        NpyMember member;
+        std::string name = fileName.substr(fileName.find_last_of("/\\")+1);
+        member.name  = name.substr(0,name.rfind('.'));
+        member.begin = file->data;
+        member.size  = file->size;
+        members.push_back(member);
+      } else
+        members = listNpzMembers(fileName,*file);
+      
+      // decompress what's compressed, in parallel, and parse headers
+      parallel_for
+        (members.size(),
+         [&](size_t i) {
+           NpyMember &member = members[i];
+           if (member.method == 8) {
+             member.inflated
+               = std::make_shared<std::vector<uint8_t>>(member.size);
+             inflate(member.compressed,member.compressedSize,
+                     member.inflated->data(),member.size);
+             member.begin = member.inflated->data();
+           }
+           member.header = parseNpyHeader(fileName,member.name,
+                                          member.begin,member.size);
+           auto requested = requestedTypes.find(member.name);
+           chooseLayout(fileName,member,
+                        requested == requestedTypes.end()
+                        ? ANARI_UNKNOWN
+                        : requested->second);
+         },1);
+
+      // create the arrays: data that is already exactly what anari
+      // wants gets shared straight out of the file (or inflated
+      // buffer); everything else gets converted into a managed array
+      for (auto &member : members) {
+        const NpyHeader &h = member.header;
+        const uint8_t *src = member.begin + h.dataOffset;
+        anari::DataType scalarType;
+        int numComponents;
+        splitVectorType(member.type,scalarType,numComponents);
+        bool zeroCopy
+          = sameLayout(h,scalarType)
+          && ((uintptr_t)src % h.scalarSize) == 0;
+        if (zeroCopy) {
+          std::shared_ptr<void> keepAlive = file;
+          if (member.inflated) keepAlive = member.inflated;
+          member.array = create<Array>(member.type,member.dims,
+                                       (const void *)src,keepAlive);
+        } else {
+          member.array = create<Array>(member.type,member.dims);
+          void *mapped = anariMapArray(device->handle,member.array->handle);
+          convert(h,src,scalarType,mapped,member.numScalars);
+          anariUnmapArray(device->handle,member.array->handle);
+        }
+      }
+    }
+
+    py::dict result;
+    for (auto &member : members)
+      result[py::str(member.name)] = member.array;
+    return result;
+  }
+  
+}
@@ -17,6 +17,8 @@
 #include "pynari/Object.h"
 #include "pynari/Context.h"
 #include "pynari/Array.h"
+#include "pynari/Param.h"
+#include <cstring>
 
 namespace pynari {
 
@@ -37,6 +39,8 @@ namespace pynari {
     case ANARI_VOLUME:         return "ANARI_VOLUME";
     case ANARI_SPATIAL_FIELD:  return "ANARI_SPATIAL_FIELD";
     case ANARI_WORLD:          return "ANARI_WORLD";
+    case ANARI_FRAME:          return "ANARI_FRAME";
+    case ANARI_INSTANCE:       return "ANARI_INSTANCE";
     case ANARI_FLOAT32_MAT3x4: return "ANARI_FLOAT32_MAT3x4"; 
     case ANARI_FLOAT32_MAT4:   return "ANARI_FLOAT32_MAT4"; 
     case ANARI_RENDERER:       return "ANARI_RENDERER";
@@ -70,15 +74,45 @@ namespace pynari {
     }
   }
   
+  bool isObjectType(anari::DataType type)
+  {
+    switch(type) {
+    case ANARI_OBJECT:
+    case ANARI_ARRAY:
+    case ANARI_ARRAY1D:
+    case ANARI_ARRAY2D:
+    case ANARI_ARRAY3D:
+    case ANARI_CAMERA:
+    case ANARI_FRAME:
+    case ANARI_GEOMETRY:
+    case ANARI_GROUP:
+    case ANARI_INSTANCE:
+    case ANARI_LIGHT:
+    case ANARI_MATERIAL:
+    case ANARI_RENDERER:
+    case ANARI_SAMPLER:
+    case ANARI_SPATIAL_FIELD:
+    case ANARI_SURFACE:
+    case ANARI_VOLUME:
+    case ANARI_WORLD:
+      return true;
+    default:
+      return false;
+    }
+  }
+  
   Object::Object(Device::SP device)
     : device(device)
   {
-    device->listOfAllObjectsCreatedOnThisDevice.insert(this);
+    // note: objects get added to the device's registry by whoever
+    // created them (see Context::create()), once fully constructed
   }
 
   Object::~Object()
   {
     assert(this);
+    if (device)
+      device->registry.remove(this);
     release();
   }
 
@@ -88,30 +122,114 @@ namespace pynari {
     assert(this->device);
   }
   
+  /*! whether the shadow parameter cache may elide redundant
+      parameter sets and commits; can be disabled by setting
+      PYNARI_NO_PARAM_CACHE to anything other than empty or "0" */
+  static bool paramCacheEnabled()
+  {
+    static bool cachedValue = [](){
+      const char *flag = getenv("PYNARI_NO_PARAM_CACHE");
+      return !(flag && *flag && strcmp(flag,"0") != 0);
+    }();
+    return cachedValue;
+  }
+  
   void Object::commit()
   {
+    std::lock_guard<std::mutex> lock(mutex);
     assertThisObjectIsValid();
+    if (!paramsChanged && paramCacheEnabled()) {
+      device->stats.commitsElided++;
+      return;
+    }
+    if (device->transactionDepth > 0 && device->deferCommit(this))
+      return;
     anariCommitParameters(device->handle,this->handle);
+    paramsChanged = false;
+    device->stats.commits++;
   }
 
+  void Object::setParam(const char *name,
+                        anari::DataType type,
+                        const void *mem,
+                        const Object::SP &ref)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    Param *shadow = nullptr;
+    for (auto &p : shadowParams)
+      if (p.name == name) { shadow = &p; break; }
+    if (shadow && shadow->holds(type,mem) && paramCacheEnabled()) {
+      if (ref) shadow->ref = ref;
+      device->stats.paramsElided++;
+      return;
+    }
+    
+    anariSetParameter(device->handle,this->handle,name,type,mem);
+    device->stats.paramsSet++;
+    paramsChanged = true;
+    
+    if (!shadow) {
+      shadowParams.emplace_back();
+      shadow = &shadowParams.back();
+      shadow->name = name;
+    }
+    shadow->set(type,mem);
+    shadow->ref = isObjectType(type) ? ref : Object::SP();
+  }
+
+  void Object::setParameters(const py::object &params, bool commit)
+  {
+    assertThisObjectIsValid();
+    std::vector<Param> decoded = decodeParams(params);
+
+    py::gil_scoped_release noGIL;
+    for (auto &p : decoded)
+      setParam(p.name.c_str(),p.type,p.ptr(),p.ref);
+    if (commit)
+      this->commit();
+  }
+
+  std::vector<Param> Object::getShadowParams()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    return shadowParams;
+  }
+  
+  py::dict Object::getParameters()
+  {
+    std::vector<Param> params;
+    {
+      py::gil_scoped_release noGIL;
+      params = getShadowParams();
+    }
+    py::dict result;
+    for (auto &p : params)
+      result[py::str(p.name)] = py::make_tuple((int)p.type,encodeParam(p));
+    return result;
+  }
+  
   void Object::release()
   {
+    std::lock_guard<std::mutex> lock(mutex);
     if (!handle) return;
     if (!device->handle) return;
 
-    device->listOfAllObjectsCreatedOnThisDevice.erase(this);
+    device->registry.remove(this);
     
     anari::release(device->handle,handle);
     handle = {};
     device = nullptr;
+    // the anari side no longer refers to any of these, so neither
+    // should we
+    shadowParams.clear();
   }
 
   void Object::setArray_list(const char *name,
                              int type, 
                              const py::list &list)
   {
-    static bool warned = false;
-    if (warned == false) {
+    static std::atomic<bool> warned(false);
+    if (warned.exchange(true) == false) {
       std::cout
         << "#pynari: this python app using pynari just called Object::setParameterArray()\n"
         << "#pynari: due to some changes in the ANARI SDK these calls are now (starting\n"
@@ -122,7 +240,6 @@ namespace pynari {
         << "#pynari: the better way would be for the app to swtich to the new\n"
         << "#pynari: intended behavior.\n"
         ;
-      warned = true;
     }
     setArray1D_list(name,type,list);
   }
@@ -132,32 +249,17 @@ namespace pynari {
                                const py::list &list)
   {
     assertThisObjectIsValid();
-    std::vector<ANARIObject> objects;
-    for (auto item : list) {
-      Object::SP object = item.cast<Object::SP>();
-      assert(object);
-      ANARIObject handle = object->handle;
-      objects.push_back(handle);
-    }
-    anari::Array1D array
-      = anari::newArray1D(device->handle,
-                          type,//ANARI_OBJECT,
-                          objects.size());
-      
-    ANARIObject *mapped
-      = (ANARIObject*)anariMapArray(device->handle,array);
-    std::copy(objects.begin(),objects.end(),mapped);
-    anariUnmapArray(device->handle,array);
-    anari::setParameter(device->handle,this->handle,name,(ANARIArray1D)array);
-    anariRelease(device->handle,array);
+    std::shared_ptr<pynari::Array> array
+      = device->context->newArray1D_objects(type,list);
+    setParam(name,ANARI_ARRAY1D,&array->handle,array);
   }
   
   void Object::setArray_np(const char *name,
                              int type, 
                              const py::buffer &buffer)
   {
-    static bool warned = false;
-    if (warned == false) {
+    static std::atomic<bool> warned(false);
+    if (warned.exchange(true) == false) {
       std::cout
         << "#pynari: this python app using pynari just called Object::setParameterArray()\n"
         << "#pynari: due to some changes in the ANARI SDK these calls are now (starting\n"
@@ -168,22 +270,18 @@ namespace pynari {
         << "#pynari: the better way would be for the app to swtich to the new\n"
         << "#pynari: intended behavior.\n"
         ;
-      warned = true;
     }
     std::shared_ptr<pynari::Array> array
       = device->context->newArray(type,buffer);
     switch (array->nDims) {
     case 1:
-      anari::setParameter(device->handle,this->handle,name,
-                          (ANARIArray1D)array->handle);
+      setParam(name,ANARI_ARRAY1D,&array->handle,array);
       break;
     case 2:
-      anari::setParameter(device->handle,this->handle,name,
-                          (ANARIArray2D)array->handle);
+      setParam(name,ANARI_ARRAY2D,&array->handle,array);
       break;
     case 3:
-      anari::setParameter(device->handle,this->handle,name,
-                          (ANARIArray3D)array->handle);
+      setParam(name,ANARI_ARRAY3D,&array->handle,array);
       break;
     default:
       throw std::runtime_error("invalid array type in Object::setArray_np()");
@@ -196,8 +294,7 @@ namespace pynari {
   {
     std::shared_ptr<pynari::Array> array
       = device->context->newArray1D(type,buffer);
-    anari::setParameter(device->handle,this->handle,name,
-                        (ANARIArray1D)array->handle);
+    setParam(name,ANARI_ARRAY1D,&array->handle,array);
   }
   
   void Object::setArray2D_np(const char *name,
@@ -206,8 +303,7 @@ namespace pynari {
   {
     std::shared_ptr<pynari::Array> array
       = device->context->newArray2D(type,buffer);
-    anari::setParameter(device->handle,this->handle,name,
-                        (ANARIArray2D)array->handle);
+    setParam(name,ANARI_ARRAY2D,&array->handle,array);
   }
   
   void Object::setArray3D_np(const char *name,
@@ -216,8 +312,7 @@ namespace pynari {
   {
     std::shared_ptr<pynari::Array> array
       = device->context->newArray3D(type,buffer);
-    anari::setParameter(device->handle,this->handle,name,
-                        (ANARIArray3D)array->handle);
+    setParam(name,ANARI_ARRAY3D,&array->handle,array);
   }
 
   void Object::set_object_notype(const char *name,
@@ -242,17 +337,25 @@ namespace pynari {
                   << to_string(type) << ")"
                   << std::endl;
 
-      anari::setParameter(device->handle,this->handle,
-                          name,
-                          type == ANARI_OBJECT
-                          ? (int)object->anariType()
-                          : (int)type,
-                          (void*)&object->handle);
+      setParam(name,
+               type == ANARI_OBJECT
+               ? (int)object->anariType()
+               : (int)type,
+               (void*)&object->handle,
+               object);
     } else
-      anari::setParameter(device->handle,this->handle,
-                          name,
-                          type,//ANARI_OBJECT,
-                          nullptr);
+      setParam(name,
+               type,//ANARI_OBJECT,
+               nullptr);
+  }
+    
+  void Object::set_ndarray(const char *name,
+                           int type,
+                           const py::buffer &array)
+  {
+    assertThisObjectIsValid();
+    Param p = decodeParam(name,type,array);
+    setParam(name,p.type,p.ptr(),p.ref);
   }
     
   void Object::set_float(const char *name,
@@ -262,7 +365,7 @@ namespace pynari {
     assertThisObjectIsValid();
     switch(type) {
     case ANARI_FLOAT32:
-      return anari::setParameter(device->handle,handle,name,(float)v);
+      return setParam(name,(float)v);
     default:
       throw std::runtime_error
         (std::string(__PRETTY_FUNCTION__)
@@ -277,11 +380,15 @@ namespace pynari {
     assertThisObjectIsValid();
     switch(type) {
     case ANARI_FLOAT32_VEC2:
-      return anari::setParameter(device->handle,handle,name,
-                                 math::float2(std::get<0>(v),
-                                              std::get<1>(v)));
-    case ANARI_FLOAT32_BOX1: 
-      return anariSetParameter(device->handle,handle,name,type,&v);
+      return setParam(name,
+                      math::float2(std::get<0>(v),
+                                   std::get<1>(v)));
+    case ANARI_FLOAT32_BOX1: {
+      // note: do not pass '&v' directly - std::tuple does not
+      // guarantee its elements are stored in order
+      math::float2 box(std::get<0>(v),std::get<1>(v));
+      return setParam(name,type,&box);
+    }
     default:
       throw std::runtime_error
         (std::string(__PRETTY_FUNCTION__)
@@ -296,10 +403,10 @@ namespace pynari {
     assertThisObjectIsValid();
     switch(type) {
     case ANARI_FLOAT32_VEC3:
-      return anari::setParameter(device->handle,this->handle,name,
-                                 math::float3(std::get<0>(v),
-                                              std::get<1>(v),
-                                              std::get<2>(v)));
+      return setParam(name,
+                      math::float3(std::get<0>(v),
+                                   std::get<1>(v),
+                                   std::get<2>(v)));
     default:
       throw std::runtime_error
         (std::string(__PRETTY_FUNCTION__)
@@ -314,11 +421,11 @@ namespace pynari {
     assertThisObjectIsValid();
     switch(type) {
     case ANARI_FLOAT32_VEC4:
-      return anari::setParameter(device->handle,this->handle,name,
-                                 math::float4(std::get<0>(v),
-                                              std::get<1>(v),
-                                              std::get<2>(v),
-                                              std::get<3>(v)));
+      return setParam(name,
+                      math::float4(std::get<0>(v),
+                                   std::get<1>(v),
+                                   std::get<2>(v),
+                                   std::get<3>(v)));
     default:
       throw std::runtime_error
         (std::string(__PRETTY_FUNCTION__)+" unsupported type "
@@ -349,7 +456,7 @@ namespace pynari {
       mat[3].x = std::get<9>(v);
       mat[3].y = std::get<10>(v);
       mat[3].z = std::get<11>(v);
-      return anari::setParameter(device->handle,this->handle,name,mat);
+      return setParam(name,mat);
     }
     default:
       throw std::runtime_error
@@ -386,7 +493,7 @@ namespace pynari {
       mat[3].y = std::get<13>(v);
       mat[3].z = std::get<14>(v);
       mat[3].w = std::get<15>(v);
-      return anari::setParameter(device->handle,this->handle,name,mat);
+      return setParam(name,mat);
     }
     default:
       throw std::runtime_error
@@ -402,8 +509,8 @@ namespace pynari {
     assertThisObjectIsValid();
     switch(type) {
     case ANARI_UINT32_VEC3:
-      return anari::setParameter(device->handle,this->handle,name,
-                                 math::uint3(v[0],v[1],v[2]));
+      return setParam(name,
+                      math::uint3(v[0],v[1],v[2]));
     default:
       throw std::runtime_error
         (std::string(__PRETTY_FUNCTION__)
@@ -418,8 +525,8 @@ namespace pynari {
     assertThisObjectIsValid();
     switch(type) {
     case ANARI_FLOAT32_VEC3:
-      return anari::setParameter(device->handle,this->handle,name,
-                                 math::float3(v[0],v[1],v[2]));
+      return setParam(name,
+                      math::float3(v[0],v[1],v[2]));
     case ANARI_FLOAT32_MAT3x4: {
       anari::math::mat4 mat = anari::math::identity;
       if (v.size() != 12)
@@ -429,14 +536,14 @@ namespace pynari {
       for (int y=0;y<4;y++)
         for (int x=0;x<3;x++)
           out[4*y+x] = in[3*y+x];
-      return anari::setParameter(device->handle,this->handle,name,mat);
+      return setParam(name,mat);
     }
     case ANARI_FLOAT32_MAT4: {
       anari::math::mat4 mat = anari::math::identity;
       if (v.size() != 16)
         throw std::runtime_error("setParameter(...,...MAT4X4,...) must only be used with tuple or list with 16 elements");
       std::copy(v.begin(),v.end(),(float*)&mat);
-      return anari::setParameter(device->handle,this->handle,name,mat);
+      return setParam(name,mat);
     }
     default:
       throw std::runtime_error
@@ -449,13 +556,13 @@ namespace pynari {
                           const std::string &stringValue)
   {
     assert(type == ANARI_STRING);
-    anari::setParameter(device->handle,this->handle,name,stringValue.c_str());
+    setParam(name,ANARI_STRING,stringValue.c_str());
   }
 
   void Object::set_string_notype(const char *name, 
                           const std::string &stringValue)
   {
-    anari::setParameter(device->handle,this->handle,name,stringValue.c_str());
+    setParam(name,ANARI_STRING,stringValue.c_str());
   }
 
   void Object::set_uint(const char *name,
@@ -465,17 +572,13 @@ namespace pynari {
     assertThisObjectIsValid();
     switch(type) {
     case ANARI_DATA_TYPE:
-      return anari::setParameter(device->handle,this->handle,name,
-                                 (anari::DataType)v);
+      return setParam(name,(anari::DataType)v);
     case ANARI_INT32:
-      return anari::setParameter(device->handle,this->handle,name,
-                                 (int)v);
+      return setParam(name,(int)v);
     case ANARI_UINT32:
-      return anari::setParameter(device->handle,this->handle,name,
-                                 (uint)v);
+      return setParam(name,(uint)v);
     case ANARI_FLOAT32:
-      return anari::setParameter(device->handle,this->handle,name,
-                                 (float)v);
+      return setParam(name,(float)v);
     default:
       throw std::runtime_error
         (std::string(__PRETTY_FUNCTION__)
@@ -490,23 +593,17 @@ namespace pynari {
     assertThisObjectIsValid();
     switch(type) {
     case ANARI_DATA_TYPE:
-      return anari::setParameter(device->handle,this->handle,name,
-                                 (anari::DataType)v);
+      return setParam(name,(anari::DataType)v);
     case ANARI_INT32:
-      return anari::setParameter(device->handle,this->handle,name,
-                                 (int)v);
+      return setParam(name,(int)v);
     case ANARI_INT64:
-      return anari::setParameter(device->handle,this->handle,name,
-                                 (int64_t)v);
+      return setParam(name,(int64_t)v);
     case ANARI_UINT64:
-      return anari::setParameter(device->handle,this->handle,name,
-                                 (uint64_t)v);
+      return setParam(name,(uint64_t)v);
     case ANARI_UINT32:
-      return anari::setParameter(device->handle,this->handle,name,
-                                 (uint)v);
+      return setParam(name,(uint)v);
     case ANARI_FLOAT32:
-      return anari::setParameter(device->handle,this->handle,name,
-                                 (float)v);
+      return setParam(name,(float)v);
     default:
       throw std::runtime_error
         (std::string(__PRETTY_FUNCTION__)
@@ -521,9 +618,9 @@ namespace pynari {
     assertThisObjectIsValid();
     switch(type) {
     case ANARI_UINT32_VEC2:
-      return anari::setParameter(device->handle,this->handle,name,
-                                 math::uint2(std::get<0>(v),
-                                             std::get<1>(v)));
+      return setParam(name,
+                      math::uint2(std::get<0>(v),
+                                  std::get<1>(v)));
     default:
       throw std::runtime_error
         (std::string(__PRETTY_FUNCTION__)
@@ -538,15 +635,15 @@ namespace pynari {
     assertThisObjectIsValid();
     switch(type) {
     case ANARI_FLOAT32_VEC3:
-      return anari::setParameter(device->handle,this->handle,name,
-                                 math::float3((float)std::get<0>(v),
-                                              (float)std::get<1>(v),
-                                              (float)std::get<2>(v)));
+      return setParam(name,
+                      math::float3((float)std::get<0>(v),
+                                   (float)std::get<1>(v),
+                                   (float)std::get<2>(v)));
     case ANARI_UINT32_VEC3:
-      return anari::setParameter(device->handle,this->handle,name,
-                                 math::uint3((uint32_t)std::get<0>(v),
-                                             (uint32_t)std::get<1>(v),
-                                             (uint32_t)std::get<2>(v)));
+      return setParam(name,
+                      math::uint3((uint32_t)std::get<0>(v),
+                                  (uint32_t)std::get<1>(v),
+                                  (uint32_t)std::get<2>(v)));
     default:
       throw std::runtime_error
         (std::string(__PRETTY_FUNCTION__)
@@ -561,17 +658,17 @@ namespace pynari {
     assertThisObjectIsValid();
     switch(type) {
     case ANARI_UINT32_VEC4:
-      return anari::setParameter(device->handle,this->handle,name,
-                                 math::uint4((uint32_t)std::get<0>(v),
-                                             (uint32_t)std::get<1>(v),
-                                             (uint32_t)std::get<2>(v),
-                                             (uint32_t)std::get<3>(v)));
+      return setParam(name,
+                      math::uint4((uint32_t)std::get<0>(v),
+                                  (uint32_t)std::get<1>(v),
+                                  (uint32_t)std::get<2>(v),
+                                  (uint32_t)std::get<3>(v)));
     case ANARI_FLOAT32_VEC4:
-      return anari::setParameter(device->handle,this->handle,name,
-                                 math::float4((float)std::get<0>(v),
-                                              (float)std::get<1>(v),
-                                              (float)std::get<2>(v),
-                                              (float)std::get<3>(v)));
+      return setParam(name,
+                      math::float4((float)std::get<0>(v),
+                                   (float)std::get<1>(v),
+                                   (float)std::get<2>(v),
+                                   (float)std::get<3>(v)));
     default:
       throw std::runtime_error
         (std::string(__PRETTY_FUNCTION__)+" unsupported type "+to_string((anari::DataType)type));
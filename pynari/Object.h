@@ -17,6 +17,7 @@
 #pragma once
 
 #include "pynari/Device.h"
+#include "pynari/Param.h"
 #include <helium/helium_math.h>
 #include <anari/anari_cpp.hpp>
 
@@ -26,6 +27,9 @@ namespace pynari {
   
   std::string to_string(anari::DataType type);
 
+  /*! whether given type refers to an anari object (incl arrays) */
+  bool isObjectType(anari::DataType type);
+
   /*! base class for any anari object type such as a light, a
       material, renderg,e tcpp */
   struct Object : public std::enable_shared_from_this<Object> {
@@ -37,9 +41,25 @@ namespace pynari {
     virtual std::string toString() const = 0;
 
     virtual ANARIDataType anariType() const = 0;
+    /*! the subtype this object was created with (eg, "triangle" for
+        a geometry); empty for types that don't have any */
+    virtual std::string subtype() const { return ""; }
+
+    /*! number of bytes of data this object holds on to (eg, for
+        arrays), for the device's per-type memory stats */
+    virtual size_t numBytes() const { return 0; }
     
+    /*! commit this object's parameters - or, if a transaction is
+        currently open on this device, defer that commit until the
+        transaction closes */
     void commit();
 
+    /*! set multiple parameters at once, from either a dict of the
+        form `{ name : (type, value) }` or a list of `(name, type,
+        value)` tuples; all values get decoded first, then applied
+        (and optionally committed) with the GIL released */
+    void setParameters(const py::object &params, bool commit);
+
     void set_object(const char *name, int type,
                     const Object::SP &object);
     void set_object_notype(const char *name, 
@@ -69,6 +89,12 @@ namespace pynari {
     //                      const py::list &list);
     void setArray3D_np(const char *name, int type, 
                        const py::buffer &buffer);
+    /*! set a scalar, vector, or matrix parameter from a numpy array,
+        reading its buffer directly rather than going through python
+        floats/ints; (3,4) and (4,4) arrays get read as regular
+        (row-major) matrices */
+    void set_ndarray(const char *name, int type,
+                     const py::buffer &array);
     void set_box1(const char *name, int type,
                   const helium::box1 b);
     void set_float(const char *name, int type,
@@ -105,12 +131,51 @@ namespace pynari {
                    const std::tuple<uint,uint,uint,uint> &v);
     void set_uint_vec(const char *name, int type, 
                       const std::vector<uint> &v);
+    /*! set a parameter through the shadow parameter cache: if the
+        given value is identical to what this parameter was last set
+        to, this is a no-op; otherwise the value gets passed to
+        anariSetParameter, and the object gets marked as changed. For
+        object-typed params 'ref' should be the pynari object 'mem'
+        points to the handle of, so the parent can keep it around */
+    void setParam(const char *name, anari::DataType type, const void *mem,
+                  const Object::SP &ref = {});
+    template<typename T>
+    void setParam(const char *name, const T &v)
+    { setParam(name,(anari::DataType)anari::ANARITypeFor<T>::value,&v); }
+    
+    /*! returns (a copy of) the current value of each parameter that
+        has been set on this object */
+    std::vector<Param> getShadowParams();
+
+    /*! returns all parameters that have been set on this object, as
+        a dict of the form `{ name : (type, value) }` - the same form
+        setParameters() accepts */
+    py::dict getParameters();
+
+    /*! re-creates this object, and everything it refers to, on given
+        (possibly different) device, and returns the copy */
+    Object::SP cloneTo(const std::shared_ptr<Context> &target);
+    
     virtual void release();
 
     void assertThisObjectIsValid();
 
+    /*! anari requires that no two threads modify the same object
+        at the same time; this serializes all parameter sets,
+        commits, and releases on this object */
+    std::mutex    mutex;
     Device::SP    device;
     anari::Object handle = {};
+    /*! links into the device's registry of live objects */
+    ObjectRegistry::Node registryNode;
+    /*! whether this object is already in its device's list of
+        commits deferred by an open transaction */
+    bool commitDeferred = false;
+    /*! whether any parameter was set to a new value since the last
+        commit; if not, committing can be skipped */
+    bool paramsChanged = true;
+    /*! the last value each parameter of this object was set to */
+    std::vector<Param> shadowParams;
   };
   
 }
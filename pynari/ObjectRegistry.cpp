@@ -0,0 +1,160 @@
+// ======================================================================== //
+// Copyright 2024++ Ingo Wald                                               //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "pynari/ObjectRegistry.h"
+#include "pynari/Object.h"
+
+namespace pynari {
+
+  /*! the object types we keep per-type stats for, in 'slot' order */
+  static const anari::DataType slotTypes[] = {
+    ANARI_UNKNOWN,
+    ANARI_ARRAY1D,
+    ANARI_ARRAY2D,
+    ANARI_ARRAY3D,
+    ANARI_CAMERA,
+    ANARI_FRAME,
+    ANARI_GEOMETRY,
+    ANARI_GROUP,
+    ANARI_INSTANCE,
+    ANARI_LIGHT,
+    ANARI_MATERIAL,
+    ANARI_RENDERER,
+    ANARI_SURFACE,
+    ANARI_SAMPLER,
+    ANARI_SPATIAL_FIELD,
+    ANARI_VOLUME,
+    ANARI_WORLD,
+  };
+  static const int numSlotTypes = sizeof(slotTypes)/sizeof(slotTypes[0]);
+
+  static int typeSlot(anari::DataType type)
+  {
+    for (int i=1;i<numSlotTypes;i++)
+      if (slotTypes[i] == type) return i;
+    return 0;
+  }
+
+  static int shardOf(const Object *object, int numShards)
+  {
+    // objects are (at least) 16-byte aligned, and allocated at
+    // roughly sequential addresses; drop the low bits so
+    // consecutive objects land in different shards
+    return int((((uintptr_t)object) >> 4) % numShards);
+  }
+
+  void ObjectRegistry::add(Object *object)
+  {
+    static_assert(numSlotTypes <= numTypeSlots,
+                  "ObjectRegistry: not enough type slots");
+    Node &node = object->registryNode;
+    if (node.shard >= 0)
+      return;
+    node.type     = object->anariType();
+    node.numBytes = object->numBytes();
+    int slot = typeSlot(node.type);
+    typeCount[slot] += 1;
+    typeBytes[slot] += node.numBytes;
+
+    int s = shardOf(object,numShards);
+    Shard &shard = shards[s];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    node.shard = s;
+    node.prev  = nullptr;
+    node.next  = shard.head;
+    if (shard.head)
+      shard.head->registryNode.prev = object;
+    shard.head = object;
+  }
+
+  void ObjectRegistry::remove(Object *object)
+  {
+    Node &node = object->registryNode;
+    {
+      // read the shard index only once: a concurrent removeAll() may
+      // reset it to -1 at any time
+      int s = node.shard.load();
+      if (s < 0)
+        return;
+      Shard &shard = shards[s];
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      // may have gotten removed by removeAll() while we were waiting
+      // for the lock
+      if (node.shard < 0)
+        return;
+      if (node.prev)
+        node.prev->registryNode.next = node.next;
+      else
+        shard.head = node.next;
+      if (node.next)
+        node.next->registryNode.prev = node.prev;
+      node.prev = node.next = nullptr;
+      node.shard = -1;
+    }
+    int slot = typeSlot(node.type);
+    typeCount[slot] -= 1;
+    typeBytes[slot] -= node.numBytes;
+  }
+
+  std::vector<Object::SP> ObjectRegistry::removeAll()
+  {
+    std::vector<Object::SP> alive;
+    for (auto &shard : shards) {
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      for (Object *obj = shard.head; obj; ) {
+        Node &node = obj->registryNode;
+        Object *next = node.next;
+        node.prev = node.next = nullptr;
+        node.shard = -1;
+        int slot = typeSlot(node.type);
+        typeCount[slot] -= 1;
+        typeBytes[slot] -= node.numBytes;
+        // an object whose last reference is already gone is in
+        // the process of being destroyed; it'll release its own
+        // handle. Note we may not let go of the ones we do lock
+        // while still holding the shard lock
+        Object::SP sp = obj->weak_from_this().lock();
+        if (sp) alive.push_back(sp);
+        obj = next;
+      }
+      shard.head = nullptr;
+    }
+    return alive;
+  }
+
+  std::map<anari::DataType,ObjectRegistry::TypeStats>
+  ObjectRegistry::getTypeStats() const
+  {
+    std::map<anari::DataType,TypeStats> result;
+    for (int i=0;i<numSlotTypes;i++) {
+      TypeStats ts;
+      ts.count    = typeCount[i];
+      ts.numBytes = typeBytes[i];
+      if (ts.count)
+        result[slotTypes[i]] = ts;
+    }
+    return result;
+  }
+
+  int64_t ObjectRegistry::size() const
+  {
+    int64_t sum = 0;
+    for (int i=0;i<numSlotTypes;i++)
+      sum += typeCount[i];
+    return sum;
+  }
+
+}
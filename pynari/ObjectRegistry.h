@@ -0,0 +1,83 @@
+// ======================================================================== //
+// Copyright 2024++ Ingo Wald                                               //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include "pynari/common.h"
+#include <atomic>
+#include <mutex>
+
+namespace pynari {
+
+  struct Object;
+
+  /*! tracks all live objects created on a given device, so the device
+      can force-release them when it gets released itself. Objects
+      are kept in intrusive doubly-linked lists (the links live in the
+      objects themselves), spread over several independently locked
+      shards, so adding and removing an object is O(1), doesn't
+      allocate, and different threads rarely contend for the same
+      lock. Also keeps per-type counts of live objects and of the
+      bytes they hold */
+  struct ObjectRegistry {
+    /*! the per-object part of the registry; lives inside each Object */
+    struct Node {
+      Object          *prev     = nullptr;
+      Object          *next     = nullptr;
+      /*! shard this object is registered in, or -1 if it isn't */
+      std::atomic<int> shard{-1};
+      anari::DataType  type     = ANARI_UNKNOWN;
+      size_t           numBytes = 0;
+    };
+
+    /*! per-type live object count and memory */
+    struct TypeStats {
+      int64_t count    = 0;
+      int64_t numBytes = 0;
+    };
+
+    /*! register a fully constructed object; this reads its type and
+        size, so must not get called from inside its constructor */
+    void add(Object *object);
+
+    /*! unregister given object; no-op if it isn't registered */
+    void remove(Object *object);
+
+    /*! unregister all objects, and return those that are still alive
+        - objects that are already being destroyed are skipped */
+    std::vector<std::shared_ptr<Object>> removeAll();
+
+    /*! number of live objects and bytes, for each type that has any
+        live objects */
+    std::map<anari::DataType,TypeStats> getTypeStats() const;
+
+    /*! total number of live objects */
+    int64_t size() const;
+
+  private:
+    enum { numShards = 64, numTypeSlots = 20 };
+
+    struct Shard {
+      std::mutex mutex;
+      Object    *head = nullptr;
+    };
+    Shard shards[numShards];
+
+    std::atomic<int64_t> typeCount[numTypeSlots] = {};
+    std::atomic<int64_t> typeBytes[numTypeSlots] = {};
+  };
+
+}
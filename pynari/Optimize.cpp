@@ -0,0 +1,390 @@
+// ======================================================================== //
+// Copyright 2024++ Ingo Wald                                               //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "pynari/Optimize.h"
+#include "pynari/Context.h"
+#include "pynari/Array.h"
+#include "pynari/Geometry.h"
+#include "pynari/Surface.h"
+#include "pynari/Group.h"
+#include "pynari/Instance.h"
+#include "pynari/parallel.h"
+#include <algorithm>
+#include <set>
+
+namespace pynari {
+
+  /*! everything we need to know about a surface to decide what it
+      can get merged with, and to merge it */
+  struct MergeCandidate {
+    Surface::SP        surface;
+    Geometry::SP       geometry;
+    Param              material;
+    /*! all of the geometry's params, sorted by name */
+    std::vector<Param> geometryParams;
+    size_t             numVertices   = 0;
+    size_t             numPrimitives = 0;
+    /*! surfaces with the same key can be merged */
+    std::string        key;
+  };
+
+  /*! one merged surface, and the surfaces it replaced */
+  struct MergeRecord {
+    Surface::SP              merged;
+    std::vector<Surface::SP> sources;
+    std::vector<uint64_t>    primitiveOffsets;
+  };
+
+  /*! number of vertices per primitive for non-indexed geometries, or
+      0 for geometry types whose (non-indexed) primitive count does
+      not follow from their vertex count */
+  static int verticesPerPrimitive(const std::string &type)
+  {
+    if (type == "triangle") return 3;
+    if (type == "quad")     return 4;
+    if (type == "sphere")   return 1;
+    if (type == "cylinder") return 2;
+    if (type == "cone")     return 2;
+    return 0;
+  }
+
+  static bool isIndexType(anari::DataType type)
+  {
+    switch (type) {
+    case ANARI_UINT32:
+    case ANARI_UINT32_VEC2:
+    case ANARI_UINT32_VEC3:
+    case ANARI_UINT32_VEC4:
+    case ANARI_INT32:
+    case ANARI_INT32_VEC2:
+    case ANARI_INT32_VEC3:
+    case ANARI_INT32_VEC4:
+      return true;
+    default:
+      return false;
+    }
+  }
+
+  static bool startsWith(const std::string &s, const char *prefix)
+  {
+    return s.compare(0,strlen(prefix),prefix) == 0;
+  }
+
+  /*! if given param is a 1D array of per-vertex or per-primitive
+      data that merging has to concatenate, return that array */
+  static Array::SP mergeableArray(const Param &p)
+  {
+    if (p.type != ANARI_ARRAY1D)
+      return {};
+    if (!startsWith(p.name,"vertex.") && !startsWith(p.name,"primitive."))
+      return {};
+    Array::SP array = std::dynamic_pointer_cast<Array>(p.ref);
+    if (!array || !array->objects.empty() || array->numObjects != 0
+        || sizeOfType(array->elementType) == 0)
+      return {};
+    return array;
+  }
+
+  static size_t numElements(const Array::SP &array)
+  {
+    return array->dataBytes / sizeOfType(array->elementType);
+  }
+
+  static void appendBytes(std::string &key, const void *mem, size_t size)
+  {
+    key.append((const char *)mem,size);
+  }
+
+  /*! fills in 'mc' for given surface, and returns whether it is a
+      surface we know how to merge */
+  static bool classify(const Surface::SP &surface, MergeCandidate &mc)
+  {
+    mc.surface = surface;
+    bool haveMaterial = false;
+    for (auto &p : surface->getShadowParams()) {
+      if (p.name == "geometry")
+        mc.geometry = std::dynamic_pointer_cast<Geometry>(p.ref);
+      else if (p.name == "material") {
+        mc.material = p;
+        haveMaterial = p.object != nullptr;
+      } else if (p.name != "id")
+        // anything else (eg, a per-surface sampler) we'd have to
+        // preserve per source - don't merge
+        return false;
+    }
+    if (!mc.geometry || !haveMaterial)
+      return false;
+
+    mc.geometryParams = mc.geometry->getShadowParams();
+    std::sort(mc.geometryParams.begin(),mc.geometryParams.end(),
+              [](const Param &a, const Param &b){ return a.name < b.name; });
+
+    mc.key = mc.geometry->type;
+    mc.key.push_back(0);
+    appendBytes(mc.key,&mc.material.object,sizeof(mc.material.object));
+
+    bool   haveIndex     = false;
+    size_t numPrimArrayElements = 0;
+    bool   havePrimArray = false;
+    bool   haveVertices  = false;
+    for (auto &p : mc.geometryParams) {
+      mc.key += p.name;
+      mc.key.push_back(0);
+      if (Array::SP array = mergeableArray(p)) {
+        // arrays get concatenated, so only their layout has to match
+        mc.key.push_back('A');
+        appendBytes(mc.key,&array->elementType,sizeof(array->elementType));
+        size_t count = numElements(array);
+        if (startsWith(p.name,"vertex.")) {
+          if (haveVertices && count != mc.numVertices)
+            return false;
+          mc.numVertices = count;
+          haveVertices = true;
+        } else if (p.name == "primitive.index") {
+          if (!isIndexType(array->elementType))
+            return false;
+          haveIndex = true;
+          mc.numPrimitives = count;
+        } else {
+          if (havePrimArray && count != numPrimArrayElements)
+            return false;
+          numPrimArrayElements = count;
+          havePrimArray = true;
+        }
+        continue;
+      }
+      // everything else has to be identical
+      mc.key.push_back('V');
+      appendBytes(mc.key,&p.type,sizeof(p.type));
+      if (p.type == ANARI_STRING)
+        mc.key += p.string;
+      else if (isObjectType(p.type))
+        appendBytes(mc.key,&p.object,sizeof(p.object));
+      else if (size_t size = sizeOfType(p.type))
+        appendBytes(mc.key,p.data,size);
+      else
+        return false;
+      mc.key.push_back(0);
+    }
+    if (!haveVertices)
+      return false;
+    if (!haveIndex) {
+      if (havePrimArray)
+        mc.numPrimitives = numPrimArrayElements;
+      else {
+        int vpp = verticesPerPrimitive(mc.geometry->type);
+        if (vpp == 0 || mc.numVertices % vpp)
+          return false;
+        mc.numPrimitives = mc.numVertices / vpp;
+      }
+    }
+    if (havePrimArray && numPrimArrayElements != mc.numPrimitives)
+      return false;
+    return true;
+  }
+
+  /*! merge given (compatible) candidates into a single new surface */
+  static MergeRecord merge(Context *context,
+                           const std::vector<MergeCandidate*> &members)
+  {
+    anari::Device device = context->device->handle;
+    const size_t numMembers = members.size();
+    std::vector<uint64_t> vertexOffsets(numMembers+1,0);
+    std::vector<uint64_t> primOffsets(numMembers+1,0);
+    for (size_t i=0;i<numMembers;i++) {
+      vertexOffsets[i+1] = vertexOffsets[i] + members[i]->numVertices;
+      primOffsets[i+1]   = primOffsets[i]   + members[i]->numPrimitives;
+    }
+
+    // map each source array exactly once (several surfaces may share
+    // the same array), before we start copying in parallel
+    std::map<Array*,const uint8_t *> mapped;
+    for (auto mc : members)
+      for (auto &p : mc->geometryParams)
+        if (Array::SP array = mergeableArray(p))
+          if (mapped.find(array.get()) == mapped.end())
+            mapped[array.get()]
+              = (const uint8_t *)anariMapArray(device,array->handle);
+
+    const MergeCandidate &first = *members[0];
+    Geometry::SP geometry
+      = context->create<Geometry>(first.geometry->type);
+    for (size_t paramID=0;paramID<first.geometryParams.size();paramID++) {
+      const Param &p = first.geometryParams[paramID];
+      Array::SP firstArray = mergeableArray(p);
+      if (!firstArray) {
+        geometry->setParam(p.name.c_str(),p.type,p.ptr(),p.ref);
+        continue;
+      }
+      const anari::DataType elementType = firstArray->elementType;
+      const size_t elemSize  = sizeOfType(elementType);
+      const bool   isIndex   = (p.name == "primitive.index");
+      const bool   perVertex = startsWith(p.name,"vertex.");
+      const std::vector<uint64_t> &offsets
+        = perVertex ? vertexOffsets : primOffsets;
+      std::vector<uint8_t> merged(offsets[numMembers]*elemSize);
+      parallel_for
+        (numMembers,
+         [&](size_t memberID) {
+           // same key means same params in the same (sorted) order
+           Array::SP array
+             = mergeableArray(members[memberID]->geometryParams[paramID]);
+           const uint8_t *in = mapped.at(array.get());
+           uint8_t *out = merged.data() + offsets[memberID]*elemSize;
+           size_t numBytes
+             = (offsets[memberID+1]-offsets[memberID])*elemSize;
+           if (!isIndex) {
+             memcpy(out,in,numBytes);
+             return;
+           }
+           const uint32_t *inIdx  = (const uint32_t *)in;
+           uint32_t       *outIdx = (uint32_t *)out;
+           uint32_t        shift  = (uint32_t)vertexOffsets[memberID];
+           for (size_t i=0;i<numBytes/sizeof(uint32_t);i++)
+             outIdx[i] = inIdx[i] + shift;
+         },
+         /* members are often tiny */64);
+      Array::SP array
+        = context->create<Array>(elementType,
+                                 (const void *)merged.data(),
+                                 (size_t)offsets[numMembers]);
+      geometry->setParam(p.name.c_str(),ANARI_ARRAY1D,&array->handle,array);
+    }
+    for (auto it : mapped)
+      anariUnmapArray(device,it.first->handle);
+    geometry->commit();
+
+    MergeRecord record;
+    record.merged = context->create<Surface>();
+    record.merged->setParam("geometry",ANARI_GEOMETRY,
+                            &geometry->handle,geometry);
+    record.merged->setParam("material",first.material.type,
+                            first.material.ptr(),first.material.ref);
+    record.merged->commit();
+    for (auto mc : members)
+      record.sources.push_back(mc->surface);
+    record.primitiveOffsets = primOffsets;
+    return record;
+  }
+
+  /*! merge the surfaces in given world's or group's 'surface' array */
+  static void optimizeSurfaces(const Object::SP &parent,
+                               std::vector<MergeRecord> &records)
+  {
+    Array::SP surfaceArray;
+    for (auto &p : parent->getShadowParams())
+      if (p.name == "surface")
+        surfaceArray = std::dynamic_pointer_cast<Array>(p.ref);
+    if (!surfaceArray || surfaceArray->objects.size() < 2)
+      return;
+
+    const std::vector<Object::SP> &surfaces = surfaceArray->objects;
+    std::vector<MergeCandidate> candidates(surfaces.size());
+    std::vector<bool> mergeable(surfaces.size(),false);
+    parallel_for(surfaces.size(),
+                 [&](size_t i) {
+                   Surface::SP surface
+                     = std::dynamic_pointer_cast<Surface>(surfaces[i]);
+                   mergeable[i] = surface && classify(surface,candidates[i]);
+                 },
+                 256);
+
+    // bucket by key, in order of first appearance
+    std::map<std::string,int> bucketOf;
+    std::vector<std::vector<MergeCandidate*>> buckets;
+    for (size_t i=0;i<surfaces.size();i++) {
+      if (!mergeable[i]) continue;
+      auto it = bucketOf.find(candidates[i].key);
+      if (it == bucketOf.end()) {
+        it = bucketOf.insert({candidates[i].key,(int)buckets.size()}).first;
+        buckets.emplace_back();
+      }
+      buckets[it->second].push_back(&candidates[i]);
+    }
+
+    std::set<Object*> replaced;
+    std::vector<Object::SP> newSurfaces;
+    Context *context = parent->device->context;
+    const size_t firstRecord = records.size();
+    for (auto &bucket : buckets) {
+      if (bucket.size() < 2) continue;
+      records.push_back(merge(context,bucket));
+      for (auto mc : bucket)
+        replaced.insert(mc->surface.get());
+    }
+    if (replaced.empty())
+      return;
+
+    for (auto &surface : surfaces)
+      if (!replaced.count(surface.get()))
+        newSurfaces.push_back(surface);
+    for (size_t i=firstRecord;i<records.size();i++)
+      newSurfaces.push_back(records[i].merged);
+
+    Array::SP array = context->create<Array>(ANARI_SURFACE,newSurfaces);
+    parent->setParam("surface",ANARI_ARRAY1D,&array->handle,array);
+    parent->commit();
+  }
+
+  py::list optimizeScene(const Object::SP &root)
+  {
+    if (!root || (root->anariType() != ANARI_WORLD
+                  && root->anariType() != ANARI_GROUP))
+      throw std::runtime_error
+        ("#pynari: optimize() expects a world or a group");
+
+    std::vector<MergeRecord> records;
+    {
+      py::gil_scoped_release noGIL;
+
+      std::vector<Object::SP> parents = { root };
+      if (root->anariType() == ANARI_WORLD) {
+        // also optimize all groups instantiated in this world, each
+        // one only once
+        std::set<Object*> seen;
+        for (auto &p : root->getShadowParams()) {
+          Array::SP instances = std::dynamic_pointer_cast<Array>(p.ref);
+          if (p.name != "instance" || !instances) continue;
+          for (auto &inst : instances->objects) {
+            if (!inst) continue;
+            for (auto &ip : inst->getShadowParams())
+              if (ip.name == "group" && ip.ref
+                  && seen.insert(ip.ref.get()).second)
+                parents.push_back(ip.ref);
+          }
+        }
+      }
+      for (auto &parent : parents)
+        optimizeSurfaces(parent,records);
+    }
+
+    py::list result;
+    for (auto &record : records) {
+      py::dict entry;
+      entry["surface"] = record.merged;
+      py::list sources;
+      for (auto &s : record.sources)
+        sources.append(s);
+      entry["sources"] = sources;
+      entry["primitive_offsets"]
+        = py::array_t<uint64_t>(record.primitiveOffsets.size(),
+                                record.primitiveOffsets.data());
+      result.append(entry);
+    }
+    return result;
+  }
+
+}
@@ -0,0 +1,37 @@
+// ======================================================================== //
+// Copyright 2024++ Ingo Wald                                               //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include "pynari/Object.h"
+
+namespace pynari {
+
+  /*! merges compatible surfaces of given world or group (and, for a
+      world, of all groups instantiated in it): all surfaces that use
+      the same material, and whose geometries are of the same type,
+      have the same set of vertex/primitive arrays, and agree on all
+      other parameters, get replaced with a single surface whose
+      geometry holds the concatenation of all their arrays.
+
+      Returns one dict per merged surface, with the new 'surface',
+      the list of 'sources' it replaced, and 'primitive_offsets' -
+      source i's primitives are the merged surface's primitives in
+      [primitive_offsets[i],primitive_offsets[i+1]) - so picking
+      results on the merged surface can be mapped back. */
+  py::list optimizeScene(const Object::SP &worldOrGroup);
+
+}
@@ -0,0 +1,432 @@
+// ======================================================================== //
+// Copyright 2024++ Ingo Wald                                               //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "pynari/Param.h"
+#include "pynari/Object.h"
+#include "pynari/parallel.h"
+
+namespace pynari {
+
+  const void *Param::ptr() const
+  {
+    if (type == ANARI_STRING)
+      return string.c_str();
+    if (isObjectType(type))
+      return &object;
+    return data;
+  }
+
+  size_t sizeOfType(anari::DataType type)
+  {
+    switch (type) {
+    case ANARI_UINT8:
+    case ANARI_UFIXED8:
+      return 1;
+    case ANARI_UINT8_VEC2:
+    case ANARI_UFIXED8_VEC2:
+    case ANARI_UINT16:
+    case ANARI_UFIXED16:
+      return 2;
+    case ANARI_UINT8_VEC3:
+    case ANARI_UFIXED8_VEC3:
+      return 3;
+    case ANARI_DATA_TYPE:
+    case ANARI_BOOL:
+    case ANARI_INT32:
+    case ANARI_UINT32:
+    case ANARI_FLOAT32:
+    case ANARI_UINT8_VEC4:
+    case ANARI_UFIXED8_VEC4:
+    case ANARI_UFIXED8_RGBA_SRGB:
+    case ANARI_UINT16_VEC2:
+    case ANARI_UFIXED16_VEC2:
+      return 4;
+    case ANARI_UINT16_VEC3:
+    case ANARI_UFIXED16_VEC3:
+      return 6;
+    case ANARI_INT32_VEC2:
+    case ANARI_UINT32_VEC2:
+    case ANARI_FLOAT32_VEC2:
+    case ANARI_FLOAT32_BOX1:
+    case ANARI_INT64:
+    case ANARI_UINT64:
+    case ANARI_UINT16_VEC4:
+    case ANARI_UFIXED16_VEC4:
+      return 8;
+    case ANARI_INT32_VEC3:
+    case ANARI_UINT32_VEC3:
+    case ANARI_FLOAT32_VEC3:
+      return 12;
+    case ANARI_INT32_VEC4:
+    case ANARI_UINT32_VEC4:
+    case ANARI_FLOAT32_VEC4:
+    case ANARI_FLOAT32_BOX2:
+      return 16;
+    case ANARI_FLOAT32_BOX3:
+      return 24;
+    case ANARI_FLOAT32_MAT3x4:
+      return 48;
+    case ANARI_FLOAT32_MAT4:
+      return 64;
+    default:
+      return 0;
+    }
+  }
+
+  void Param::set(anari::DataType type, const void *mem)
+  {
+    this->type = type;
+    if (type == ANARI_STRING)
+      string = mem ? (const char *)mem : "";
+    else if (isObjectType(type))
+      object = mem ? *(const anari::Object *)mem : nullptr;
+    else if (size_t size = sizeOfType(type))
+      memcpy(data,mem,size);
+  }
+  
+  bool Param::holds(anari::DataType type, const void *mem) const
+  {
+    if (type != this->type)
+      return false;
+    if (type == ANARI_STRING)
+      return mem && string == (const char *)mem;
+    if (isObjectType(type))
+      return object == (mem ? *(const anari::Object *)mem : nullptr);
+    size_t size = sizeOfType(type);
+    return size != 0 && memcmp(data,mem,size) == 0;
+  }
+  
+  /*! read exactly N values of type T from either a python scalar (if
+      N==1), a python list/tuple, or anything that supports the
+      buffer protocol (eg, a numpy array) */
+  template<typename T>
+  void readComponents(const std::string &name,
+                      const py::handle &value,
+                      T *out, int N)
+  {
+    if (py::isinstance<py::buffer>(value)) {
+      auto array
+        = py::array_t<T,py::array::c_style|py::array::forcecast>::ensure(value);
+      if (!array || array.size() != N)
+        throw std::runtime_error
+          ("#pynari: value for parameter '"+name+"' needs to have exactly "
+           +std::to_string(N)+" elements");
+      std::copy(array.data(),array.data()+N,out);
+      return;
+    }
+    if (py::isinstance<py::sequence>(value)
+        && !py::isinstance<py::str>(value)) {
+      py::sequence seq = py::reinterpret_borrow<py::sequence>(value);
+      if ((int)seq.size() != N)
+        throw std::runtime_error
+          ("#pynari: value for parameter '"+name+"' needs to have exactly "
+           +std::to_string(N)+" elements");
+      for (int i=0;i<N;i++)
+        out[i] = seq[i].cast<T>();
+      return;
+    }
+    if (N == 1) {
+      out[0] = value.cast<T>();
+      return;
+    }
+    throw std::runtime_error
+      ("#pynari: could not convert value for parameter '"+name+"'");
+  }
+
+  /*! whether given value is a numpy array shaped like a single 3x4
+      or 4x4 matrix. Note we check for the buffer protocol first:
+      checking for py::array imports numpy, which plain tuples and
+      lists must not require */
+  static bool isMatrixArray(const py::handle &value)
+  {
+    if (!py::isinstance<py::buffer>(value)
+        || !py::isinstance<py::array>(value))
+      return false;
+    py::array array = py::reinterpret_borrow<py::array>(value);
+    return array.ndim() == 2
+      && (array.shape(0) == 3 || array.shape(0) == 4)
+      && array.shape(1) == 4;
+  }
+  
+  Param decodeParam(const std::string &name, int type,
+                    const py::handle &value)
+  {
+    Param p;
+    p.name = name;
+    p.type = type;
+
+    if (type == ANARI_STRING) {
+      p.string = value.cast<std::string>();
+      return p;
+    }
+    if (isObjectType(type)) {
+      if (value.is_none())
+        return p;
+      Object::SP object = value.cast<Object::SP>();
+      if (!object)
+        return p;
+      // same as Object::set_object(): a generic 'OBJECT' gets
+      // replaced with the actual type of the object
+      if (type == ANARI_OBJECT)
+        p.type = object->anariType();
+      p.object = object->handle;
+      p.ref    = object;
+      return p;
+    }
+
+    switch (type) {
+    case ANARI_DATA_TYPE:
+      readComponents<int32_t>(name,value,(int32_t*)p.data,1);
+      // same type that Object::set_uint() ends up setting for this
+      p.type = anari::ANARITypeFor<anari::DataType>::value;
+      break;
+    case ANARI_INT32:
+      readComponents<int32_t>(name,value,(int32_t*)p.data,1);
+      break;
+    case ANARI_BOOL:
+      *(int32_t*)p.data = value.cast<bool>();
+      break;
+    case ANARI_INT32_VEC2:
+      readComponents<int32_t>(name,value,(int32_t*)p.data,2);
+      break;
+    case ANARI_INT32_VEC3:
+      readComponents<int32_t>(name,value,(int32_t*)p.data,3);
+      break;
+    case ANARI_INT32_VEC4:
+      readComponents<int32_t>(name,value,(int32_t*)p.data,4);
+      break;
+    case ANARI_UINT32:
+      readComponents<uint32_t>(name,value,(uint32_t*)p.data,1);
+      break;
+    case ANARI_UINT32_VEC2:
+      readComponents<uint32_t>(name,value,(uint32_t*)p.data,2);
+      break;
+    case ANARI_UINT32_VEC3:
+      readComponents<uint32_t>(name,value,(uint32_t*)p.data,3);
+      break;
+    case ANARI_UINT32_VEC4:
+      readComponents<uint32_t>(name,value,(uint32_t*)p.data,4);
+      break;
+    case ANARI_INT64:
+      readComponents<int64_t>(name,value,(int64_t*)p.data,1);
+      break;
+    case ANARI_UINT64:
+      readComponents<uint64_t>(name,value,(uint64_t*)p.data,1);
+      break;
+    case ANARI_FLOAT32:
+      readComponents<float>(name,value,(float*)p.data,1);
+      break;
+    case ANARI_FLOAT32_VEC2:
+    case ANARI_FLOAT32_BOX1:
+      readComponents<float>(name,value,(float*)p.data,2);
+      break;
+    case ANARI_FLOAT32_VEC3:
+      readComponents<float>(name,value,(float*)p.data,3);
+      break;
+    case ANARI_FLOAT32_VEC4:
+    case ANARI_FLOAT32_BOX2:
+      readComponents<float>(name,value,(float*)p.data,4);
+      break;
+    case ANARI_FLOAT32_BOX3:
+      readComponents<float>(name,value,(float*)p.data,6);
+      break;
+    case ANARI_FLOAT32_MAT3x4:
+    case ANARI_FLOAT32_MAT4:
+      if (isMatrixArray(value)) {
+        // a (3,4) or (4,4) numpy matrix: read it straight from its
+        // buffer, as a regular (row-major) matrix
+        anari::math::mat4 mat = decodeTransforms(value)[0];
+        memcpy(p.data,&mat,sizeof(mat));
+      } else if (type == ANARI_FLOAT32_MAT3x4) {
+        // same as Object::set_float_vec(): expand to a full mat4, and
+        // set it as such
+        float in[12];
+        readComponents<float>(name,value,in,12);
+        anari::math::mat4 mat = anari::math::identity;
+        float *out = (float *)&mat;
+        for (int y=0;y<4;y++)
+          for (int x=0;x<3;x++)
+            out[4*y+x] = in[3*y+x];
+        memcpy(p.data,&mat,sizeof(mat));
+      } else
+        readComponents<float>(name,value,(float*)p.data,16);
+      p.type = ANARI_FLOAT32_MAT4;
+      break;
+    default:
+      throw std::runtime_error
+        ("#pynari: unsupported type "+to_string((anari::DataType)type)
+         +" for parameter '"+name+"'");
+    }
+    return p;
+  }
+
+  /*! a python scalar for N==1, else a tuple of N python scalars */
+  template<typename T>
+  static py::object components(const uint8_t *data, int N)
+  {
+    const T *values = (const T *)data;
+    if (N == 1)
+      return py::cast(values[0]);
+    py::tuple result(N);
+    for (int i=0;i<N;i++)
+      result[i] = py::cast(values[i]);
+    return result;
+  }
+  
+  py::object encodeParam(const Param &p)
+  {
+    if (p.type == ANARI_STRING)
+      return py::str(p.string);
+    if (isObjectType(p.type))
+      return p.ref ? py::cast(p.ref) : py::none();
+    
+    switch (p.type) {
+    case ANARI_DATA_TYPE:
+    case ANARI_INT32:        return components<int32_t>(p.data,1);
+    case ANARI_BOOL:         return py::bool_(*(const int32_t *)p.data != 0);
+    case ANARI_INT32_VEC2:   return components<int32_t>(p.data,2);
+    case ANARI_INT32_VEC3:   return components<int32_t>(p.data,3);
+    case ANARI_INT32_VEC4:   return components<int32_t>(p.data,4);
+    case ANARI_UINT32:       return components<uint32_t>(p.data,1);
+    case ANARI_UINT32_VEC2:  return components<uint32_t>(p.data,2);
+    case ANARI_UINT32_VEC3:  return components<uint32_t>(p.data,3);
+    case ANARI_UINT32_VEC4:  return components<uint32_t>(p.data,4);
+    case ANARI_INT64:        return components<int64_t>(p.data,1);
+    case ANARI_UINT64:       return components<uint64_t>(p.data,1);
+    case ANARI_UINT8:
+    case ANARI_UFIXED8:      return components<uint8_t>(p.data,1);
+    case ANARI_UINT16:
+    case ANARI_UFIXED16:     return components<uint16_t>(p.data,1);
+    case ANARI_FLOAT32:      return components<float>(p.data,1);
+    case ANARI_FLOAT32_VEC2:
+    case ANARI_FLOAT32_BOX1: return components<float>(p.data,2);
+    case ANARI_FLOAT32_VEC3: return components<float>(p.data,3);
+    case ANARI_FLOAT32_VEC4:
+    case ANARI_FLOAT32_BOX2: return components<float>(p.data,4);
+    case ANARI_FLOAT32_BOX3: return components<float>(p.data,6);
+    case ANARI_FLOAT32_MAT3x4: return components<float>(p.data,12);
+    case ANARI_FLOAT32_MAT4: return components<float>(p.data,16);
+    default:
+      // a type whose value we don't record
+      return py::none();
+    }
+  }
+
+  /*! convert a single row-major 3x4 or 4x4 matrix into a
+      (column-major) mat4 */
+  template<typename T>
+  static void toMat4(const T *in, int numRows, anari::math::mat4 &out)
+  {
+    out = anari::math::identity;
+    float *o = (float *)&out;
+    for (int r=0;r<numRows;r++)
+      for (int c=0;c<4;c++)
+        o[4*c+r] = (float)in[4*r+c];
+  }
+
+  template<typename T>
+  static void toMat4s(const T *in, int numRows,
+                      std::vector<anari::math::mat4> &out)
+  {
+    parallel_for(out.size(),
+                 [&](size_t i) { toMat4(in+i*numRows*4,numRows,out[i]); },
+                 16*1024);
+  }
+  
+  std::vector<anari::math::mat4> decodeTransforms(const py::handle &value)
+  {
+    py::array array = py::array::ensure(value);
+    if (!array)
+      throw std::runtime_error
+        ("#pynari: transforms need to be a (N,3,4) or (N,4,4) array");
+    size_t numMatrices = 1;
+    int    numRows     = 0;
+    if (array.ndim() == 2 && array.shape(1) == 4)
+      numRows = (int)array.shape(0);
+    else if (array.ndim() == 3 && array.shape(2) == 4) {
+      numMatrices = array.shape(0);
+      numRows = (int)array.shape(1);
+    }
+    if (numRows != 3 && numRows != 4)
+      throw std::runtime_error
+        ("#pynari: transforms need to be a (N,3,4) or (N,4,4) array");
+
+    std::vector<anari::math::mat4> result(numMatrices);
+    const bool contiguous
+      = array.flags() & py::array::c_style;
+    if (contiguous && py::isinstance<py::array_t<float>>(array)) {
+      const float *in = (const float *)array.data();
+      py::gil_scoped_release noGIL;
+      toMat4s(in,numRows,result);
+    } else if (contiguous && py::isinstance<py::array_t<double>>(array)) {
+      const double *in = (const double *)array.data();
+      py::gil_scoped_release noGIL;
+      toMat4s(in,numRows,result);
+    } else {
+      auto asFloat
+        = py::array_t<float,py::array::c_style|py::array::forcecast>
+        ::ensure(array);
+      if (!asFloat)
+        throw std::runtime_error
+          ("#pynari: cannot convert transforms to float32");
+      const float *in = asFloat.data();
+      py::gil_scoped_release noGIL;
+      toMat4s(in,numRows,result);
+    }
+    return result;
+  }
+  
+  std::vector<Param> decodeParams(const py::handle &params)
+  {
+    std::vector<Param> result;
+    if (py::isinstance<py::dict>(params)) {
+      py::dict dict = py::reinterpret_borrow<py::dict>(params);
+      result.reserve(dict.size());
+      for (auto item : dict) {
+        std::string name = item.first.cast<std::string>();
+        py::sequence typeAndValue
+          = py::reinterpret_borrow<py::sequence>(item.second);
+        if (!py::isinstance<py::sequence>(item.second)
+            || typeAndValue.size() != 2)
+          throw std::runtime_error
+            ("#pynari: setParameters() expects dict entries of the form "
+             "'name : (type, value)' (in parameter '"+name+"')");
+        result.push_back(decodeParam(name,
+                                     typeAndValue[0].cast<int>(),
+                                     typeAndValue[1]));
+      }
+      return result;
+    }
+    if (py::isinstance<py::sequence>(params)) {
+      py::sequence list = py::reinterpret_borrow<py::sequence>(params);
+      result.reserve(list.size());
+      for (auto item : list) {
+        py::sequence tuple = py::reinterpret_borrow<py::sequence>(item);
+        if (!py::isinstance<py::sequence>(item) || tuple.size() != 3)
+          throw std::runtime_error
+            ("#pynari: setParameters() expects list entries of the form "
+             "'(name, type, value)'");
+        result.push_back(decodeParam(tuple[0].cast<std::string>(),
+                                     tuple[1].cast<int>(),
+                                     tuple[2]));
+      }
+      return result;
+    }
+    throw std::runtime_error
+      ("#pynari: setParameters() expects either a dict or a list of tuples");
+  }
+
+}
@@ -0,0 +1,87 @@
+// ======================================================================== //
+// Copyright 2024++ Ingo Wald                                               //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include "pynari/common.h"
+
+namespace pynari {
+
+  struct Object;
+  
+  /*! a single parameter value that has already been decoded from its
+      python representation into exactly the bytes that
+      anariSetParameter expects for the given type. Decoding requires
+      the GIL; applying a decoded param does not, so a whole batch of
+      params can be decoded first, and then be applied with the GIL
+      released */
+  struct Param {
+    std::string     name;
+    anari::DataType type = ANARI_UNKNOWN;
+    /*! value for all 'plain' (scalar, vector, matrix, box) types; a
+        mat4 is the largest of those */
+    alignas(16) uint8_t data[64];
+    /*! value for ANARI_STRING */
+    std::string     string;
+    /*! value for any object type; may be null */
+    anari::Object   object = {};
+    /*! the pynari object that 'object' belongs to, if known; keeps
+        that python-side object (and thus whatever it in turn refers
+        to) alive and reachable for as long as this param is set to
+        it */
+    std::shared_ptr<Object> ref;
+
+    /*! pointer to the value as it has to be passed to anari */
+    const void *ptr() const;
+
+    /*! (re-)set this param's value from the same 'mem' pointer that
+        gets passed to anariSetParameter */
+    void set(anari::DataType type, const void *mem);
+    
+    /*! whether this param currently holds exactly the value that
+        'mem' points to. Always false for types whose size we do not
+        know */
+    bool holds(anari::DataType type, const void *mem) const;
+  };
+
+  /*! size (in bytes) of a single value of given (non-object,
+      non-string) type; or 0 if that's not a type pynari knows */
+  size_t sizeOfType(anari::DataType type);
+
+  /*! decode one python value of given anari type into a Param */
+  Param decodeParam(const std::string &name, int type,
+                    const py::handle &value);
+
+  /*! the inverse of decodeParam(): the python value for given
+      param, in the same form decodeParam() accepts it (tuples for
+      vectors and boxes, a flat column-major 16-tuple for matrices,
+      the pynari object for object types) */
+  py::object encodeParam(const Param &p);
+
+  /*! decode a whole set of params, either from a dict of the form
+      `{ name : (type, value) }`, or from a list of tuples of the form
+      `[ (name, type, value), ... ]` */
+  std::vector<Param> decodeParams(const py::handle &params);
+
+  /*! decode a numpy array of affine transforms - of shape (N,3,4) or
+      (N,4,4), or (3,4) or (4,4) for a single one - into mat4s. Each
+      (3,4)/(4,4) block is read as a regular row-major matrix (ie,
+      the translation is its last column). float32 and float64 arrays
+      get read in place, anything else gets converted to float32
+      first */
+  std::vector<anari::math::mat4> decodeTransforms(const py::handle &value);
+
+}
@@ -0,0 +1,153 @@
+// ======================================================================== //
+// Copyright 2024++ Ingo Wald                                               //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+#include "pynari/PostProcess.h"
+#include "pynari/parallel.h"
+#include <cmath>
+
+namespace pynari {
+
+  enum { GAMMA_TABLE_SIZE = 4096 };
+  
+  PostProcess::PostProcess(float exposure, ToneMap toneMap,
+                           Gamma gammaMode, float gamma,
+                           bool quantize, bool dither)
+    : scale(powf(2.f,exposure)),
+      toneMap(toneMap),
+      quantize(quantize),
+      dither(dither)
+  {
+    // what gets added before rounding down when quantizing: .5 to
+    // round to nearest, plus - when dithering - triangular-distributed
+    // noise of +/-1 step, in a tile that repeats over the frame
+    quantizeOffsets.resize(4*DITHER_TILE*(dither ? DITHER_TILE : 1),.5f);
+    if (dither)
+      for (size_t i=0;i<quantizeOffsets.size();i++) {
+        if ((i & 3) == 3) continue;
+        uint32_t h = uint32_t(i)*0x8da6b343u;
+        h ^= h >> 16; h *= 0x7feb352du;
+        h ^= h >> 15; h *= 0x846ca68bu;
+        h ^= h >> 16;
+        quantizeOffsets[i] += ((h & 0xffff) + (h >> 16)) * (1.f/65536.f) - 1.f;
+      }
+    
+    if (gammaMode == GAMMA_NONE) return;
+    // one extra entry, so interpolating at 1 doesn't need a special
+    // case
+    gammaTable.resize(GAMMA_TABLE_SIZE+2);
+    for (int i=0;i<(int)gammaTable.size();i++) {
+      const double x = std::min(1.,double(i)/GAMMA_TABLE_SIZE);
+      gammaTable[i]
+        = gammaMode == GAMMA_POWER ? float(pow(x,1./gamma))
+        : x <= .0031308            ? float(12.92*x)
+        :                            float(1.055*pow(x,1./2.4)-.055);
+    }
+  }
+
+  namespace {
+
+    template<int TONEMAP> inline float toneMapped(float x);
+    template<> inline float toneMapped<PostProcess::TONEMAP_NONE>(float x)
+    { return x; }
+    template<> inline float toneMapped<PostProcess::TONEMAP_REINHARD>(float x)
+    { x = std::max(x,0.f); return x/(1.f+x); }
+    /*! Narkowicz' fit of the ACES filmic curve */
+    template<> inline float toneMapped<PostProcess::TONEMAP_ACES>(float x)
+    {
+      x = std::max(x,0.f);
+      return std::min(1.f,(x*(2.51f*x+.03f))/(x*(2.43f*x+.59f)+.14f));
+    }
+
+    /*! one row of pixels. Each step is a separate loop, without
+        branches, over a small block of pixels that stays in L1, so
+        compilers can vectorize each of them */
+    template<int TONEMAP>
+    void processRow(const PostProcess &pp, const float *in, uint32_t width,
+                    uint32_t y, float *outFloat, uint8_t *out8)
+    {
+      enum { BLOCK = PostProcess::DITHER_TILE };
+      float rgba[4*BLOCK];
+      const float *gamma = pp.gammaTable.empty() ? nullptr : pp.gammaTable.data();
+      const float *offsets = pp.quantizeOffsets.data()
+        + (pp.dither ? 4*BLOCK*(y % PostProcess::DITHER_TILE) : 0);
+      const float scale = pp.scale;
+      for (uint32_t x0=0;x0<width;x0+=BLOCK) {
+        const uint32_t n = std::min<uint32_t>(BLOCK,width-x0);
+        const float *src = in+4*x0;
+        // all four channels, then put alpha back
+        for (uint32_t i=0;i<4*n;i++)
+          rgba[i] = toneMapped<TONEMAP>(src[i]*scale);
+        if (gamma)
+          for (uint32_t i=0;i<4*n;i++) {
+            const float f = std::min(1.f,std::max(0.f,rgba[i]))*GAMMA_TABLE_SIZE;
+            const int   j = int(f);
+            const float t = f-j;
+            rgba[i] = gamma[j] + t*(gamma[j+1]-gamma[j]);
+          }
+        for (uint32_t i=0;i<n;i++)
+          rgba[4*i+3] = src[4*i+3];
+        if (!out8) {
+          memcpy(outFloat+4*x0,rgba,4*n*sizeof(float));
+          continue;
+        }
+        uint8_t *dst = out8+4*x0;
+        for (uint32_t i=0;i<4*n;i++)
+          dst[i] = uint8_t(std::min(255.f,std::max(0.f,rgba[i]*255.f+offsets[i])));
+      }
+    }
+    
+  }
+  
+  void PostProcess::run(const float *in, uint32_t width, uint32_t height,
+                        void *out) const
+  {
+    auto rows = [&](auto processRow) {
+      parallel_for(height,[&](size_t y) {
+        processRow(*this,in+4*size_t(width)*y,width,(uint32_t)y,
+                   quantize ? nullptr : (float *)out+4*size_t(width)*y,
+                   quantize ? (uint8_t *)out+4*size_t(width)*y : nullptr);
+      },8);
+    };
+    switch (toneMap) {
+    case TONEMAP_NONE:     rows(processRow<TONEMAP_NONE>);     break;
+    case TONEMAP_REINHARD: rows(processRow<TONEMAP_REINHARD>); break;
+    case TONEMAP_ACES:     rows(processRow<TONEMAP_ACES>);     break;
+    }
+  }
+  
+  py::object PostProcess::apply(const float *in, uint32_t width, uint32_t height) const
+  {
+    if (quantize) {
+      py::array_t<uint8_t> result({(size_t)height,(size_t)width,(size_t)4});
+      uint8_t *out = result.mutable_data();
+      {
+        py::gil_scoped_release noGIL;
+        run(in,width,height,out);
+      }
+      return std::move(result);
+    } else {
+      py::array_t<float> result({(size_t)height,(size_t)width,(size_t)4});
+      float *out = result.mutable_data();
+      {
+        py::gil_scoped_release noGIL;
+        run(in,width,height,out);
+      }
+      return std::move(result);
+    }
+  }
+  
+}
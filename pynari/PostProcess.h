@@ -0,0 +1,69 @@
+// ======================================================================== //
+// Copyright 2024++ Ingo Wald                                               //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+#pragma once
+
+#include "pynari/common.h"
+
+namespace pynari {
+
+  /*! a chain of post-processing steps that turns a float (linear,
+      HDR) RGBA frame buffer into a displayable one, applied while
+      the frame gets read back: exposure, then tone mapping, then
+      gamma (or sRGB) encoding, then - optionally - quantizing to 8
+      bits, with or without dithering. Alpha passes through as
+      is. Once created, a PostProcess doesn't change, so frames can
+      use it without locking */
+  struct PostProcess {
+    typedef std::shared_ptr<PostProcess> SP;
+    
+    enum ToneMap { TONEMAP_NONE, TONEMAP_REINHARD, TONEMAP_ACES };
+    enum Gamma   { GAMMA_NONE, GAMMA_SRGB, GAMMA_POWER };
+    /*! dither noise repeats every DITHER_TILE pixels in x and y */
+    enum { DITHER_TILE = 64 };
+
+    /*! 'exposure' is in stops, ie, colors get scaled by
+        2^exposure; 'gamma' is only used for GAMMA_POWER, where
+        values get raised to 1/gamma */
+    PostProcess(float exposure, ToneMap toneMap,
+                Gamma gammaMode, float gamma,
+                bool quantize, bool dither);
+
+    /*! runs the chain over a (width x height) frame of float RGBA
+        pixels, and writes the result to 'out' - 8-bit RGBA if
+        quantizing, else float RGBA. Runs in parallel over rows, and
+        doesn't need the GIL */
+    void run(const float *in, uint32_t width, uint32_t height,
+             void *out) const;
+
+    /*! same, but into a new (height,width,4) numpy array */
+    py::object apply(const float *in, uint32_t width, uint32_t height) const;
+    
+    const float   scale;
+    const ToneMap toneMap;
+    const bool    quantize;
+    const bool    dither;
+    /*! the gamma curve, sampled over [0,1], to interpolate from;
+        empty for GAMMA_NONE */
+    std::vector<float> gammaTable;
+    /*! for quantizing: per-channel values to add before rounding
+        down, for one (DITHER_TILE x DITHER_TILE) tile of pixels if
+        dithering, else for one row of DITHER_TILE pixels */
+    std::vector<float> quantizeOffsets;
+  };
+  
+}
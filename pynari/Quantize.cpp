@@ -0,0 +1,115 @@
+// ======================================================================== //
+// Copyright 2024++ Ingo Wald                                               //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+#include "pynari/Context.h"
+#include "pynari/Array.h"
+#include "pynari/parallel.h"
+
+namespace pynari {
+
+  typedef py::array_t<float,py::array::c_style|py::array::forcecast>
+  FloatArray;
+
+  /*! min and max of all (non-NaN) values in 'in' */
+  static std::pair<float,float> valueRange(const float *in, size_t count)
+  {
+    float lo = +std::numeric_limits<float>::infinity();
+    float hi = -std::numeric_limits<float>::infinity();
+    std::mutex mutex;
+    parallel_for_blocked
+      (count,256*1024,
+       [&](size_t begin, size_t end) {
+         float blockLo = +std::numeric_limits<float>::infinity();
+         float blockHi = -std::numeric_limits<float>::infinity();
+         for (size_t i=begin;i<end;i++) {
+           blockLo = std::min(blockLo,in[i]);
+           blockHi = std::max(blockHi,in[i]);
+         }
+         std::lock_guard<std::mutex> lock(mutex);
+         lo = std::min(lo,blockLo);
+         hi = std::max(hi,blockHi);
+       });
+    return { lo, hi };
+  }
+
+  /*! maps [lo,hi] to [0,maxValue] (rounding to nearest, clamping
+      anything outside that range, and NaNs to 0); the inner loop is
+      branch-free so the compiler can vectorize it */
+  template<typename T>
+  static void quantize(const float *in, T *out, size_t count,
+                       float lo, float hi)
+  {
+    const float maxValue = float(std::numeric_limits<T>::max());
+    const float scale = hi > lo ? maxValue/(hi-lo) : 0.f;
+    parallel_for_blocked
+      (count,256*1024,
+       [&](size_t begin, size_t end) {
+         for (size_t i=begin;i<end;i++) {
+           float v = (in[i]-lo)*scale + .5f;
+           v = v > 0.f ? v : 0.f;
+           v = v < maxValue ? v : maxValue;
+           out[i] = T(v);
+         }
+       });
+  }
+  
+  py::tuple Context::newArray3DQuantized(const py::buffer &_data,
+                                         int bits,
+                                         const py::object &_range)
+  {
+    if (bits != 8 && bits != 16)
+      throw std::runtime_error("#pynari: newArray3DQuantized: 'bits' "
+                               "has to be either 8 or 16");
+    FloatArray data = FloatArray::ensure(_data);
+    if (!data || data.ndim() != 3)
+      throw std::runtime_error
+        ("#pynari: newArray3DQuantized: 'data' needs to be a 3D array "
+         "of shape (nz,ny,nx)");
+    bool haveRange = !_range.is_none();
+    float lo = 0.f, hi = 0.f;
+    if (haveRange) {
+      auto range = _range.cast<std::tuple<float,float>>();
+      lo = std::get<0>(range);
+      hi = std::get<1>(range);
+    }
+    const std::vector<uint64_t> dims = {
+      (uint64_t)data.shape(2), (uint64_t)data.shape(1), (uint64_t)data.shape(0)
+    };
+    const float *in = data.data();
+    const size_t count = data.size();
+
+    std::shared_ptr<Array> array;
+    {
+      py::gil_scoped_release noGIL;
+      if (!haveRange) {
+        std::tie(lo,hi) = valueRange(in,count);
+        if (lo > hi)
+          // no (non-NaN) values at all
+          lo = hi = 0.f;
+      }
+      array = create<Array>(bits == 8 ? ANARI_UFIXED8 : ANARI_UFIXED16,dims);
+      void *mapped = anariMapArray(device->handle,array->handle);
+      if (bits == 8)
+        quantize(in,(uint8_t *)mapped,count,lo,hi);
+      else
+        quantize(in,(uint16_t *)mapped,count,lo,hi);
+      anariUnmapArray(device->handle,array->handle);
+    }
+    return py::make_tuple(array,py::make_tuple(lo,hi));
+  }
+  
+}
@@ -29,6 +29,7 @@ namespace pynari {
 
     std::string toString() const override { return "pynari::Renderer<"+type+">"; }
     ANARIDataType anariType() const override { return ANARI_RENDERER; }
+    std::string subtype() const override { return type; }
     
     const std::string type;
   };
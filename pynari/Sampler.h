@@ -32,6 +32,7 @@ namespace pynari {
     
     std::string   toString()  const override { return "pynari::Sampler"; }
     ANARIDataType anariType() const override { return ANARI_SAMPLER; }
+    std::string subtype() const override { return type; }
     
     const std::string type;
   };
@@ -0,0 +1,378 @@
+// ======================================================================== //
+// Copyright 2024++ Ingo Wald                                               //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "pynari/Context.h"
+#include "pynari/Array.h"
+#include "pynari/MappedFile.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+
+/*! .pnsc scene files are laid out as
+
+    SceneFileHeader
+    SceneFileObject[numObjects]   - children before parents
+    SceneFileParam[numParams]     - grouped by object
+    strings                       - zero-terminated, back to back
+    array data                    - each block 64-byte aligned
+
+    so that loading can hand array data to the device as shared
+    arrays that point straight into the memory-mapped file */
+
+namespace pynari {
+  namespace {
+
+    const char     sceneFileMagic[8] = { 'P','Y','N','A','R','I','S','C' };
+    const uint32_t sceneFileVersion  = 1;
+    const uint32_t noObject          = ~0u;
+    const uint64_t dataAlignment     = 64;
+    
+    struct SceneFileHeader {
+      char     magic[8];
+      uint32_t version;
+      uint32_t numObjects;
+      uint32_t numParams;
+      uint32_t rootObject;
+      uint64_t objectsOffset;
+      uint64_t paramsOffset;
+      uint64_t stringsOffset;
+      uint64_t stringsSize;
+      uint64_t reserved;
+    };
+    
+    struct SceneFileObject {
+      uint32_t type;
+      /*! offset into string table */
+      uint32_t subtype;
+      uint32_t firstParam;
+      uint32_t numParams;
+      /*! for arrays: element type, dims, and where their data is. For
+          arrays of objects the data is one uint32 object index per
+          element */
+      uint32_t elementType;
+      uint32_t numDims;
+      uint64_t dims[3];
+      uint64_t dataOffset;
+      uint64_t dataSize;
+    };
+    
+    struct SceneFileParam {
+      /*! offset into string table */
+      uint32_t name;
+      uint32_t type;
+      /*! for object types: index of the object, or noObject */
+      uint32_t object;
+      /*! for strings: offset into string table */
+      uint32_t string;
+      uint8_t  data[64];
+    };
+
+    static_assert(sizeof(SceneFileHeader) == 64, "unexpected header layout");
+    static_assert(sizeof(SceneFileObject) == 64, "unexpected object layout");
+    static_assert(sizeof(SceneFileParam)  == 80, "unexpected param layout");
+
+    inline bool isArrayType(uint32_t type)
+    {
+      return type == ANARI_ARRAY1D || type == ANARI_ARRAY2D || type == ANARI_ARRAY3D;
+    }
+    
+    inline uint64_t alignUp(uint64_t offset)
+    { return (offset+dataAlignment-1)/dataAlignment*dataAlignment; }
+    
+    /*! flattens the object graph below a root into file records */
+    struct SceneWriter {
+      uint32_t add(Object *object);
+      uint32_t addString(const std::string &s);
+
+      std::vector<SceneFileObject> objects;
+      std::vector<SceneFileParam>  params;
+      std::string                  strings;
+      /*! the pynari object behind each record */
+      std::vector<Object *>        sources;
+      /*! for arrays of objects: their elements' object indices */
+      std::unordered_map<uint32_t,std::vector<uint32_t>> elementLists;
+      std::unordered_map<Object *,uint32_t>    indexOf;
+      std::unordered_map<std::string,uint32_t> stringOffsets;
+    };
+
+    uint32_t SceneWriter::addString(const std::string &s)
+    {
+      auto known = stringOffsets.find(s);
+      if (known != stringOffsets.end()) return known->second;
+      uint32_t offset = (uint32_t)strings.size();
+      strings += s;
+      strings.push_back(0);
+      stringOffsets[s] = offset;
+      return offset;
+    }
+    
+    uint32_t SceneWriter::add(Object *object)
+    {
+      auto known = indexOf.find(object);
+      if (known != indexOf.end()) {
+        if (known->second == noObject)
+          throw std::runtime_error("#pynari: saveScene: cycle in scene graph");
+        return known->second;
+      }
+      indexOf[object] = noObject;
+      
+      // children first, so loading can create objects in file order
+      std::vector<Param> shadow = object->getShadowParams();
+      std::vector<uint32_t> paramObjects(shadow.size(),noObject);
+      for (size_t i=0;i<shadow.size();i++) {
+        const Param &p = shadow[i];
+        if (!isObjectType(p.type) || !p.object) continue;
+        if (!p.ref)
+          throw std::runtime_error("#pynari: saveScene: parameter '"+p.name
+                                   +"' refers to an object that was not"
+                                   " created through pynari");
+        paramObjects[i] = add(p.ref.get());
+      }
+      Array *array = dynamic_cast<Array *>(object);
+      std::vector<uint32_t> elements;
+      if (array)
+        for (auto &element : array->objects)
+          elements.push_back(add(element.get()));
+      
+      SceneFileObject record;
+      memset(&record,0,sizeof(record));
+      record.type       = object->anariType();
+      record.subtype    = addString(object->subtype());
+      record.firstParam = (uint32_t)params.size();
+      record.numParams  = (uint32_t)shadow.size();
+      for (size_t i=0;i<shadow.size();i++) {
+        const Param &p = shadow[i];
+        SceneFileParam out;
+        memset(&out,0,sizeof(out));
+        out.name   = addString(p.name);
+        out.type   = p.type;
+        out.object = paramObjects[i];
+        out.string = noObject;
+        if (p.type == ANARI_STRING)
+          out.string = addString(p.string);
+        else if (!isObjectType(p.type)) {
+          size_t size = sizeOfType(p.type);
+          if (size == 0)
+            throw std::runtime_error("#pynari: saveScene: cannot save parameter '"
+                                     +p.name+"' of type "+to_string(p.type));
+          memcpy(out.data,p.data,size);
+        }
+        params.push_back(out);
+      }
+
+      uint32_t index = (uint32_t)objects.size();
+      if (array) {
+        record.elementType = array->elementType;
+        record.numDims     = array->nDims;
+        for (int d=0;d<3;d++) record.dims[d] = array->dims[d];
+        if (isObjectType(array->elementType)) {
+          record.dataSize = elements.size()*sizeof(uint32_t);
+          elementLists[index] = elements;
+        } else
+          record.dataSize = array->dataBytes;
+      }
+      objects.push_back(record);
+      sources.push_back(object);
+      indexOf[object] = index;
+      return index;
+    }
+
+    /*! whether [begin,begin+count) lies within [0,size); written such
+        that neither sum can overflow for arbitrary (untrusted) file
+        offsets */
+    inline bool inBounds(uint64_t begin, uint64_t count, uint64_t size)
+    { return begin <= size && count <= size-begin; }
+
+    inline void loadError(const std::string &fileName, const std::string &what)
+    {
+      throw std::runtime_error("#pynari: loadScene('"+fileName+"'): "+what);
+    }
+  }
+  
+  void Context::saveScene(const Object::SP &root, const std::string &fileName)
+  {
+    if (!root)
+      throw std::runtime_error("#pynari: saveScene: no root object given");
+    py::gil_scoped_release noGIL;
+    
+    SceneWriter writer;
+    uint32_t rootIndex = writer.add(root.get());
+
+    SceneFileHeader header;
+    memset(&header,0,sizeof(header));
+    memcpy(header.magic,sceneFileMagic,sizeof(header.magic));
+    header.version       = sceneFileVersion;
+    header.numObjects    = (uint32_t)writer.objects.size();
+    header.numParams     = (uint32_t)writer.params.size();
+    header.rootObject    = rootIndex;
+    header.objectsOffset = sizeof(header);
+    header.paramsOffset
+      = header.objectsOffset + writer.objects.size()*sizeof(SceneFileObject);
+    header.stringsOffset
+      = header.paramsOffset + writer.params.size()*sizeof(SceneFileParam);
+    header.stringsSize   = writer.strings.size();
+    uint64_t offset = header.stringsOffset + header.stringsSize;
+    for (auto &record : writer.objects) {
+      if (!isArrayType(record.type)) continue;
+      offset = alignUp(offset);
+      record.dataOffset = offset;
+      offset += record.dataSize;
+    }
+
+    std::ofstream out(fileName,std::ios::binary);
+    if (!out)
+      throw std::runtime_error("#pynari: could not open '"+fileName
+                               +"' for writing");
+    out.write((const char *)&header,sizeof(header));
+    out.write((const char *)writer.objects.data(),
+              writer.objects.size()*sizeof(SceneFileObject));
+    out.write((const char *)writer.params.data(),
+              writer.params.size()*sizeof(SceneFileParam));
+    out.write(writer.strings.data(),writer.strings.size());
+    
+    offset = header.stringsOffset + header.stringsSize;
+    const char padding[dataAlignment] = { 0 };
+    for (size_t i=0;i<writer.objects.size();i++) {
+      const SceneFileObject &record = writer.objects[i];
+      if (!isArrayType(record.type)) continue;
+      out.write(padding,record.dataOffset-offset);
+      auto elements = writer.elementLists.find((uint32_t)i);
+      if (elements != writer.elementLists.end())
+        out.write((const char *)elements->second.data(),record.dataSize);
+      else if (record.dataSize) {
+        Array *array = (Array *)writer.sources[i];
+        const void *data = anariMapArray(device->handle,array->handle);
+        out.write((const char *)data,record.dataSize);
+        anariUnmapArray(device->handle,array->handle);
+      }
+      offset = record.dataOffset + record.dataSize;
+    }
+    out.close();
+    if (!out)
+      throw std::runtime_error("#pynari: error writing '"+fileName+"'");
+  }
+  
+  Object::SP Context::loadScene(const std::string &fileName)
+  {
+    py::gil_scoped_release noGIL;
+    MappedFile::SP file = MappedFile::open(fileName);
+
+    SceneFileHeader header;
+    if (file->size < sizeof(header))
+      loadError(fileName,"not a pynari scene file");
+    memcpy(&header,file->data,sizeof(header));
+    if (memcmp(header.magic,sceneFileMagic,sizeof(header.magic)) != 0)
+      loadError(fileName,"not a pynari scene file");
+    if (header.version != sceneFileVersion)
+      loadError(fileName,"unsupported version "+std::to_string(header.version));
+    // (the counts are 32-bit, so the products can't overflow)
+    if (!inBounds(header.objectsOffset,
+                  uint64_t(header.numObjects)*sizeof(SceneFileObject),
+                  file->size) ||
+        !inBounds(header.paramsOffset,
+                  uint64_t(header.numParams)*sizeof(SceneFileParam),
+                  file->size) ||
+        !inBounds(header.stringsOffset,header.stringsSize,file->size) ||
+        header.stringsSize == 0 ||
+        file->data[header.stringsOffset+header.stringsSize-1] != 0 ||
+        header.rootObject >= header.numObjects)
+      loadError(fileName,"file is truncated or corrupt");
+    
+    const SceneFileObject *records
+      = (const SceneFileObject *)(file->data+header.objectsOffset);
+    const SceneFileParam *params
+      = (const SceneFileParam *)(file->data+header.paramsOffset);
+    const char *strings = (const char *)file->data+header.stringsOffset;
+    auto string = [&](uint32_t offset) -> const char * {
+      if (offset >= header.stringsSize)
+        loadError(fileName,"invalid string reference");
+      return strings+offset;
+    };
+    
+    std::vector<Object::SP> objects(header.numObjects);
+    auto object = [&](uint32_t index, uint32_t current) -> Object::SP {
+      // children always come before their parents
+      if (index >= current)
+        loadError(fileName,"invalid object reference");
+      return objects[index];
+    };
+    
+    for (uint32_t i=0;i<header.numObjects;i++) {
+      const SceneFileObject &record = records[i];
+      if (!isArrayType(record.type)) {
+        objects[i] = newObject(record.type,string(record.subtype));
+      } else {
+        if (!inBounds(record.dataOffset,record.dataSize,file->size) ||
+            record.dataOffset % dataAlignment ||
+            record.numDims < 1 || record.numDims > 3)
+          loadError(fileName,"invalid array record");
+        const uint8_t *data = file->data+record.dataOffset;
+        if (isObjectType(record.elementType)) {
+          std::vector<Object::SP> elements(record.dataSize/sizeof(uint32_t));
+          for (size_t e=0;e<elements.size();e++)
+            elements[e] = object(((const uint32_t *)data)[e],i);
+          objects[i] = create<Array>((anari::DataType)record.elementType,
+                                     elements);
+        } else {
+          std::vector<uint64_t> dims(record.dims,record.dims+record.numDims);
+          uint64_t numBytes = sizeOfType(record.elementType);
+          if (numBytes == 0)
+            loadError(fileName,"invalid array element type");
+          // dataSize is known to fit the file, so check each step of
+          // the product against that rather than letting it wrap
+          if (std::find(dims.begin(),dims.end(),0) != dims.end())
+            numBytes = 0;
+          for (auto dim : dims) {
+            if (numBytes > record.dataSize/std::max<uint64_t>(dim,1))
+              loadError(fileName,"array size mismatch");
+            numBytes *= dim;
+          }
+          if (numBytes != record.dataSize)
+            loadError(fileName,"array size mismatch");
+          objects[i] = create<Array>((anari::DataType)record.elementType,
+                                     dims,(const void *)data,file);
+        }
+      }
+      
+      if (record.firstParam+(uint64_t)record.numParams > header.numParams)
+        loadError(fileName,"invalid parameter range");
+      for (uint32_t j=0;j<record.numParams;j++) {
+        const SceneFileParam &p = params[record.firstParam+j];
+        const char *name = string(p.name);
+        anari::DataType type = p.type;
+        if (type == ANARI_STRING)
+          objects[i]->setParam(name,type,string(p.string));
+        else if (isObjectType(type)) {
+          Object::SP child;
+          anari::Object handle = {};
+          if (p.object != noObject) {
+            child  = object(p.object,i);
+            handle = child->handle;
+          }
+          objects[i]->setParam(name,type,&handle,child);
+        } else if (sizeOfType(type) != 0)
+          objects[i]->setParam(name,type,p.data);
+        else
+          loadError(fileName,"invalid type for parameter '"
+                    +std::string(name)+"'");
+      }
+      objects[i]->commit();
+    }
+    return objects[header.rootObject];
+  }
+  
+}
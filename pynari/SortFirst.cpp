@@ -0,0 +1,211 @@
+// ======================================================================== //
+// Copyright 2024++ Ingo Wald                                               //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "pynari/SortFirst.h"
+#include "pynari/Context.h"
+#include "pynari/Frame.h"
+#include <chrono>
+#include <cstring>
+#include <exception>
+#include <thread>
+
+namespace pynari {
+
+  SortFirst::SortFirst(Frame *frame)
+    : frame(frame)
+  {
+    Context *context = frame->device->context;
+    workers.resize(1+context->workers.size());
+    workers[0].cloner = std::make_unique<Cloner>(context);
+    for (size_t i=0;i<context->workers.size();i++) {
+      workers[i+1].context = context->workers[i];
+      workers[i+1].cloner  = std::make_unique<Cloner>(context->workers[i].get());
+    }
+  }
+
+  void SortFirst::assignRows()
+  {
+    const size_t numWorkers = workers.size();
+    // before the first frame, assume all rows cost the same
+    auto costOf = [&](uint32_t row)
+    { return rowCost.empty() ? 1. : rowCost[row]; };
+    double totalCost = 0.;
+    for (uint32_t row=0;row<height;row++) totalCost += costOf(row);
+
+    uint32_t row = 0;
+    double cost = 0.;
+    for (size_t i=0;i<numWorkers;i++) {
+      Worker &worker = workers[i];
+      worker.rowBegin = row;
+      if (i == numWorkers-1) {
+        row = height;
+      } else {
+        // leave at least one row for each of the remaining workers
+        // (as long as there are enough rows)
+        uint32_t numLater = uint32_t(numWorkers-1-i);
+        uint32_t maxRow = height > numLater ? height-numLater : height;
+        double target = totalCost*(i+1)/numWorkers;
+        while (row < maxRow &&
+               (row == worker.rowBegin || cost+0.5*costOf(row) < target))
+          cost += costOf(row++);
+      }
+      worker.rowEnd = row;
+    }
+  }
+  
+  void SortFirst::render()
+  {
+    // what the frame is set up to render
+    Object::SP frameSP = frame->shared_from_this();
+    std::vector<Param> params = frame->getShadowParams();
+    const Param *sizeParam = nullptr, *colorParam = nullptr;
+    Object::SP world, camera, renderer;
+    for (auto &p : params) {
+      if (p.name == "size" && p.type == ANARI_UINT32_VEC2) sizeParam = &p;
+      if (p.name == "channel.color" && p.type == ANARI_DATA_TYPE) colorParam = &p;
+      if (p.name == "world")    world    = p.ref;
+      if (p.name == "camera")   camera   = p.ref;
+      if (p.name == "renderer") renderer = p.ref;
+    }
+    if (!sizeParam || !camera)
+      throw std::runtime_error("#pynari: multi-device frame needs a 'size'"
+                               " and a 'camera'");
+    const uint32_t *size = (const uint32_t *)sizeParam->data;
+    pixelType
+      = colorParam
+      ? *(const anari::DataType *)colorParam->data
+      : (anari::DataType)ANARI_UFIXED8_RGBA_SRGB;
+    size_t pixelSize;
+    if (pixelType == ANARI_FLOAT32_VEC4)
+      pixelSize = 4*sizeof(float);
+    else if (pixelType == ANARI_UFIXED8_VEC4 ||
+             pixelType == ANARI_UFIXED8_RGBA_SRGB)
+      pixelSize = 4*sizeof(uint8_t);
+    else
+      throw std::runtime_error("#pynari: multi-device frames currently only"
+                               " support color channels of type"
+                               " FLOAT32_VEC4, UFIXED8_VEC4, or"
+                               " UFIXED8_RGBA_SRGB");
+    if (size[0] != width || size[1] != height)
+      rowCost.clear();
+    width  = size[0];
+    height = size[1];
+    composite.resize(size_t(width)*height*pixelSize);
+
+    // the region of the image the user's camera is looking at; each
+    // strip gets the corresponding part of that
+    float region[4] = { 0.f, 0.f, 1.f, 1.f };
+    for (auto &p : camera->getShadowParams())
+      if (p.name == "imageRegion" && p.type == ANARI_FLOAT32_BOX2)
+        memcpy(region,p.data,sizeof(region));
+    
+    assignRows();
+
+    // mirror the scene to all devices first, serially on this
+    // thread: cloning reads array data from the frame's own device,
+    // which must not happen while another thread uses that device
+    std::vector<Frame::SP> strips(workers.size());
+    for (size_t workerID=0;workerID<workers.size();workerID++) {
+      Worker &worker = workers[workerID];
+      worker.renderTime = 0.;
+      if (worker.rowBegin == worker.rowEnd) continue;
+      Cloner &cloner = *worker.cloner;
+      cloner.beginPass();
+      if (workerID == 0) {
+        // the frame's own device already has the scene
+        if (world)    cloner.share(world);
+        if (renderer) cloner.share(renderer);
+      }
+      uint32_t stripSize[2] = { width, worker.rowEnd-worker.rowBegin };
+      std::vector<Param> frameOverrides(1);
+      frameOverrides[0].name = "size";
+      frameOverrides[0].set(ANARI_UINT32_VEC2,stripSize);
+      cloner.setOverrides(frameSP,frameOverrides);
+      
+      float stripRegion[4] = {
+        region[0],
+        region[1] + (region[3]-region[1])*worker.rowBegin/height,
+        region[2],
+        region[1] + (region[3]-region[1])*worker.rowEnd/height
+      };
+      std::vector<Param> cameraOverrides(1);
+      cameraOverrides[0].name = "imageRegion";
+      cameraOverrides[0].set(ANARI_FLOAT32_BOX2,stripRegion);
+      cloner.setOverrides(camera,cameraOverrides);
+
+      strips[workerID] = std::dynamic_pointer_cast<Frame>(cloner.clone(frameSP));
+    }
+
+    // ... then render on all of them in parallel; each thread only
+    // ever touches its own device
+    auto renderStrip = [&](Worker &worker, const Frame::SP &strip) {
+      if (!strip) return;
+      const uint32_t stripHeight = worker.rowEnd-worker.rowBegin;
+      auto begin = std::chrono::steady_clock::now();
+      strip->device->flushDeferredCommits();
+      strip->renderOnThisDevice();
+      worker.renderTime
+        = std::chrono::duration<double>(std::chrono::steady_clock::now()-begin).count();
+
+      anari::Device device = strip->device->handle;
+      uint32_t mappedWidth, mappedHeight;
+      ANARIDataType mappedType;
+      const uint8_t *mapped
+        = (const uint8_t *)anariMapFrame(device,(ANARIFrame)strip->handle,
+                                         "channel.color",
+                                         &mappedWidth,&mappedHeight,&mappedType);
+      if (mappedType != pixelType || mappedWidth != width ||
+          mappedHeight != stripHeight) {
+        anariUnmapFrame(device,(ANARIFrame)strip->handle,"channel.color");
+        throw std::runtime_error("#pynari: device rendered strip of"
+                                 " unexpected size or format");
+      }
+      // first row is the bottom one in both frame buffers
+      memcpy(composite.data()+size_t(worker.rowBegin)*width*pixelSize,
+             mapped,size_t(mappedWidth)*mappedHeight*pixelSize);
+      anariUnmapFrame(device,(ANARIFrame)strip->handle,"channel.color");
+    };
+
+    // one thread per device
+    std::vector<std::exception_ptr> errors(workers.size());
+    std::vector<std::thread> threads;
+    for (size_t i=0;i<workers.size();i++)
+      threads.emplace_back([&,i]() {
+        try {
+          renderStrip(workers[i],strips[i]);
+        } catch (...) {
+          errors[i] = std::current_exception();
+        }
+      });
+    for (auto &thread : threads) thread.join();
+    for (auto &error : errors)
+      if (error) std::rethrow_exception(error);
+
+    // spread each strip's time evenly over its rows, and blend with
+    // what earlier frames measured, so a single hiccup doesn't throw
+    // off the next frame's balance
+    bool firstFrame = rowCost.empty();
+    if (firstFrame) rowCost.resize(height);
+    for (auto &worker : workers) {
+      uint32_t numRows = worker.rowEnd-worker.rowBegin;
+      if (numRows == 0) continue;
+      double perRow = std::max(worker.renderTime/numRows,1e-9);
+      for (uint32_t row=worker.rowBegin;row<worker.rowEnd;row++)
+        rowCost[row] = firstFrame ? perRow : 0.5*rowCost[row] + 0.5*perRow;
+    }
+  }
+  
+}
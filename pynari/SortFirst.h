@@ -0,0 +1,69 @@
+// ======================================================================== //
+// Copyright 2024++ Ingo Wald                                               //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include "pynari/Clone.h"
+
+namespace pynari {
+
+  struct Frame;
+  
+  /*! renders a frame on all of its context's devices at once: each
+      device renders one horizontal strip of the image (through its
+      own copy of the frame and camera, with the camera's
+      'imageRegion' restricted to that strip), all devices render in
+      parallel, and the strips get composited into a single image.
+      Strip boundaries get re-balanced after every frame, based on
+      how long each row took to render in earlier frames */
+  struct SortFirst {
+    SortFirst(Frame *frame);
+
+    /*! bring all devices' copies of the scene up to date, render,
+        and composite into 'composite'. Must be called with the GIL
+        released */
+    void render();
+
+    Frame *const frame;
+    /*! held while rendering, and while reading 'composite' */
+    std::mutex   mutex;
+    
+    /*! the composited color channel */
+    std::vector<uint8_t> composite;
+    uint32_t             width  = 0;
+    uint32_t             height = 0;
+    anari::DataType      pixelType = ANARI_UNKNOWN;
+    
+  private:
+    struct Worker {
+      /*! null for the frame's own device */
+      std::shared_ptr<Context> context;
+      std::unique_ptr<Cloner>  cloner;
+      uint32_t rowBegin = 0, rowEnd = 0;
+      /*! render time of this worker's last strip, in seconds */
+      double   renderTime = 0.;
+    };
+    /*! (re-)computes each worker's rows such that all workers'
+        strips have about the same estimated cost */
+    void assignRows();
+    
+    std::vector<Worker> workers;
+    /*! estimated render time of each row, from earlier frames; empty
+        until the first frame (of the current size) got rendered */
+    std::vector<double> rowCost;
+  };
+  
+}
@@ -30,6 +30,7 @@ namespace pynari {
     { return "pynari::SpatialField<"+type+">"; }
     
     ANARIDataType anariType() const override { return ANARI_SPATIAL_FIELD; }
+    std::string subtype() const override { return type; }
     
     const std::string type;
   };
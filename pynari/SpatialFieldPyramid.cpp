@@ -0,0 +1,255 @@
+// ======================================================================== //
+// Copyright 2024++ Ingo Wald                                               //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+#include "pynari/SpatialFieldPyramid.h"
+#include "pynari/Context.h"
+#include "pynari/Array.h"
+#include "pynari/SpatialField.h"
+#include "pynari/Volume.h"
+#include "pynari/Camera.h"
+#include "pynari/parallel.h"
+
+namespace pynari {
+
+  typedef py::array_t<float,py::array::c_style|py::array::forcecast>
+  FloatArray;
+
+  SpatialFieldPyramid::Filter
+  parseFieldPyramidFilter(const std::string &filter)
+  {
+    if (filter == "average") return SpatialFieldPyramid::AVERAGE;
+    if (filter == "min")     return SpatialFieldPyramid::MIN;
+    if (filter == "max")     return SpatialFieldPyramid::MAX;
+    if (filter == "minmax")  return SpatialFieldPyramid::MINMAX;
+    throw std::runtime_error("#pynari: unknown pyramid filter '"+filter
+                             +"' (expected 'average', 'min', 'max', or "
+                             "'minmax')");
+  }
+
+  /*! number of voxels along one axis of the next coarser level: the
+      data is vertex-centric, so coarse voxel i sits on fine voxel 2i,
+      and the last coarse voxel on (or right next to) the last fine
+      one */
+  inline uint64_t coarserDim(uint64_t n)
+  { return (n+1)/2; }
+  
+  /*! computes one 2x coarser level of the (nx,ny,nz) 'in' volume:
+      each coarse voxel i gets computed from the 3 fine voxels around
+      2i along each axis (clamped to the volume), either as their
+      tent-filtered (1/4,1/2,1/4) average, their minimum or maximum,
+      or - for MINMAX - whichever of the min and the max is farther
+      away from that average, so small features that stick out in
+      either direction survive the downsampling */
+  static void downsample(const float *in, const uint64_t inDims[3],
+                         float *out, const uint64_t outDims[3],
+                         SpatialFieldPyramid::Filter filter)
+  {
+    const uint64_t nx = inDims[0], ny = inDims[1], nz = inDims[2];
+    const uint64_t mx = outDims[0], my = outDims[1], mz = outDims[2];
+    const float weights[3] = { .25f, .5f, .25f };
+    parallel_for(my*mz,[&](size_t row) {
+      const uint64_t y = row % my, z = row / my;
+      uint64_t fy[3], fz[3];
+      for (int t=0;t<3;t++) {
+        fy[t] = std::min<uint64_t>(std::max<int64_t>(2*(int64_t)y+t-1,0),ny-1);
+        fz[t] = std::min<uint64_t>(std::max<int64_t>(2*(int64_t)z+t-1,0),nz-1);
+      }
+      float *outRow = out + row*mx;
+      for (uint64_t x=0;x<mx;x++) {
+        uint64_t fx[3];
+        for (int t=0;t<3;t++)
+          fx[t] = std::min<uint64_t>(std::max<int64_t>(2*(int64_t)x+t-1,0),nx-1);
+        float sum = 0.f;
+        float lo  = +std::numeric_limits<float>::infinity();
+        float hi  = -std::numeric_limits<float>::infinity();
+        for (int tz=0;tz<3;tz++)
+          for (int ty=0;ty<3;ty++) {
+            const float *inRow = in + (fz[tz]*ny+fy[ty])*nx;
+            const float w = weights[tz]*weights[ty];
+            for (int tx=0;tx<3;tx++) {
+              const float v = inRow[fx[tx]];
+              sum += w*weights[tx]*v;
+              lo = std::min(lo,v);
+              hi = std::max(hi,v);
+            }
+          }
+        float v;
+        switch (filter) {
+        case SpatialFieldPyramid::MIN: v = lo; break;
+        case SpatialFieldPyramid::MAX: v = hi; break;
+        case SpatialFieldPyramid::MINMAX: v = (sum-lo > hi-sum) ? lo : hi; break;
+        default: v = sum;
+        }
+        outRow[x] = v;
+      }
+    },4);
+  }
+  
+  SpatialFieldPyramid::SpatialFieldPyramid(Context *context,
+                                           const float *data,
+                                           const uint64_t dims[3],
+                                           int numLevels,
+                                           Filter filter,
+                                           const math::float3 &origin,
+                                           const math::float3 &spacing)
+  {
+    const uint64_t *fineDims = dims;
+    const float    *fineData = data;
+    std::shared_ptr<std::vector<float>> levelData;
+    for (int level=0;level<std::max(numLevels,1);level++) {
+      uint64_t levelDims[3];
+      math::float3 levelSpacing = spacing;
+      std::shared_ptr<Array> array;
+      if (level == 0) {
+        // the finest level is the app's data itself, which we can't
+        // hold on to, so it gets copied into a managed array
+        for (int d=0;d<3;d++) levelDims[d] = dims[d];
+        array = context->create<Array>(ANARI_FLOAT32,
+                                       std::vector<uint64_t>(dims,dims+3));
+        void *mapped = anariMapArray(context->device->handle,array->handle);
+        ::memcpy(mapped,data,array->dataBytes);
+        anariUnmapArray(context->device->handle,array->handle);
+      } else {
+        if (fineDims[0] == 1 && fineDims[1] == 1 && fineDims[2] == 1)
+          break;
+        for (int d=0;d<3;d++) {
+          levelDims[d] = coarserDim(fineDims[d]);
+          // keep all levels' bounds the same as level 0's
+          levelSpacing[d]
+            = levelDims[d] > 1
+            ? spacing[d]*(dims[d]-1)/float(levelDims[d]-1)
+            : spacing[d]*(1ull<<level);
+        }
+        auto coarseData = std::make_shared<std::vector<float>>
+          (levelDims[0]*levelDims[1]*levelDims[2]);
+        downsample(fineData,fineDims,coarseData->data(),levelDims,filter);
+        levelData = coarseData;
+        array = context->create<Array>(ANARI_FLOAT32,
+                                       std::vector<uint64_t>(levelDims,levelDims+3),
+                                       levelData->data(),levelData);
+      }
+      
+      std::shared_ptr<SpatialField> field
+        = context->create<SpatialField>("structuredRegular");
+      field->setParam("origin",ANARI_FLOAT32_VEC3,&origin);
+      field->setParam("spacing",ANARI_FLOAT32_VEC3,&levelSpacing);
+      field->setParam("data",ANARI_ARRAY3D,&array->handle,array);
+      field->commit();
+      fields.push_back(field);
+
+      fineData = levelData ? levelData->data() : data;
+      fineDims = array->dims;
+    }
+  }
+
+  void SpatialFieldPyramid::bind(const std::shared_ptr<Volume> &volume,
+                                 const std::shared_ptr<Camera> &camera,
+                                 int previewLevel,
+                                 int settleFrames)
+  {
+    if (!volume || !camera)
+      throw std::runtime_error("#pynari: SpatialFieldPyramid.bind() needs "
+                               "a volume and a camera");
+    std::lock_guard<std::mutex> lock(mutex);
+    this->volume       = volume;
+    this->camera       = camera;
+    this->previewLevel
+      = previewLevel < 0
+      ? int(fields.size())-1
+      : std::min(previewLevel,int(fields.size())-1);
+    this->settleFrames = std::max(settleFrames,1);
+    lastCameraParams   = camera->getShadowParams();
+    stillFrames        = this->settleFrames;
+    level              = -1;
+    setLevel(0);
+  }
+  
+  void SpatialFieldPyramid::unbind()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    volume = {};
+    camera = {};
+    level  = -1;
+  }
+
+  int SpatialFieldPyramid::currentLevel()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    return level;
+  }
+
+  void SpatialFieldPyramid::setLevel(int newLevel)
+  {
+    if (newLevel == level) return;
+    level = newLevel;
+    SpatialField::SP field = fields[level];
+    volume->setParam("value",ANARI_SPATIAL_FIELD,&field->handle,field);
+    volume->commit();
+  }
+  
+  void SpatialFieldPyramid::beforeFrame()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!volume) return;
+    
+    std::vector<Param> cameraParams = camera->getShadowParams();
+    bool moved = cameraParams.size() != lastCameraParams.size();
+    for (size_t i=0;!moved && i<cameraParams.size();i++) {
+      const Param &p = cameraParams[i];
+      const Param &q = lastCameraParams[i];
+      moved = p.name != q.name || !q.holds(p.type,p.ptr());
+    }
+    if (moved) {
+      lastCameraParams = std::move(cameraParams);
+      stillFrames = 0;
+    } else
+      stillFrames = std::min(stillFrames+1,settleFrames);
+    setLevel(stillFrames >= settleFrames ? 0 : previewLevel);
+  }
+
+  SpatialFieldPyramid::SP
+  Context::newSpatialFieldPyramid(const py::buffer &_data,
+                                  int levels,
+                                  const std::string &filter,
+                                  const std::tuple<float,float,float> &origin,
+                                  const std::tuple<float,float,float> &spacing)
+  {
+    FloatArray data = FloatArray::ensure(_data);
+    if (!data || data.ndim() != 3)
+      throw std::runtime_error
+        ("#pynari: newSpatialFieldPyramid: 'data' needs to be a 3D array "
+         "of shape (nz,ny,nx)");
+    const uint64_t dims[3] = {
+      (uint64_t)data.shape(2), (uint64_t)data.shape(1), (uint64_t)data.shape(0)
+    };
+    SpatialFieldPyramid::Filter pyramidFilter
+      = parseFieldPyramidFilter(filter);
+    math::float3 fieldOrigin(std::get<0>(origin),
+                             std::get<1>(origin),
+                             std::get<2>(origin));
+    math::float3 fieldSpacing(std::get<0>(spacing),
+                              std::get<1>(spacing),
+                              std::get<2>(spacing));
+    
+    py::gil_scoped_release noGIL;
+    auto pyramid = std::make_shared<SpatialFieldPyramid>
+      (this,data.data(),dims,levels,pyramidFilter,fieldOrigin,fieldSpacing);
+    addFrameHook(pyramid);
+    return pyramid;
+  }
+  
+}
@@ -0,0 +1,91 @@
+// ======================================================================== //
+// Copyright 2024++ Ingo Wald                                               //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+#pragma once
+
+#include "pynari/Context.h"
+
+namespace pynari {
+
+  struct SpatialField;
+  struct Volume;
+  struct Camera;
+  
+  /*! a 'structuredRegular' spatial field at several resolutions:
+      level 0 is the original data, each further level is a 2x
+      downsampled version of the one before it, and each level is its
+      own anari spatial field (all with the same bounds). Once bound
+      to a volume and a camera, every frame rendered on the device
+      first checks whether that camera has changed since the last
+      frame: while it keeps changing, the volume gets the coarse
+      'preview' level, and once the camera has been left alone for
+      'settleFrames' frames it gets switched back to level 0 */
+  struct SpatialFieldPyramid : public FrameHook {
+    typedef std::shared_ptr<SpatialFieldPyramid> SP;
+
+    /*! how 2x2x2 blocks of voxels get reduced to one voxel of the
+        next coarser level */
+    typedef enum { AVERAGE, MIN, MAX, MINMAX } Filter;
+    
+    /*! builds up to 'numLevels' levels (fewer if the data gets down
+        to a single voxel before that) from given (nz,ny,nx) 'data',
+        using given filter; does not need the GIL */
+    SpatialFieldPyramid(Context *context,
+                        const float *data,
+                        const uint64_t dims[3],
+                        int numLevels,
+                        Filter filter,
+                        const math::float3 &origin,
+                        const math::float3 &spacing);
+
+    /*! have the volume's 'value' follow the camera's motion, as
+        described above. previewLevel < 0 means 'coarsest level' */
+    void bind(const std::shared_ptr<Volume> &volume,
+              const std::shared_ptr<Camera> &camera,
+              int previewLevel,
+              int settleFrames);
+    void unbind();
+    
+    /*! picks the level for the frame that's about to get
+        rendered */
+    void beforeFrame() override;
+
+    /*! the level currently set on the bound volume, or -1 */
+    int currentLevel();
+    
+    /*! one field per level, finest first */
+    std::vector<std::shared_ptr<SpatialField>> fields;
+
+  private:
+    void setLevel(int level);
+    
+    std::mutex mutex;
+    std::shared_ptr<Volume> volume;
+    std::shared_ptr<Camera> camera;
+    int previewLevel = 0;
+    int settleFrames = 1;
+    int level = -1;
+    /*! how many frames in a row the camera hasn't changed */
+    int stillFrames = 0;
+    /*! the camera's parameters as of the last frame */
+    std::vector<Param> lastCameraParams;
+  };
+
+  SpatialFieldPyramid::Filter
+  parseFieldPyramidFilter(const std::string &filter);
+  
+}
@@ -0,0 +1,129 @@
+// ======================================================================== //
+// Copyright 2024++ Ingo Wald                                               //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "pynari/SpatialSort.h"
+#include "pynari/parallel.h"
+#include "pynari/morton.h"
+
+namespace pynari {
+
+  py::dict spatialSort(const py::buffer &_positions,
+                       const py::list &_companions)
+  {
+    auto positions
+      = py::array_t<float,py::array::c_style|py::array::forcecast>
+      ::ensure(_positions);
+    if (!positions || positions.size() % 3)
+      throw std::runtime_error
+        ("#pynari: spatialSort: 'positions' need to be an array of float3s");
+    const size_t numPoints = positions.size() / 3;
+    if (numPoints >= (1ull<<32))
+      throw std::runtime_error("#pynari: spatialSort: too many points");
+    const math::float3 *in = (const math::float3 *)positions.data();
+
+    // companions get permuted row by row (as raw bytes), whatever
+    // their type - except for types holding python objects, whose
+    // references a plain copy would duplicate without counting them
+    std::vector<py::array> companions;
+    std::vector<py::array> sortedCompanions;
+    for (auto item : _companions) {
+      py::array array = py::array::ensure(item,py::array::c_style);
+      if (!array || array.ndim() < 1 || (size_t)array.shape(0) != numPoints)
+        throw std::runtime_error
+          ("#pynari: spatialSort: every companion array needs to have "
+           "one row per point");
+      if (array.dtype().kind() == 'O'
+          || array.dtype().attr("hasobject").cast<bool>())
+        throw std::runtime_error
+          ("#pynari: spatialSort: companion arrays of python objects "
+           "(dtype=object) are not supported; permute those with "
+           "the returned 'permutation' instead");
+      companions.push_back(array);
+      sortedCompanions.push_back
+        (py::array(array.dtype(),
+                   std::vector<ssize_t>(array.shape(),
+                                        array.shape()+array.ndim())));
+    }
+    std::vector<const uint8_t *> companionIn;
+    std::vector<uint8_t *>       companionOut;
+    std::vector<size_t>          companionRowBytes;
+    for (size_t c=0;c<companions.size();c++) {
+      companionIn.push_back((const uint8_t *)companions[c].data());
+      companionOut.push_back((uint8_t *)sortedCompanions[c].mutable_data());
+      companionRowBytes.push_back(numPoints ? companions[c].nbytes()/numPoints : 0);
+    }
+
+    py::array_t<float>    sortedPositions(std::vector<ssize_t>{(ssize_t)numPoints,3});
+    py::array_t<uint32_t> permutation((ssize_t)numPoints);
+    math::float3 *outPositions = (math::float3 *)sortedPositions.mutable_data();
+    uint32_t     *outPerm      = permutation.mutable_data();
+    {
+      py::gil_scoped_release noGIL;
+
+      // bounds, per thread block first, then reduced
+      const float inf = std::numeric_limits<float>::infinity();
+      math::float3 lower(+inf,+inf,+inf), upper(-inf,-inf,-inf);
+      std::mutex boundsMutex;
+      parallel_for_blocked
+        (numPoints,64*1024,
+         [&](size_t begin, size_t end) {
+           math::float3 blockLower(+inf,+inf,+inf), blockUpper(-inf,-inf,-inf);
+           for (size_t i=begin;i<end;i++)
+             for (int d=0;d<3;d++) {
+               blockLower[d] = std::min(blockLower[d],in[i][d]);
+               blockUpper[d] = std::max(blockUpper[d],in[i][d]);
+             }
+           std::lock_guard<std::mutex> lock(boundsMutex);
+           for (int d=0;d<3;d++) {
+             lower[d] = std::min(lower[d],blockLower[d]);
+             upper[d] = std::max(upper[d],blockUpper[d]);
+           }
+         });
+
+      std::vector<uint64_t> codes(numPoints);
+      std::vector<uint32_t> order(numPoints);
+      parallel_for(numPoints,
+                   [&](size_t i) {
+                     codes[i] = mortonCode(in[i],lower,upper);
+                     order[i] = (uint32_t)i;
+                   });
+      parallel_radix_sort(codes,order,63);
+
+      parallel_for(numPoints,
+                   [&](size_t i) {
+                     const uint32_t src = order[i];
+                     outPerm[i]      = src;
+                     outPositions[i] = in[src];
+                     for (size_t c=0;c<companionIn.size();c++) {
+                       const size_t rowBytes = companionRowBytes[c];
+                       memcpy(companionOut[c]+i*rowBytes,
+                              companionIn[c]+src*rowBytes,
+                              rowBytes);
+                     }
+                   });
+    }
+
+    py::dict result;
+    result["positions"]   = sortedPositions;
+    py::list companionsOut;
+    for (auto &c : sortedCompanions)
+      companionsOut.append(c);
+    result["companions"]  = companionsOut;
+    result["permutation"] = permutation;
+    return result;
+  }
+
+}
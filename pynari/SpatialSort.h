@@ -0,0 +1,33 @@
+// ======================================================================== //
+// Copyright 2024++ Ingo Wald                                               //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include "pynari/common.h"
+
+namespace pynari {
+
+  /*! reorders given (N,3) float 'positions' along a morton curve
+      (using a parallel radix sort on their morton codes), and
+      applies the same reordering to each of the 'companions' arrays
+      (which can be of any type, but need N rows each - eg, radii,
+      colors, or per-point scalars). Returns a dict with the sorted
+      'positions', the sorted 'companions', and the 'permutation'
+      (for each output element, the input element it came from) */
+  py::dict spatialSort(const py::buffer &positions,
+                       const py::list &companions);
+
+}
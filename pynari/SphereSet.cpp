@@ -0,0 +1,197 @@
+// ======================================================================== //
+// Copyright 2024++ Ingo Wald                                               //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "pynari/Context.h"
+#include "pynari/Array.h"
+#include "pynari/Geometry.h"
+#include "pynari/Material.h"
+#include "pynari/Surface.h"
+
+namespace pynari {
+
+  typedef py::array_t<float,py::array::c_style|py::array::forcecast>
+  FloatArray;
+  typedef py::array_t<int32_t,py::array::c_style|py::array::forcecast>
+  IntArray;
+
+  /*! the spheres (and their attributes) that use the same material */
+  struct SphereGroup {
+    size_t             count = 0;
+    std::vector<float> positions;
+    std::vector<float> radii;
+    std::vector<float> colors;
+  };
+
+  py::list Context::newSphereSet(const py::buffer &_positions,
+                                 const py::object &_radii,
+                                 const py::object &_colors,
+                                 const py::object &_materialIDs,
+                                 const py::list &_materials)
+  {
+    // ------------------------------------------------------------------
+    // decode all inputs while we still hold the GIL
+    // ------------------------------------------------------------------
+    FloatArray positions = FloatArray::ensure(_positions);
+    if (!positions || positions.size() % 3)
+      throw std::runtime_error
+        ("#pynari: newSphereSet: 'positions' needs to be an array of float3s");
+    const ssize_t numSpheres = positions.size() / 3;
+
+    float uniformRadius = 1.f;
+    FloatArray radii;
+    if (py::isinstance<py::float_>(_radii) || py::isinstance<py::int_>(_radii))
+      uniformRadius = _radii.cast<float>();
+    else {
+      radii = FloatArray::ensure(_radii);
+      if (!radii || (radii.size() != 1 && radii.size() != numSpheres))
+        throw std::runtime_error
+          ("#pynari: newSphereSet: 'radii' needs to be either a single "
+           "float, or one float per sphere");
+      if (radii.size() == 1) {
+        uniformRadius = radii.data()[0];
+        radii = FloatArray();
+      }
+    }
+
+    FloatArray colors;
+    int colorDims = 0;
+    if (!_colors.is_none()) {
+      colors = FloatArray::ensure(_colors);
+      if (colors && colors.size() == 3*numSpheres)
+        colorDims = 3;
+      else if (colors && colors.size() == 4*numSpheres)
+        colorDims = 4;
+      else
+        throw std::runtime_error
+          ("#pynari: newSphereSet: 'colors' needs to have one float3 or "
+           "one float4 per sphere");
+    }
+
+    std::vector<Material::SP> materials;
+    for (auto item : _materials)
+      materials.push_back(item.cast<Material::SP>());
+    if (materials.empty()) {
+      // no materials given: use a single matte one, picking up the
+      // per-sphere colors if there are any
+      Material::SP matte = create<Material>("matte");
+      if (colorDims)
+        matte->setParam("color",ANARI_STRING,"color");
+      matte->commit();
+      materials.push_back(matte);
+    }
+    const int numMaterials = (int)materials.size();
+
+    IntArray materialIDs;
+    if (!_materialIDs.is_none()) {
+      materialIDs = IntArray::ensure(_materialIDs);
+      if (!materialIDs || materialIDs.size() != numSpheres)
+        throw std::runtime_error
+          ("#pynari: newSphereSet: 'material_ids' needs to have exactly "
+           "one int per sphere");
+    }
+
+    const float   *in_positions = positions.data();
+    const float   *in_radii     = radii ? radii.data() : nullptr;
+    const float   *in_colors    = colors ? colors.data() : nullptr;
+    const int32_t *in_matIDs    = materialIDs ? materialIDs.data() : nullptr;
+
+    std::vector<Surface::SP> surfaces;
+    {
+      // nothing below touches any python objects
+      py::gil_scoped_release noGIL;
+
+      // ------------------------------------------------------------------
+      // bin spheres by material: count, then allocate, then scatter
+      // ------------------------------------------------------------------
+      std::vector<SphereGroup> groups(numMaterials);
+      for (ssize_t i=0;i<numSpheres;i++) {
+        int matID = in_matIDs ? in_matIDs[i] : 0;
+        if (matID < 0 || matID >= numMaterials)
+          throw std::runtime_error
+            ("#pynari: newSphereSet: invalid material ID "
+             +std::to_string(matID)+" for sphere #"+std::to_string(i));
+        groups[matID].count++;
+      }
+      for (auto &group : groups) {
+        group.positions.reserve(3*group.count);
+        if (in_radii)
+          group.radii.reserve(group.count);
+        if (in_colors)
+          group.colors.reserve(colorDims*group.count);
+      }
+      for (ssize_t i=0;i<numSpheres;i++) {
+        SphereGroup &group = groups[in_matIDs ? in_matIDs[i] : 0];
+        group.positions.insert(group.positions.end(),
+                               in_positions+3*i,in_positions+3*i+3);
+        if (in_radii)
+          group.radii.push_back(in_radii[i]);
+        if (in_colors)
+          group.colors.insert(group.colors.end(),
+                              in_colors+colorDims*i,
+                              in_colors+colorDims*(i+1));
+      }
+
+      // ------------------------------------------------------------------
+      // and create one sphere geometry (and surface) per used material
+      // ------------------------------------------------------------------
+      for (int matID=0;matID<numMaterials;matID++) {
+        SphereGroup &group = groups[matID];
+        if (group.count == 0) continue;
+
+        Geometry::SP geom = create<Geometry>("sphere");
+        Array::SP positionArray
+          = create<Array>(ANARI_FLOAT32_VEC3,
+                          (const void*)group.positions.data(),
+                          group.count);
+        geom->setParam("vertex.position",ANARI_ARRAY1D,&positionArray->handle,
+                       positionArray);
+        if (in_radii) {
+          Array::SP radiusArray
+            = create<Array>(ANARI_FLOAT32,
+                            (const void*)group.radii.data(),
+                            group.count);
+          geom->setParam("vertex.radius",ANARI_ARRAY1D,&radiusArray->handle,
+                         radiusArray);
+        } else
+          geom->setParam("radius",uniformRadius);
+        if (in_colors) {
+          Array::SP colorArray
+            = create<Array>(colorDims == 3
+                            ? ANARI_FLOAT32_VEC3
+                            : ANARI_FLOAT32_VEC4,
+                            (const void*)group.colors.data(),
+                            group.count);
+          geom->setParam("vertex.color",ANARI_ARRAY1D,&colorArray->handle,
+                         colorArray);
+        }
+        geom->commit();
+
+        Surface::SP surface = create<Surface>();
+        surface->setParam("geometry",ANARI_GEOMETRY,&geom->handle,geom);
+        surface->setParam("material",ANARI_MATERIAL,
+                          &materials[matID]->handle,materials[matID]);
+        surface->commit();
+        surfaces.push_back(surface);
+      }
+    }
+
+    py::list result;
+    for (auto surface : surfaces)
+      result.append(surface);
+    return result;
+  }
+
+}
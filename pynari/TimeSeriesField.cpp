@@ -0,0 +1,342 @@
+// ======================================================================== //
+// Copyright 2024++ Ingo Wald                                               //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+#include "pynari/TimeSeriesField.h"
+#include "pynari/Array.h"
+#include "pynari/SpatialField.h"
+#include "pynari/MappedFile.h"
+#include "pynari/parallel.h"
+#include <chrono>
+#include <cstring>
+
+namespace pynari {
+
+  /*! checks that 'pattern' has exactly one printf conversion, and
+      that that's a (possibly zero-padded) integer one, so it's safe
+      to hand to snprintf with a single int */
+  static void checkFilePattern(const std::string &pattern)
+  {
+    int numConversions = 0;
+    for (size_t i=0;i<pattern.size();i++) {
+      if (pattern[i] != '%') continue;
+      if (i+1 < pattern.size() && pattern[i+1] == '%') { ++i; continue; }
+      size_t j = i+1;
+      while (j < pattern.size() && isdigit(pattern[j])) ++j;
+      if (j == pattern.size() || pattern[j] != 'd')
+        throw std::runtime_error("#pynari: newTimeSeriesField: file name "
+                                 "pattern may only contain '%d'-style "
+                                 "conversions");
+      ++numConversions;
+      i = j;
+    }
+    if (numConversions != 1)
+      throw std::runtime_error("#pynari: newTimeSeriesField: file name "
+                               "pattern needs exactly one '%d'");
+  }
+  
+  TimeSeriesField::TimeSeriesField(Context *context,
+                                   const py::object &source,
+                                   int numSteps,
+                                   const std::tuple<uint64_t,uint64_t,uint64_t> &_dims,
+                                   const std::string &dtype,
+                                   int prefetch,
+                                   uint64_t memoryBudget,
+                                   const math::float3 &origin,
+                                   const math::float3 &spacing)
+    : numSteps(numSteps),
+      context(context),
+      prefetch(std::max(prefetch,0)),
+      memoryBudget(memoryBudget)
+  {
+    if (py::isinstance<py::str>(source)) {
+      pattern = source.cast<std::string>();
+      checkFilePattern(pattern);
+    } else if (py::isinstance<py::list>(source) || py::isinstance<py::tuple>(source)) {
+      fileNames = source.cast<std::vector<std::string>>();
+      this->numSteps = (int)fileNames.size();
+    } else if (PyCallable_Check(source.ptr()))
+      callback = source;
+    else
+      throw std::runtime_error("#pynari: newTimeSeriesField: 'source' needs "
+                               "to be a file name pattern, a list of file "
+                               "names, or a callable");
+    if (this->numSteps <= 0)
+      throw std::runtime_error("#pynari: newTimeSeriesField: need at least "
+                               "one time step");
+
+    dims[0] = std::get<0>(_dims);
+    dims[1] = std::get<1>(_dims);
+    dims[2] = std::get<2>(_dims);
+    if (dtype == "float32" || dtype == "f4") {
+      sourceElemSize = 4; arrayType = ANARI_FLOAT32;
+    } else if (dtype == "float64" || dtype == "f8") {
+      // stored as float32
+      sourceElemSize = 8; arrayType = ANARI_FLOAT32;
+    } else if (dtype == "uint8" || dtype == "u1") {
+      sourceElemSize = 1; arrayType = ANARI_UFIXED8;
+    } else if (dtype == "uint16" || dtype == "u2") {
+      sourceElemSize = 2; arrayType = ANARI_UFIXED16;
+    } else
+      throw std::runtime_error("#pynari: newTimeSeriesField: unsupported "
+                               "dtype '"+dtype+"'");
+    sourceType = dtype;
+    stepBytes = dims[0]*dims[1]*dims[2]*sizeOfType(arrayType);
+
+    field = context->create<SpatialField>("structuredRegular");
+    field->setParam("origin",ANARI_FLOAT32_VEC3,&origin);
+    field->setParam("spacing",ANARI_FLOAT32_VEC3,&spacing);
+    
+    thread = std::thread([this](){ loaderThread(); });
+  }
+
+  TimeSeriesField::~TimeSeriesField()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      quit = true;
+    }
+    cv.notify_all();
+    if (thread.joinable()) {
+      // the loader may be waiting for the GIL to call 'callback'
+      if (PyGILState_Check()) {
+        py::gil_scoped_release noGIL;
+        thread.join();
+      } else
+        thread.join();
+    }
+    if (callback) {
+      py::gil_scoped_acquire gil;
+      callback = py::object();
+    }
+  }
+
+  std::vector<int> TimeSeriesField::window()
+  {
+    int count = std::min(prefetch+1,numSteps);
+    if (memoryBudget)
+      // one step's worth goes to the step that's still being shown
+      count = std::min<int64_t>(count,std::max<int64_t>(1,memoryBudget/stepBytes-1));
+    std::vector<int> steps;
+    for (int i=0;i<count;i++)
+      steps.push_back((requested+i) % numSteps);
+    return steps;
+  }
+  
+  std::shared_ptr<Array> TimeSeriesField::load(int step)
+  {
+    const uint64_t numVoxels = dims[0]*dims[1]*dims[2];
+    const std::vector<uint64_t> arrayDims(dims,dims+3);
+    auto copyStep = [&](const void *in, void *out) {
+      if (sourceElemSize == 8)
+        parallel_for(numVoxels,[&](size_t i)
+                     { ((float *)out)[i] = (float)((const double *)in)[i]; },
+                     64*1024);
+      else
+        memcpy(out,in,numVoxels*sourceElemSize);
+    };
+    
+    if (callback) {
+      py::gil_scoped_acquire gil;
+      py::object result = callback(step);
+      py::buffer_info info = py::cast<py::buffer>(result).request();
+      bool contiguous = true;
+      for (ssize_t d=info.ndim-1, stride=info.itemsize;d>=0;d--) {
+        contiguous &= (info.shape[d] == 1 || info.strides[d] == stride);
+        stride *= info.shape[d];
+      }
+      if ((uint64_t)info.size != numVoxels
+          || (size_t)info.itemsize != sourceElemSize
+          || !contiguous)
+        throw std::runtime_error("#pynari: time series callback for step "
+                                 +std::to_string(step)+" did not return a "
+                                 "contiguous array of "
+                                 +std::to_string(numVoxels)+" "+sourceType
+                                 +" values");
+      py::gil_scoped_release noGIL;
+      Array::SP array = context->create<Array>(arrayType,arrayDims);
+      void *mapped = anariMapArray(context->device->handle,array->handle);
+      copyStep(info.ptr,mapped);
+      anariUnmapArray(context->device->handle,array->handle);
+      return array;
+    }
+
+    std::string fileName;
+    if (!pattern.empty()) {
+      std::vector<char> buffer(pattern.size()+32);
+      snprintf(buffer.data(),buffer.size(),pattern.c_str(),step);
+      fileName = buffer.data();
+    } else
+      fileName = fileNames[step];
+    MappedFile::SP file = MappedFile::open(fileName);
+    if (file->size < numVoxels*sourceElemSize)
+      throw std::runtime_error("#pynari: time step file '"+fileName
+                               +"' is too small for the given dims and "
+                               "dtype");
+    if (sourceElemSize == sizeOfType(arrayType)) {
+      // share the mapping, but fault it in now, on this thread,
+      // rather than while rendering
+      volatile uint8_t sum = 0;
+      for (size_t i=0;i<numVoxels*sourceElemSize;i+=4096)
+        sum += file->data[i];
+      (void)sum;
+      return context->create<Array>(arrayType,arrayDims,
+                                    (const void *)file->data,file);
+    }
+    Array::SP array = context->create<Array>(arrayType,arrayDims);
+    void *mapped = anariMapArray(context->device->handle,array->handle);
+    copyStep(file->data,mapped);
+    anariUnmapArray(context->device->handle,array->handle);
+    return array;
+  }
+  
+  void TimeSeriesField::loaderThread()
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!quit) {
+      std::vector<int> wanted = window();
+      auto isWanted = [&](int step)
+      { return std::find(wanted.begin(),wanted.end(),step) != wanted.end(); };
+      for (auto it = resident.begin(); it != resident.end(); )
+        if (!isWanted(it->first) && it->first != shown) {
+          it = resident.erase(it);
+          stats.evictions++;
+        } else
+          ++it;
+      for (auto it = errors.begin(); it != errors.end(); )
+        it = isWanted(it->first) ? std::next(it) : errors.erase(it);
+
+      int next = -1;
+      for (int step : wanted)
+        if (!resident.count(step) && !errors.count(step)) { next = step; break; }
+      if (next < 0) {
+        cv.wait(lock);
+        continue;
+      }
+
+      lock.unlock();
+      Array::SP array;
+      std::string error;
+      try {
+        array = load(next);
+      } catch (const std::exception &e) {
+        error = e.what();
+      }
+      lock.lock();
+      if (array) {
+        resident[next] = array;
+        stats.loads++;
+      } else
+        errors[next] = error;
+      cv.notify_all();
+    }
+  }
+
+  void TimeSeriesField::setTime(int step)
+  {
+    if (step < 0 || step >= numSteps)
+      throw std::runtime_error("#pynari: TimeSeriesField.setTime: step "
+                               +std::to_string(step)+" out of range");
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      requested = step;
+    }
+    cv.notify_all();
+  }
+
+  int TimeSeriesField::currentTime()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    return shown;
+  }
+  
+  void TimeSeriesField::beforeFrame()
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    const int step = requested;
+    if (step == shown) return;
+    if (!resident.count(step) && !errors.count(step)) {
+      // the very first step doesn't count; nothing could've been
+      // prefetched for that
+      const bool stall = shown >= 0;
+      auto begin = std::chrono::steady_clock::now();
+      cv.wait(lock,[&]() { return resident.count(step) || errors.count(step); });
+      if (stall) {
+        stats.stalls++;
+        stats.stallSeconds
+          += std::chrono::duration<double>(std::chrono::steady_clock::now()-begin).count();
+      }
+    }
+    if (errors.count(step)) {
+      std::string error = errors[step];
+      // so the loader tries again next time
+      errors.erase(step);
+      cv.notify_all();
+      throw std::runtime_error(error);
+    }
+    Array::SP array = resident[step];
+    shown = step;
+    lock.unlock();
+    
+    field->setParam("data",ANARI_ARRAY3D,&array->handle,array);
+    field->commit();
+    // the previously shown step may be evictable now
+    cv.notify_all();
+  }
+
+  py::dict TimeSeriesField::getStats()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    py::dict result;
+    result["loads"]         = stats.loads;
+    result["stalls"]        = stats.stalls;
+    result["stallSeconds"]  = stats.stallSeconds;
+    result["evictions"]     = stats.evictions;
+    result["residentSteps"] = resident.size();
+    result["residentBytes"] = resident.size()*stepBytes;
+    return result;
+  }
+  
+  TimeSeriesField::SP
+  Context::newTimeSeriesField(const py::object &source,
+                              const std::tuple<uint64_t,uint64_t,uint64_t> &dims,
+                              const std::string &dtype,
+                              int numSteps,
+                              int prefetch,
+                              uint64_t memoryBudget,
+                              const std::tuple<float,float,float> &origin,
+                              const std::tuple<float,float,float> &spacing)
+  {
+    math::float3 fieldOrigin(std::get<0>(origin),
+                             std::get<1>(origin),
+                             std::get<2>(origin));
+    math::float3 fieldSpacing(std::get<0>(spacing),
+                              std::get<1>(spacing),
+                              std::get<2>(spacing));
+    auto series = std::make_shared<TimeSeriesField>
+      (this,source,numSteps,dims,dtype,prefetch,memoryBudget,
+       fieldOrigin,fieldSpacing);
+    {
+      // have the field show step 0 right away, so it's complete
+      // before it gets used anywhere
+      py::gil_scoped_release noGIL;
+      series->beforeFrame();
+    }
+    addFrameHook(series);
+    return series;
+  }
+  
+}
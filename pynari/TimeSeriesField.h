@@ -0,0 +1,117 @@
+// ======================================================================== //
+// Copyright 2024++ Ingo Wald                                               //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+#pragma once
+
+#include "pynari/Context.h"
+#include <condition_variable>
+#include <map>
+#include <thread>
+
+namespace pynari {
+
+  struct Array;
+  struct SpatialField;
+  
+  /*! a 'structuredRegular' field whose data plays back a series of
+      time steps: a background thread loads (or memory-maps) the
+      steps following the current one into anari arrays while the
+      current one renders, and setTime() only takes effect at the
+      start of the next frame rendered on this device, when the
+      field's data gets switched to that step's array. If that step
+      isn't loaded yet by then, the frame waits for it, which gets
+      counted as a 'stall' */
+  struct TimeSeriesField : public FrameHook {
+    typedef std::shared_ptr<TimeSeriesField> SP;
+
+    /*! 'source' is either a printf-style file name pattern with one
+        integer conversion (eg, "step_%04d.raw"), a list of file
+        names, or a python callable that returns step t's data as a
+        buffer. Files are raw (nx,ny,nz) arrays of 'dtype'
+        ('float32', 'float64', 'uint8', or 'uint16'). Prefetches up
+        to 'prefetch' steps ahead (wrapping around at the end), and
+        - if 'memoryBudget' is non-zero - never holds more than that
+        many bytes of steps */
+    TimeSeriesField(Context *context,
+                    const py::object &source,
+                    int numSteps,
+                    const std::tuple<uint64_t,uint64_t,uint64_t> &dims,
+                    const std::string &dtype,
+                    int prefetch,
+                    uint64_t memoryBudget,
+                    const math::float3 &origin,
+                    const math::float3 &spacing);
+    virtual ~TimeSeriesField();
+
+    /*! have the next frame show given step */
+    void setTime(int step);
+    /*! the step that's currently in the field */
+    int currentTime();
+    /*! 'loads', 'stalls', 'stallSeconds', 'evictions',
+        'residentSteps', 'residentBytes' */
+    py::dict getStats();
+    
+    /*! switches the field to the requested step, waiting for it if
+        necessary */
+    void beforeFrame() override;
+    
+    /*! the field to put into a volume */
+    std::shared_ptr<SpatialField> field;
+    int numSteps = 0;
+    
+  private:
+    /*! loads given step into an array; called on the loader
+        thread, without holding the mutex */
+    std::shared_ptr<Array> load(int step);
+    void loaderThread();
+    /*! the steps that should be resident right now, in the order
+        they'll be needed */
+    std::vector<int> window();
+    
+    Context *const context;
+    uint64_t dims[3];
+    /*! element type of the source data, and of the arrays */
+    std::string sourceType;
+    anari::DataType arrayType;
+    size_t sourceElemSize;
+    uint64_t stepBytes;
+    std::string pattern;
+    std::vector<std::string> fileNames;
+    py::object callback;
+    int prefetch;
+    uint64_t memoryBudget;
+    
+    std::mutex mutex;
+    /*! signaled whenever the requested step changes, a step got
+        loaded, or the loader should quit */
+    std::condition_variable cv;
+    std::map<int,std::shared_ptr<Array>> resident;
+    std::map<int,std::string> errors;
+    int requested = 0;
+    int shown = -1;
+    bool quit = false;
+    std::thread thread;
+
+    struct {
+      uint64_t loads = 0;
+      uint64_t stalls = 0;
+      double   stallSeconds = 0.;
+      uint64_t evictions = 0;
+    } stats;
+  };
+
+}
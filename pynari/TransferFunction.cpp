@@ -0,0 +1,187 @@
+// ======================================================================== //
+// Copyright 2024++ Ingo Wald                                               //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+#include "pynari/TransferFunction.h"
+#include <cmath>
+#include <cstring>
+
+namespace pynari {
+
+  /*! built-in color maps, as evenly spaced colors */
+  static const std::map<std::string,std::vector<math::float3>> &builtinColorMaps()
+  {
+    static const std::map<std::string,std::vector<math::float3>> maps = {
+      { "grayscale", { {0.f,0.f,0.f}, {1.f,1.f,1.f} } },
+      { "coolwarm",  { {0.2298f,0.2987f,0.7537f},
+                       {0.8654f,0.8654f,0.8654f},
+                       {0.7057f,0.0156f,0.1502f} } },
+      { "viridis",   { {0.2670f,0.0049f,0.3294f},
+                       {0.2826f,0.1409f,0.4575f},
+                       {0.2297f,0.3224f,0.5457f},
+                       {0.1727f,0.4488f,0.5579f},
+                       {0.1276f,0.5669f,0.5506f},
+                       {0.1579f,0.6838f,0.5017f},
+                       {0.3692f,0.7889f,0.3829f},
+                       {0.6785f,0.8637f,0.1895f},
+                       {0.9932f,0.9062f,0.1439f} } },
+      { "jet",       { {0.f,0.f,.5f}, {0.f,0.f,1.f}, {0.f,.5f,1.f},
+                       {0.f,1.f,1.f}, {.5f,1.f,.5f}, {1.f,1.f,0.f},
+                       {1.f,.5f,0.f}, {1.f,0.f,0.f}, {.5f,0.f,0.f} } },
+    };
+    return maps;
+  }
+
+  /*! piecewise-linear interpolation of (x-sorted) control points,
+      clamped to the first/last point's value outside their range;
+      'cursor' carries the current segment from one (increasing) x to
+      the next, so evaluating a whole table is a single sweep */
+  template<typename Point, typename GetX, typename GetValue>
+  inline float interpolate(const std::vector<Point> &points, float x,
+                           size_t &cursor, GetX getX, GetValue getValue)
+  {
+    const size_t n = points.size();
+    if (x <= getX(points[0]))
+      return getValue(points[0]);
+    while (cursor+1 < n && getX(points[cursor+1]) < x)
+      ++cursor;
+    if (cursor+1 == n)
+      return getValue(points[n-1]);
+    const float x0 = getX(points[cursor]), x1 = getX(points[cursor+1]);
+    const float t = x1 > x0 ? (x-x0)/(x1-x0) : 1.f;
+    return getValue(points[cursor])
+      + t*(getValue(points[cursor+1])-getValue(points[cursor]));
+  }
+  
+  TransferFunction::TransferFunction(Device::SP device, int resolution)
+    : Array(device,ANARI_FLOAT32_VEC4,
+            std::vector<uint64_t>{ (uint64_t)std::max(resolution,2) }),
+      table(std::max(resolution,2))
+  {
+    colorPoints   = { { 0.f, { 0.f, 0.f, 0.f } }, { 1.f, { 1.f, 1.f, 1.f } } };
+    opacityPoints = { { 0.f, 0.f }, { 1.f, 1.f } };
+    std::lock_guard<std::mutex> lock(mutex);
+    evaluate();
+  }
+  
+  void TransferFunction::setColorMap(const py::object &colors)
+  {
+    std::vector<ColorPoint> points;
+    if (py::isinstance<py::str>(colors)) {
+      const std::string name = colors.cast<std::string>();
+      auto it = builtinColorMaps().find(name);
+      if (it == builtinColorMaps().end())
+        throw std::runtime_error("#pynari: unknown color map '"+name+"'");
+      for (size_t i=0;i<it->second.size();i++) {
+        const math::float3 &c = it->second[i];
+        points.push_back({ i/float(it->second.size()-1), { c.x, c.y, c.z } });
+      }
+    } else {
+      auto rows = colors.cast<std::vector<std::vector<float>>>();
+      for (size_t i=0;i<rows.size();i++) {
+        const auto &row = rows[i];
+        if (row.size() == 3)
+          points.push_back({ rows.size() > 1 ? i/float(rows.size()-1) : 0.f,
+                             { row[0], row[1], row[2] } });
+        else if (row.size() == 4)
+          points.push_back({ row[0], { row[1], row[2], row[3] } });
+        else
+          throw std::runtime_error
+            ("#pynari: TransferFunction.setColorMap: colors need to be "
+             "either (r,g,b) or (x,r,g,b)");
+      }
+      std::stable_sort(points.begin(),points.end(),
+                       [](const ColorPoint &a, const ColorPoint &b)
+                       { return a.x < b.x; });
+    }
+    if (points.empty())
+      throw std::runtime_error("#pynari: TransferFunction.setColorMap: "
+                               "empty color map");
+    std::lock_guard<std::mutex> lock(mutex);
+    colorPoints = std::move(points);
+    evaluate();
+  }
+  
+  void TransferFunction::setOpacityPoints(const py::object &_points)
+  {
+    std::vector<math::float2> points;
+    for (auto &row : _points.cast<std::vector<std::vector<float>>>()) {
+      if (row.size() != 2)
+        throw std::runtime_error
+          ("#pynari: TransferFunction.setOpacityPoints: points need to "
+           "be (x,opacity) pairs");
+      points.push_back({ row[0], row[1] });
+    }
+    if (points.empty())
+      throw std::runtime_error("#pynari: TransferFunction.setOpacityPoints: "
+                               "need at least one point");
+    std::stable_sort(points.begin(),points.end(),
+                     [](const math::float2 &a, const math::float2 &b)
+                     { return a.x < b.x; });
+    std::lock_guard<std::mutex> lock(mutex);
+    opacityPoints = std::move(points);
+    evaluate();
+  }
+
+  void TransferFunction::setUnitDistance(float unitDistance)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (unitDistance == this->unitDistance) return;
+    this->unitDistance = unitDistance;
+    evaluate();
+  }
+
+  py::list TransferFunction::getTable()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    py::list result;
+    for (auto &e : table)
+      result.append(py::make_tuple(e.x,e.y,e.z,e.w));
+    return result;
+  }
+  
+  void TransferFunction::evaluate()
+  {
+    assertThisObjectIsValid();
+    const size_t N = table.size();
+    const float exponent = unitDistance > 0.f ? 1.f/unitDistance : 1.f;
+    size_t colorCursor[3] = { 0, 0, 0 }, opacityCursor = 0;
+    for (size_t i=0;i<N;i++) {
+      const float x = i/float(N-1);
+      float color[3];
+      for (int c=0;c<3;c++)
+        color[c]
+          = interpolate(colorPoints,x,colorCursor[c],
+                        [](const ColorPoint &p) { return p.x; },
+                        [c](const ColorPoint &p) { return p.rgb[c]; });
+      float opacity
+        = interpolate(opacityPoints,x,opacityCursor,
+                      [](const math::float2 &p) { return p.x; },
+                      [](const math::float2 &p) { return p.y; });
+      opacity = std::min(std::max(opacity,0.f),1.f);
+      if (exponent != 1.f && opacity < 1.f)
+        opacity = 1.f-powf(1.f-opacity,exponent);
+      for (int c=0;c<3;c++)
+        color[c] = std::min(std::max(color[c],0.f),1.f);
+      table[i] = math::float4(color[0],color[1],color[2],opacity);
+    }
+    void *mapped = anariMapArray(device->handle,handle);
+    memcpy(mapped,table.data(),N*sizeof(math::float4));
+    anariUnmapArray(device->handle,handle);
+    ++dataVersion;
+  }
+  
+}
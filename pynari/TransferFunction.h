@@ -0,0 +1,64 @@
+// ======================================================================== //
+// Copyright 2024++ Ingo Wald                                               //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+#pragma once
+
+#include "pynari/Array.h"
+
+namespace pynari {
+
+  /*! a transferFunction1D volume's 'color' array that computes its
+      own contents: a FLOAT32_VEC4 array of 'resolution' entries,
+      evaluated (natively) from a color map and piecewise-linear
+      opacity control points. Every change re-evaluates the table and
+      writes it into this same array in place, so interactive edits
+      neither allocate nor need the volume's parameters to change */
+  struct TransferFunction : public Array {
+    typedef std::shared_ptr<TransferFunction> SP;
+
+    TransferFunction(Device::SP device, int resolution);
+    
+    std::string toString() const override { return "pynari::TransferFunction"; }
+
+    /*! either the name of a built-in color map ('grayscale',
+        'coolwarm', 'viridis', or 'jet'), or a list of (r,g,b) colors
+        (evenly spaced over [0,1]), or of (x,r,g,b) control points */
+    void setColorMap(const py::object &colors);
+    /*! a list of (x,opacity) control points, with x in [0,1] */
+    void setOpacityPoints(const py::object &points);
+    /*! if > 0, bakes an opacity correction into the table, such that
+        each control point's opacity gets reached over a distance of
+        'unitDistance' rather than 1 - for devices (or volumes) that
+        use the default unitDistance of 1. 0 turns it off */
+    void setUnitDistance(float unitDistance);
+
+    /*! the current (r,g,b,a) table, one tuple per entry */
+    py::list getTable();
+    
+  private:
+    /*! re-evaluates the table into the (already existing) anari
+        array; caller has to hold the object lock */
+    void evaluate();
+    
+    struct ColorPoint { float x; float rgb[3]; };
+    std::vector<ColorPoint>   colorPoints;
+    std::vector<math::float2> opacityPoints;
+    float unitDistance = 0.f;
+    std::vector<math::float4> table;
+  };
+
+}
@@ -30,6 +30,7 @@ namespace pynari {
     { return "pynari::Volume<"+type+">"; }
     
     ANARIDataType anariType() const override { return ANARI_VOLUME; }
+    std::string subtype() const override { return type; }
 
     const std::string type;
   };
@@ -28,8 +28,17 @@
 #include "pynari/Geometry.h"
 #include "pynari/Group.h"
 #include "pynari/Array.h"
+#include "pynari/TransferFunction.h"
 #include "pynari/SpatialField.h"
 #include "pynari/Volume.h"
+#include "pynari/SpatialFieldPyramid.h"
+#include "pynari/TimeSeriesField.h"
+#include "pynari/Optimize.h"
+#include "pynari/MeshOptimizer.h"
+#include "pynari/SpatialSort.h"
+#include "pynari/HexMesh.h"
+#include "pynari/MarchingCubes.h"
+#include "pynari/ImageCompare.h"
 
 PYBIND11_DECLARE_HOLDER_TYPE(T, std::shared_ptr<T>);
 
@@ -39,7 +48,17 @@ namespace pynari {
   bool has_cuda_capable_gpu();
 }
 
+/* all of pynari's own state is protected by its own locks (see
+   Object::mutex, Device::mutex, ObjectRegistry), so on free-threaded
+   python builds we can tell python it doesn't need to re-enable the
+   GIL for this module. Note the vendored pybind11 (2.12) can neither
+   do that nor build for free-threaded python at all, so for now this
+   only takes effect with an external pybind11 2.13+ */
+#if PYBIND11_VERSION_HEX >= 0x020D0000
+PYBIND11_MODULE(pynari, m, py::mod_gil_not_used()) {
+#else
 PYBIND11_MODULE(pynari, m) {
+#endif
   // optional module docstring
   m.doc() = "barney python wrappers";
 
@@ -48,6 +67,11 @@ PYBIND11_MODULE(pynari, m) {
         "Creates an barney Context object",
         py::arg("libName"),
         py::arg("devName")="default");
+  m.def("newDevice", &createMultiContext,
+        "Creates a context that renders each frame across several "
+        "devices, one for each of the given libraries",
+        py::arg("libNames"),
+        py::arg("devName")="default");
  
   m.attr("DATA_TYPE")     = py::int_((int)ANARI_DATA_TYPE);
   m.attr("STRING")        = py::int_((int)ANARI_STRING);
@@ -112,6 +136,14 @@ PYBIND11_MODULE(pynari, m) {
   m.attr("UINT8_VEC3")   = py::int_((int)ANARI_UINT8_VEC3);
   m.attr("UINT8_VEC4")   = py::int_((int)ANARI_UINT8_VEC4);
 
+  m.attr("UINT16")       = py::int_((int)ANARI_UINT16);
+  m.attr("UINT16_VEC2")  = py::int_((int)ANARI_UINT16_VEC2);
+  m.attr("UINT16_VEC3")  = py::int_((int)ANARI_UINT16_VEC3);
+  m.attr("UINT16_VEC4")  = py::int_((int)ANARI_UINT16_VEC4);
+
+  m.attr("UFIXED8")      = py::int_((int)ANARI_UFIXED8);
+  m.attr("UFIXED16")     = py::int_((int)ANARI_UFIXED16);
+
   m.attr("FLOAT32_BOX1") = py::int_((int)ANARI_FLOAT32_BOX1);
   m.attr("FLOAT32_BOX2") = py::int_((int)ANARI_FLOAT32_BOX2);
   m.attr("FLOAT32_BOX3") = py::int_((int)ANARI_FLOAT32_BOX3);
@@ -140,6 +172,10 @@ PYBIND11_MODULE(pynari, m) {
   object.def("setParameterArray1D",  &pynari::Object::setArray1D_np);
   object.def("setParameterArray2D",  &pynari::Object::setArray2D_np);
   object.def("setParameterArray3D",  &pynari::Object::setArray3D_np);
+  /*! set FROM a numpy array (of a scalar, vector, or matrix type);
+      this has to come before any of the tuple overloads, which
+      would otherwise happily unpack it element by element */
+  object.def("setParameter",  &pynari::Object::set_ndarray);
   /*! set FROM a python float value */
   object.def("setParameter",  &pynari::Object::set_float);
   /*! set FROM a python float tuple */
@@ -158,7 +194,22 @@ PYBIND11_MODULE(pynari, m) {
   object.def("setParameter",  &pynari::Object::set_uint4);
   object.def("setParameter",  &pynari::Object::set_uint_vec);
   
-  object.def("commitParameters", &pynari::Object::commit);
+  object.def("getParameters", &pynari::Object::getParameters,
+             "returns all parameters set on this object, as a dict of "
+             "the form { name : (type, value) }");
+  object.def("cloneTo", &pynari::Object::cloneTo,
+             "re-creates this object, and everything it refers to, on "
+             "the given device, and returns the copy",
+             py::arg("device"));
+  object.def("setParameters", &pynari::Object::setParameters,
+             "sets multiple parameters in a single call. 'params' is "
+             "either a dict of the form { name : (type, value) }, or a "
+             "list of (name, type, value) tuples. If 'commit' is true, "
+             "the object's parameters get committed right after",
+             py::arg("params"),
+             py::arg("commit")=false);
+  object.def("commitParameters", &pynari::Object::commit,
+             py::call_guard<py::gil_scoped_release>());
   object.def("release", &pynari::Object::release);
   // -------------------------------------------------------
   auto camera
@@ -212,49 +263,338 @@ PYBIND11_MODULE(pynari, m) {
   auto frame
     = py::class_<pynari::Frame,pynari::Object,
                  std::shared_ptr<pynari::Frame>>(m, "anari::Frame");
-  frame.def("render", &pynari::Frame::render);
+  frame.def("render", &pynari::Frame::render,
+            py::call_guard<py::gil_scoped_release>());
   frame.def("get", &pynari::Frame::get);
   frame.def("map", &pynari::Frame::map);
   frame.def("unmap", &pynari::Frame::unmap);
   frame.def("readGPU", &pynari::Frame::readGPU);
+  frame.def("setPostProcess", &pynari::Frame::setPostProcess,
+            "post-processes float (FLOAT32_VEC4) color buffers as part "
+            "of get(): scales by 2^exposure, tone maps ('none', "
+            "'reinhard', or 'aces'), gamma-encodes ('srgb', None, or a "
+            "gamma value), and optionally quantizes to 8 bits per "
+            "channel, with or without dithering",
+            py::arg("exposure") = 0.f,
+            py::arg("tonemap") = "aces",
+            py::arg("gamma") = "srgb",
+            py::arg("quantize") = true,
+            py::arg("dither") = true);
+  frame.def("clearPostProcess", &pynari::Frame::clearPostProcess,
+            "turns post-processing back off, so get() returns the raw "
+            "color buffer again");
   
   // -------------------------------------------------------
   auto array
     = py::class_<pynari::Array,pynari::Object,
                  std::shared_ptr<pynari::Array>>(m, "anari::Array");
+  array.def("read",&pynari::Array::read,
+            "returns a copy of the array's contents: a numpy array "
+            "(slowest dimension first, vector components last) for "
+            "data arrays, or a list of objects for object arrays");
+  array.def_property_readonly
+    ("stats",
+     [](const pynari::Array &self) -> py::object {
+       if (!self.stats) return py::none();
+       const pynari::ArrayStats &stats = *self.stats;
+       py::dict result;
+       if (stats.numComponents == 1) {
+         result["min"] = stats.lower[0];
+         result["max"] = stats.upper[0];
+       } else {
+         py::tuple lower(stats.numComponents), upper(stats.numComponents);
+         for (int d=0;d<stats.numComponents;d++) {
+           lower[d] = stats.lower[d];
+           upper[d] = stats.upper[d];
+         }
+         result["min"] = lower;
+         result["max"] = upper;
+         if (stats.numComponents == 3)
+           result["bounds"] = py::make_tuple(lower,upper);
+       }
+       result["count"] = stats.numValid;
+       if (!stats.histogram.empty())
+         result["histogram"] = stats.histogram;
+       return std::move(result);
+     },
+     "statistics over the array's data, if it got created with "
+     "stats=True: 'min' and 'max' (per component for vectors), "
+     "'bounds' ((lower),(upper)) for 3-component vectors, 'count' "
+     "(of values that are not NaN or inf), and, for scalars, a "
+     "'histogram' over [min,max]; None otherwise");
+  // -------------------------------------------------------
+  auto instanceArray
+    = py::class_<pynari::InstanceArray,pynari::Array,
+                 std::shared_ptr<pynari::InstanceArray>>(m, "anari::InstanceArray");
+  instanceArray.def("updateTransforms",
+                    &pynari::InstanceArray::updateTransforms,
+                    py::arg("transforms"),
+                    py::arg("indices") = py::none());
+  instanceArray.def("__len__",
+                    [](const pynari::InstanceArray &self)
+                    { return self.objects.size(); });
+  instanceArray.def("__getitem__",
+                    [](const pynari::InstanceArray &self, size_t i)
+                    {
+                      if (i >= self.objects.size())
+                        throw py::index_error();
+                      return self.objects[i];
+                    });
+  // -------------------------------------------------------
+  auto transferFunction
+    = py::class_<pynari::TransferFunction,pynari::Array,
+                 std::shared_ptr<pynari::TransferFunction>>(m, "TransferFunction");
+  transferFunction.def(py::init([](const std::shared_ptr<Context> &device,
+                                   int resolution)
+                                { return device->create<TransferFunction>(resolution); }),
+                       "creates a transfer function table of 'resolution' "
+                       "float4 entries on given device; it can be used "
+                       "directly as a transferFunction1D volume's 'color' "
+                       "array",
+                       py::arg("device"),
+                       py::arg("resolution") = 128);
+  transferFunction.def("setColorMap", &pynari::TransferFunction::setColorMap,
+                       "either a built-in color map's name ('grayscale', "
+                       "'coolwarm', 'viridis', 'jet'), or a list of (r,g,b) "
+                       "or (x,r,g,b) colors",
+                       py::arg("colors"));
+  transferFunction.def("setOpacityPoints",
+                       &pynari::TransferFunction::setOpacityPoints,
+                       "a list of (x,opacity) control points",
+                       py::arg("points"));
+  transferFunction.def("setUnitDistance",
+                       &pynari::TransferFunction::setUnitDistance,
+                       "bakes an opacity correction for given unit "
+                       "distance into the table (0 for none)",
+                       py::arg("unitDistance"));
+  transferFunction.def("getTable", &pynari::TransferFunction::getTable);
+  // -------------------------------------------------------
+  auto pyramid
+    = py::class_<pynari::SpatialFieldPyramid,
+                 std::shared_ptr<pynari::SpatialFieldPyramid>>
+    (m, "anari::SpatialFieldPyramid");
+  pyramid.def("bind", &pynari::SpatialFieldPyramid::bind,
+              "from now on, render given volume with a coarse level of "
+              "this pyramid while given camera keeps changing, and with "
+              "the full-resolution level once it has not changed for "
+              "'settle_frames' frames",
+              py::arg("volume"),
+              py::arg("camera"),
+              py::arg("preview_level") = -1,
+              py::arg("settle_frames") = 1);
+  pyramid.def("unbind", &pynari::SpatialFieldPyramid::unbind);
+  pyramid.def_property_readonly("level",
+                                &pynari::SpatialFieldPyramid::currentLevel);
+  pyramid.def("__len__",
+              [](const pynari::SpatialFieldPyramid &self)
+              { return self.fields.size(); });
+  pyramid.def("__getitem__",
+              [](const pynari::SpatialFieldPyramid &self, size_t i)
+              {
+                if (i >= self.fields.size())
+                  throw py::index_error();
+                return self.fields[i];
+              });
+  // -------------------------------------------------------
+  auto timeSeries
+    = py::class_<pynari::TimeSeriesField,
+                 std::shared_ptr<pynari::TimeSeriesField>>
+    (m, "anari::TimeSeriesField");
+  timeSeries.def("setTime", &pynari::TimeSeriesField::setTime,
+                 "show given time step, starting with the next frame",
+                 py::arg("step"));
+  timeSeries.def_property_readonly("time",
+                                   &pynari::TimeSeriesField::currentTime);
+  timeSeries.def_readonly("field", &pynari::TimeSeriesField::field);
+  timeSeries.def("__len__",
+                 [](const pynari::TimeSeriesField &self)
+                 { return self.numSteps; });
+  timeSeries.def("getStats", &pynari::TimeSeriesField::getStats,
+                 "returns how many steps got loaded ('loads') and "
+                 "evicted ('evictions'), how many frames had to wait for "
+                 "their step ('stalls', 'stallSeconds'), and how many "
+                 "steps are currently loaded ('residentSteps', "
+                 "'residentBytes')");
   // // -------------------------------------------------------
   auto context
     = py::class_<pynari::Context,
                  std::shared_ptr<Context>>(m, "anari::Device");
   context.def("setParameter",  &pynari::Context::set_ulong);
   context.def("commitParameters", &pynari::Context::commit);
+  context.def("transaction", &pynari::Context::transaction,
+              "returns a transaction to be used as 'with "
+              "device.transaction():'; all commitParameters() calls "
+              "within that block get deferred, and get issued - once per "
+              "object, and in dependency order - when the block exits");
+  
+  // -------------------------------------------------------
+  auto transaction
+    = py::class_<pynari::Transaction,
+                 std::shared_ptr<Transaction>>(m, "anari::Transaction");
+  transaction.def("__enter__",
+                  [](pynari::Transaction::SP self)
+                  { self->enter(); return self; });
+  transaction.def("__exit__",
+                  [](pynari::Transaction::SP self, py::args)
+                  { self->exit(); return false; });
   
   
   // // -------------------------------------------------------
 
   m.def("has_cuda_capable_gpu", &pynari::has_cuda_capable_gpu);
+  m.def("optimize", &pynari::optimizeScene,
+        py::arg("world_or_group"));
+
+  m.def("spatialSort", &pynari::spatialSort,
+        py::arg("positions"),
+        py::arg("companions") = py::list());
+
+  auto mesh = m.def_submodule("mesh","native mesh processing helpers");
+  mesh.def("optimize", &pynari::optimizeMesh,
+           py::arg("vertices"),
+           py::arg("indices") = py::none(),
+           py::arg("attributes") = py::list(),
+           py::arg("weld_epsilon") = 0.f);
+
+  auto volumeModule = m.def_submodule("volume","native volume processing helpers");
+  volumeModule.def("gridToHexMesh", &pynari::gridToHexMesh,
+                   "turns a dense (nz,ny,nx) grid into an 'unstructured' "
+                   "spatial field of hexahedra, optionally dropping cells "
+                   "whose values are <= 'mask' (or whose entry in a "
+                   "per-cell 'mask' array is 0)",
+                   py::arg("device"),
+                   py::arg("data"),
+                   py::arg("spacing") = std::make_tuple(1.f,1.f,1.f),
+                   py::arg("origin") = std::make_tuple(0.f,0.f,0.f),
+                   py::arg("cell_centric") = true,
+                   py::arg("mask") = py::none());
+  volumeModule.def("marchingCubes", &pynari::marchingCubes,
+                   "extracts the isosurface(s) of a dense (nz,ny,nx) grid "
+                   "for one or more isovalues as a triangle mesh, and "
+                   "returns its 'vertex.position', 'vertex.normal', and "
+                   "'primitive.index' arrays as a dict for a triangle "
+                   "geometry's setParameters()",
+                   py::arg("device"),
+                   py::arg("data"),
+                   py::arg("isovalues"),
+                   py::arg("spacing") = std::make_tuple(1.f,1.f,1.f),
+                   py::arg("origin") = std::make_tuple(0.f,0.f,0.f));
+
+  auto imageModule = m.def_submodule("image","native image helpers");
+  imageModule.def("compare", &pynari::compareImages,
+                  "compares an image (array or file name) against a "
+                  "reference one, and returns a dict with their 'mse', "
+                  "'psnr', 'ssim', and (FLIP-style) 'flip' error; with "
+                  "error_map=True also the per-pixel flip error "
+                  "('flip_map')",
+                  py::arg("image"),
+                  py::arg("reference"),
+                  py::arg("ppd") = 67.f,
+                  py::arg("error_map") = false);
 
   context.def("newCamera",  &pynari::Context::newCamera);
   context.def("newGroup",   &pynari::Context::newGroup);
   context.def("newInstance",&pynari::Context::newInstance);
+  context.def("newInstances",&pynari::Context::newInstances,
+              py::arg("group"), py::arg("transforms"));
   context.def("newRenderer",&pynari::Context::newRenderer);
   context.def("newSurface", &pynari::Context::newSurface);
   context.def("newSpatialField", &pynari::Context::newSpatialField);
   context.def("newVolume",  &pynari::Context::newVolume);
+  context.def("newSpatialFieldPyramid",
+              &pynari::Context::newSpatialFieldPyramid,
+              "builds a 'structuredRegular' field from given (nz,ny,nx) "
+              "array at 'levels' resolutions, each 2x coarser than the "
+              "one before; 'filter' is one of 'average', 'min', 'max', "
+              "or 'minmax'",
+              py::arg("data"),
+              py::arg("levels") = 3,
+              py::arg("filter") = "average",
+              py::arg("origin") = std::make_tuple(0.f,0.f,0.f),
+              py::arg("spacing") = std::make_tuple(1.f,1.f,1.f));
   context.def("newMaterial",&pynari::Context::newMaterial);
+  context.def("newSphereSet",&pynari::Context::newSphereSet,
+              py::arg("positions"),
+              py::arg("radii"),
+              py::arg("colors") = py::none(),
+              py::arg("material_ids") = py::none(),
+              py::arg("materials") = py::list());
   context.def("newLight",   &pynari::Context::newLight);
   context.def("newWorld",   &pynari::Context::newWorld);
   context.def("newFrame",   &pynari::Context::newFrame);
   context.def("newGeometry",&pynari::Context::newGeometry);
   context.def("newSampler", &pynari::Context::newSampler);
+  context.def("newTimeSeriesField", &pynari::Context::newTimeSeriesField,
+              "creates a 'structuredRegular' field that plays back a "
+              "series of time steps, loaded in the background from "
+              "either raw files (a '%d' file name pattern or a list of "
+              "file names) or a callable(step) returning the step's data",
+              py::arg("source"),
+              py::arg("dims"),
+              py::arg("dtype") = "float32",
+              py::arg("num_steps") = 0,
+              py::arg("prefetch") = 4,
+              py::arg("memory_budget") = 0,
+              py::arg("origin") = std::make_tuple(0.f,0.f,0.f),
+              py::arg("spacing") = std::make_tuple(1.f,1.f,1.f));
   
   context.def("newArray",   &pynari::Context::newArray);
-  context.def("newArray1D", &pynari::Context::newArray1D);
-  context.def("newArray2D", &pynari::Context::newArray2D);
-  context.def("newArray3D", &pynari::Context::newArray3D);
+  context.def("newArray1D", &pynari::Context::newArray1D,
+              py::arg("type"), py::arg("data"),
+              py::arg("stats") = false, py::arg("histogram_bins") = 256);
+  context.def("newArray2D", &pynari::Context::newArray2D,
+              py::arg("type"), py::arg("data"),
+              py::arg("stats") = false, py::arg("histogram_bins") = 256);
+  context.def("newArray3D", &pynari::Context::newArray3D,
+              py::arg("type"), py::arg("data"),
+              py::arg("stats") = false, py::arg("histogram_bins") = 256);
+  context.def("newArray3DQuantized", &pynari::Context::newArray3DQuantized,
+              "quantizes given (nz,ny,nx) array of scalars to 8 or 16 "
+              "bits over given (lo,hi) value range (default: the data's "
+              "own min and max), and returns the resulting UFIXED8 or "
+              "UFIXED16 array together with that range",
+              py::arg("data"),
+              py::arg("bits") = 8,
+              py::arg("range") = py::none());
   context.def("newArray",   &pynari::Context::newArray_objects);
   context.def("newArray1D", &pynari::Context::newArray1D_objects);
+  context.def("loadArrays", &pynari::Context::loadArrays,
+              "loads all arrays in a numpy .npz (or .npy) file, and "
+              "returns them as a dict of pynari arrays",
+              py::arg("fileName"),
+              py::arg("types") = py::dict());
+  context.def("loadNanoVDB", &pynari::Context::loadNanoVDB,
+              "loads a float grid from a (uncompressed) NanoVDB .nvdb "
+              "file as a spatial field: a sparse 'nanovdb' field if the "
+              "device supports those (or 'sparse' is True), else a dense "
+              "'structuredRegular' one",
+              py::arg("fileName"),
+              py::arg("grid") = py::none(),
+              py::arg("sparse") = py::none());
+  context.def("saveScene", &pynari::Context::saveScene,
+              "writes everything reachable from given world (or other "
+              "object) to a binary .pnsc scene file",
+              py::arg("world"), py::arg("fileName"));
+  context.def("loadScene", &pynari::Context::loadScene,
+              "loads a .pnsc scene file written by saveScene, and "
+              "returns its world",
+              py::arg("fileName"));
 
+  context.def("getStats",
+              &pynari::Context::getStats,
+              "returns a dictionary of pynari-side counters: how many "
+              "parameter sets and commits got passed to the device "
+              "('paramsSet', 'commits'), and how many got skipped because "
+              "they would not have changed anything ('paramsElided', "
+              "'commitsElided'), and how many frames got rendered "
+              "('framesRendered') and how long frame.render() took for "
+              "those, in total ('renderMicroseconds')");
+  context.def("getLiveObjectStats",
+              &pynari::Context::getLiveObjectStats,
+              "returns a dictionary that, for each ANARI type that currently "
+              "has any live pynari objects on this device, lists how many "
+              "such objects there are ('count'), and how many bytes of "
+              "array data they hold ('bytes')");
   context.def("getObjectSubtypes",
               &pynari::Context::getObjectSubtypes,
               "returns a list of strings that list all subtypes of the given "
@@ -0,0 +1,54 @@
+// ======================================================================== //
+// Copyright 2024++ Ingo Wald                                               //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include "pynari/common.h"
+#include <algorithm>
+
+namespace pynari {
+
+  /*! spreads the lower 21 bits of 'v' out to every third bit */
+  inline uint64_t mortonSpreadBits(uint64_t v)
+  {
+    v &= 0x1fffff;
+    v = (v | (v << 32)) & 0x1f00000000ffffull;
+    v = (v | (v << 16)) & 0x1f0000ff0000ffull;
+    v = (v | (v <<  8)) & 0x100f00f00f00f00full;
+    v = (v | (v <<  4)) & 0x10c30c30c30c30c3ull;
+    v = (v | (v <<  2)) & 0x1249249249249249ull;
+    return v;
+  }
+
+  /*! 63-bit morton code of given point within given bounds */
+  inline uint64_t mortonCode(const math::float3 &p,
+                             const math::float3 &lower,
+                             const math::float3 &upper)
+  {
+    const float maxCell = float((1<<21)-1);
+    uint64_t cell[3];
+    for (int d=0;d<3;d++) {
+      float extent = upper[d]-lower[d];
+      float rel = extent > 0.f ? (p[d]-lower[d])/extent : 0.f;
+      cell[d] = (uint64_t)std::min(maxCell,std::max(0.f,rel*maxCell));
+    }
+    return
+      (mortonSpreadBits(cell[0]) << 2) |
+      (mortonSpreadBits(cell[1]) << 1) |
+      (mortonSpreadBits(cell[2]) << 0);
+  }
+
+}
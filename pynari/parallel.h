@@ -0,0 +1,231 @@
+// ======================================================================== //
+// Copyright 2024++ Ingo Wald                                               //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include "pynari/common.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace pynari {
+
+  /*! number of threads parallel_for() will use; can be limited by
+      setting PYNARI_NUM_THREADS to a positive number (anything else
+      gets ignored) */
+  inline int numWorkerThreads()
+  {
+    static int cachedValue = [](){
+      int n = (int)std::thread::hardware_concurrency();
+      if (const char *env = getenv("PYNARI_NUM_THREADS")) {
+        char *end = nullptr;
+        errno = 0;
+        long value = strtol(env,&end,10);
+        if (end != env && *end == 0 && errno == 0
+            && value > 0 && value <= INT_MAX)
+          n = (int)value;
+      }
+      return std::max(1,n);
+    }();
+    return cachedValue;
+  }
+
+  /*! calls body(begin,end) for consecutive blocks of (at most)
+      'blockSize' items, covering [0,numItems), using all worker
+      threads. The first exception thrown by any block gets re-thrown
+      on the calling thread once all threads are done. Must not be
+      called with the GIL held if 'body' touches python objects */
+  template<typename Body>
+  void parallel_for_blocked(size_t numItems, size_t blockSize, Body &&body)
+  {
+    if (numItems == 0) return;
+    blockSize = std::max<size_t>(blockSize,1);
+    size_t numBlocks = (numItems+blockSize-1)/blockSize;
+    int numThreads = (int)std::min<size_t>(numWorkerThreads(),numBlocks);
+    if (numThreads <= 1) {
+      for (size_t begin=0;begin<numItems;begin+=blockSize)
+        body(begin,std::min(numItems,begin+blockSize));
+      return;
+    }
+
+    std::atomic<size_t> nextBlock { 0 };
+    std::exception_ptr  error;
+    std::mutex          errorMutex;
+    auto worker = [&]() {
+      while (true) {
+        size_t block = nextBlock++;
+        if (block >= numBlocks) return;
+        size_t begin = block*blockSize;
+        try {
+          body(begin,std::min(numItems,begin+blockSize));
+        } catch (...) {
+          std::lock_guard<std::mutex> lock(errorMutex);
+          if (!error) error = std::current_exception();
+          nextBlock = numBlocks;
+        }
+      }
+    };
+    std::vector<std::thread> threads;
+    for (int i=1;i<numThreads;i++)
+      threads.emplace_back(worker);
+    worker();
+    for (auto &t : threads) t.join();
+    if (error)
+      std::rethrow_exception(error);
+  }
+
+  /*! calls body(i) for all i in [0,numItems), using all worker
+      threads */
+  template<typename Body>
+  void parallel_for(size_t numItems, Body &&body, size_t blockSize = 1024)
+  {
+    parallel_for_blocked(numItems,blockSize,
+                         [&](size_t begin, size_t end) {
+                           for (size_t i=begin;i<end;i++) body(i);
+                         });
+  }
+
+  /*! exclusive prefix sum over count(i) for all i in
+      [0,numItems): writes the sum of all count(j) with j < i to
+      offsets[i] (which has to have numItems elements), and returns
+      the total. count() gets called exactly once per item */
+  template<typename T, typename Count>
+  T parallel_scan(size_t numItems, Count &&count, T *offsets)
+  {
+    const size_t blockSize = 64*1024;
+    const size_t numBlocks = (numItems+blockSize-1)/blockSize;
+    std::vector<T> blockSums(numBlocks+1,T(0));
+    // first, each block's own prefix sum
+    parallel_for_blocked(numItems,blockSize,
+                         [&](size_t begin, size_t end) {
+                           T sum = T(0);
+                           for (size_t i=begin;i<end;i++) {
+                             offsets[i] = sum;
+                             sum += count(i);
+                           }
+                           blockSums[begin/blockSize+1] = sum;
+                         });
+    for (size_t b=0;b<numBlocks;b++)
+      blockSums[b+1] += blockSums[b];
+    // then add the sum of all blocks before it to each block
+    parallel_for_blocked(numItems,blockSize,
+                         [&](size_t begin, size_t end) {
+                           const T base = blockSums[begin/blockSize];
+                           if (base != T(0))
+                             for (size_t i=begin;i<end;i++)
+                               offsets[i] += base;
+                         });
+    return blockSums[numBlocks];
+  }
+  
+  /*! sorts 'items' using all worker threads: sorts one block per
+      thread, then merges blocks pairwise */
+  template<typename T, typename Less = std::less<T>>
+  void parallel_sort(std::vector<T> &items, Less less = Less())
+  {
+    const size_t numItems = items.size();
+    const size_t numBlocks
+      = std::min<size_t>(numWorkerThreads(),numItems/(16*1024)+1);
+    if (numBlocks <= 1) {
+      std::sort(items.begin(),items.end(),less);
+      return;
+    }
+    const size_t blockSize = (numItems+numBlocks-1)/numBlocks;
+    parallel_for_blocked(numItems,blockSize,
+                         [&](size_t begin, size_t end) {
+                           std::sort(items.begin()+begin,
+                                     items.begin()+end,less);
+                         });
+    for (size_t width=blockSize;width<numItems;width*=2) {
+      size_t numPairs = (numItems+2*width-1)/(2*width);
+      parallel_for(numPairs,
+                   [&](size_t pair) {
+                     size_t begin = pair*2*width;
+                     size_t mid   = std::min(numItems,begin+width);
+                     size_t end   = std::min(numItems,begin+2*width);
+                     std::inplace_merge(items.begin()+begin,
+                                        items.begin()+mid,
+                                        items.begin()+end,less);
+                   },1);
+    }
+  }
+
+  /*! sorts 'values' by their (64-bit) 'keys', using a parallel,
+      stable, least-significant-digit-first radix sort over the
+      lowest 'numKeyBits' bits of the keys. Both vectors get
+      reordered */
+  template<typename T>
+  void parallel_radix_sort(std::vector<uint64_t> &keys,
+                           std::vector<T> &values,
+                           int numKeyBits = 64)
+  {
+    enum { digitBits = 8, numDigits = 1<<digitBits };
+    const size_t numItems = keys.size();
+    const size_t numBlocks
+      = std::min<size_t>(4*numWorkerThreads(),numItems/(16*1024)+1);
+    const size_t blockSize = (numItems+numBlocks-1)/std::max<size_t>(numBlocks,1);
+    std::vector<uint64_t> keysTmp(numItems);
+    std::vector<T>        valuesTmp(numItems);
+    std::vector<size_t>   offsets(numBlocks*numDigits);
+    for (int shift=0;shift<numKeyBits;shift+=digitBits) {
+      // per-block histograms of this digit
+      std::fill(offsets.begin(),offsets.end(),0);
+      parallel_for_blocked
+        (numItems,blockSize,
+         [&](size_t begin, size_t end) {
+           size_t *hist = offsets.data()+(begin/blockSize)*numDigits;
+           for (size_t i=begin;i<end;i++)
+             hist[(keys[i] >> shift) & (numDigits-1)]++;
+         });
+      // if all keys have the same digit, this pass wouldn't do
+      // anything
+      bool allSame = false;
+      for (int d=0;d<numDigits && !allSame;d++) {
+        size_t count = 0;
+        for (size_t b=0;b<numBlocks;b++) count += offsets[b*numDigits+d];
+        allSame = (count == numItems);
+      }
+      if (allSame) continue;
+      // exclusive prefix sum, digit-major, so each block's elements
+      // with the same digit go after those of all earlier blocks
+      size_t sum = 0;
+      for (int d=0;d<numDigits;d++)
+        for (size_t b=0;b<numBlocks;b++) {
+          size_t count = offsets[b*numDigits+d];
+          offsets[b*numDigits+d] = sum;
+          sum += count;
+        }
+      parallel_for_blocked
+        (numItems,blockSize,
+         [&](size_t begin, size_t end) {
+           size_t *out = offsets.data()+(begin/blockSize)*numDigits;
+           for (size_t i=begin;i<end;i++) {
+             size_t pos = out[(keys[i] >> shift) & (numDigits-1)]++;
+             keysTmp[pos]   = keys[i];
+             valuesTmp[pos] = values[i];
+           }
+         });
+      keys.swap(keysTmp);
+      values.swap(valuesTmp);
+    }
+  }
+
+}
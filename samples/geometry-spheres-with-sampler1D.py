@@ -45,6 +45,12 @@ cmap.commitParameters()
 points_data = np.fromfile(executable_directory+base_file_name+".points.binary.float3",dtype=np.float32)
 scalar_data = np.fromfile(executable_directory+base_file_name+".scalars.binary.float",dtype=np.float32)
 
+# the input points are in arbitrary order; sorting them (and their
+# scalars) along a space-filling curve makes for faster BVH builds
+sorted_data = anari.spatialSort(points_data, [ scalar_data ])
+points_data = sorted_data['positions']
+scalar_data = sorted_data['companions'][0]
+
 print('creating sphere geom')
 geom = device.newGeometry('sphere')
 geom.setParameterArray1D('vertex.position',anari.float3,points_data)
@@ -150,15 +150,23 @@ volume.setParameter('value',anari.SPATIAL_FIELD,spatial_field)
 volume.setParameter('unitDistance',anari.FLOAT32,.1)
 volume.commitParameters()
 
-iso_geom = device.newGeometry('isosurface')
-iso_geom.setParameter('isovalue',anari.FLOAT32,.3)
-iso_geom.setParameter('field',anari.SPATIAL_FIELD,spatial_field)
-iso_geom.commitParameters()
-
-iso_geom2 = device.newGeometry('isosurface')
-iso_geom2.setParameter('isovalue',anari.FLOAT32,.6)
-iso_geom2.setParameter('field',anari.SPATIAL_FIELD,spatial_field)
-iso_geom2.commitParameters()
+def make_iso_geom(isovalue):
+    if 'isosurface' in device.getObjectSubtypes(anari.GEOMETRY):
+        geom = device.newGeometry('isosurface')
+        geom.setParameter('isovalue',anari.FLOAT32,isovalue)
+        geom.setParameter('field',anari.SPATIAL_FIELD,spatial_field)
+        geom.commitParameters()
+    else:
+        # device can't do isosurfaces itself - extract them as triangles
+        geom = device.newGeometry('triangle')
+        geom.setParameters(anari.volume.marchingCubes(device,cell_array,isovalue,
+                                                      spacing=cellSize,
+                                                      origin=(-1,-1,-1)),
+                           commit=True)
+    return geom
+
+iso_geom = make_iso_geom(.3)
+iso_geom2 = make_iso_geom(.6)
 
 mat = device.newMaterial('physicallyBased')
 mat.setParameter('baseColor',anari.float3,(.1,.1,.8))
@@ -0,0 +1,177 @@
+#!/usr/bin/python3
+
+# golden-image regression test: renders each sample headless (by
+# default on the CPU 'helide' device), compares the result against
+# a stored reference image with pynari.image.compare() (PSNR, SSIM,
+# and a FLIP-style error), and records how long each sample spent in
+# frame.render(). Fails if any image is off by more than the given
+# thresholds, if any sample got slower than its reference timing by
+# more than the allowed factor, or if a sample doesn't have a
+# reference image or timing at all (record those with --update).
+#
+#   python3 regression.py                 # compare against testing/golden/helide
+#   python3 regression.py --update        # (re-)record images and timings
+#   python3 regression.py sample01 sample05
+#
+# no references are checked in yet. The screenshots in samples/
+# were rendered with barney (and are JPEG-compressed), so they can't
+# serve as references for helide; record real ones with --update.
+#
+# each sample runs in its own process, with this script's
+# '--run-one' mode as a wrapper that reports the device's render
+# stats back.
+
+import argparse, glob, json, os, runpy, shutil, subprocess, sys, time
+
+testing_dir = os.path.dirname(os.path.abspath(__file__))
+samples_dir = os.path.join(os.path.dirname(testing_dir), 'samples')
+STATS_TAG = '@regression: '
+
+
+def run_one(sample, out_file):
+    """runs 'sample' as if called with '-o out_file', then prints its
+    device's stats"""
+    sys.argv = [ sample, '-o', out_file ]
+    sys.path.insert(0, os.path.dirname(sample))
+    scope = runpy.run_path(sample, run_name='__main__')
+    device = scope.get('device')
+    stats = device.getStats() if device is not None else {}
+    print(STATS_TAG + json.dumps(stats), flush=True)
+
+
+def all_samples():
+    """all samples that can write their image to a file, ie, that take '-o'"""
+    names = []
+    for fileName in sorted(glob.glob(os.path.join(samples_dir, '*.py'))):
+        with open(fileName) as f:
+            if 'out_file_name' in f.read():
+                names.append(os.path.splitext(os.path.basename(fileName))[0])
+    return names
+
+
+def render(name, args):
+    """renders one sample, returns (output image, stats dict)"""
+    out_file = os.path.join(args.output, name + '.png')
+    if os.path.exists(out_file):
+        os.remove(out_file)
+    env = dict(os.environ, ANARI_LIBRARY=args.library, MPLBACKEND='Agg')
+    begin = time.time()
+    proc = subprocess.run([ sys.executable, os.path.abspath(__file__),
+                            '--run-one', os.path.join(samples_dir, name + '.py'),
+                            out_file ],
+                          cwd=samples_dir, env=env, timeout=args.timeout,
+                          stdout=subprocess.PIPE, stderr=subprocess.STDOUT,
+                          text=True)
+    stats = { 'wallSeconds': time.time() - begin }
+    for line in proc.stdout.splitlines():
+        if line.startswith(STATS_TAG):
+            stats.update(json.loads(line[len(STATS_TAG):]))
+    if proc.returncode != 0 or not os.path.exists(out_file):
+        tail = '\n'.join(proc.stdout.splitlines()[-20:])
+        raise RuntimeError(f'sample failed (exit code {proc.returncode}):\n{tail}')
+    stats['renderSeconds'] = stats.get('renderMicroseconds', 0) * 1e-6
+    return out_file, stats
+
+
+def main():
+    parser = argparse.ArgumentParser(description='pynari golden-image regression test')
+    parser.add_argument('samples', nargs='*',
+                        help='samples to run (default: all that take -o)')
+    parser.add_argument('--library', default='helide',
+                        help='ANARI library to render with')
+    parser.add_argument('--references', default=None,
+                        help='reference images and timings (default: testing/golden/<library>)')
+    parser.add_argument('--output', default='regression-output',
+                        help='where to write rendered images and results.json')
+    parser.add_argument('--update', action='store_true',
+                        help='store rendered images and timings as new references')
+    parser.add_argument('--min-psnr', type=float, default=30.)
+    parser.add_argument('--min-ssim', type=float, default=.95)
+    parser.add_argument('--max-flip', type=float, default=.05)
+    parser.add_argument('--max-slowdown', type=float, default=1.25,
+                        help='max. render time, relative to the reference timings')
+    parser.add_argument('--time-tolerance', type=float, default=.05,
+                        help='render times within this many seconds of the '
+                        'reference timings always pass')
+    parser.add_argument('--timeout', type=float, default=600.,
+                        help='seconds each sample may take')
+    parser.add_argument('--run-one', nargs=2, metavar=('SAMPLE', 'OUT_FILE'),
+                        help=argparse.SUPPRESS)
+    args = parser.parse_args()
+
+    if args.run_one:
+        run_one(*args.run_one)
+        return 0
+
+    import pynari as anari
+    if args.references is None:
+        args.references = os.path.join(testing_dir, 'golden', args.library)
+    os.makedirs(args.output, exist_ok=True)
+    timings_file = os.path.join(args.references, 'timings.json')
+    timings = {}
+    if os.path.exists(timings_file):
+        with open(timings_file) as f:
+            timings = json.load(f)
+
+    results = {}
+    failures = 0
+    for name in args.samples or all_samples():
+        result = results[name] = {}
+        try:
+            out_file, stats = render(name, args)
+        except Exception as e:
+            print(f'@regression: {name}: FAILED - {e}')
+            result['status'] = 'failed'
+            failures += 1
+            continue
+        result.update(stats)
+        reference = os.path.join(args.references, name + '.png')
+        if args.update:
+            os.makedirs(args.references, exist_ok=True)
+            shutil.copyfile(out_file, reference)
+            timings[name] = stats['renderSeconds']
+            result['status'] = 'updated'
+        elif not os.path.exists(reference) or name not in timings:
+            # a sample without references can't catch any regression
+            result['status'] = 'failed'
+            result['problems'] = [ f'no reference image or timing in '
+                                   f'{args.references}; record them with --update' ]
+            failures += 1
+        else:
+            metrics = anari.image.compare(out_file, reference)
+            result.update(metrics)
+            problems = []
+            if metrics['psnr'] < args.min_psnr:
+                problems.append(f'psnr {metrics["psnr"]:.2f} < {args.min_psnr}')
+            if metrics['ssim'] < args.min_ssim:
+                problems.append(f'ssim {metrics["ssim"]:.4f} < {args.min_ssim}')
+            if metrics['flip'] > args.max_flip:
+                problems.append(f'flip {metrics["flip"]:.4f} > {args.max_flip}')
+            if stats['renderSeconds'] > max(args.max_slowdown * timings[name],
+                                            timings[name] + args.time_tolerance):
+                problems.append(f'render time {stats["renderSeconds"]:.3f}s, '
+                                f'was {timings[name]:.3f}s')
+            result['status'] = 'failed' if problems else 'passed'
+            if problems:
+                result['problems'] = problems
+                failures += 1
+        print(f'@regression: {name}: {result["status"]}'
+              + (f' psnr {result["psnr"]:.2f} ssim {result["ssim"]:.4f}'
+                 f' flip {result["flip"]:.4f}' if 'psnr' in result else '')
+              + f' render {stats["renderSeconds"]:.3f}s'
+              + f' ({stats.get("framesRendered", 0)} frames)'
+              + ''.join(f'\n    {p}' for p in result.get('problems', [])))
+
+    if args.update:
+        os.makedirs(args.references, exist_ok=True)
+        with open(timings_file, 'w') as f:
+            json.dump(timings, f, indent=2, sort_keys=True)
+    with open(os.path.join(args.output, 'results.json'), 'w') as f:
+        json.dump({ 'library': args.library, 'samples': results },
+                  f, indent=2, sort_keys=True)
+    print(f'@regression: {len(results) - failures} of {len(results)} samples ok')
+    return 1 if failures else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
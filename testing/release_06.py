@@ -0,0 +1,19 @@
+#!/usr/bin/python3
+
+# simple test case that creates (and then forgets) lots of short-lived
+# objects, and checks the device's live-object stats go back to what
+# they were before.
+
+import pynari as anari
+
+device = anari.newDevice('default')
+before = device.getLiveObjectStats()
+print('live objects before:', before)
+for i in range(10):
+    surfaces = [ device.newSurface() for j in range(10000) ]
+    print('live objects while holding surfaces:',
+          device.getLiveObjectStats())
+    surfaces = None
+after = device.getLiveObjectStats()
+print('live objects after:', after)
+assert before == after
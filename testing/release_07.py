@@ -0,0 +1,47 @@
+#!/usr/bin/python3
+
+# simple test case that creates, sets, and commits lots of objects
+# from several threads at once, and checks the device's live-object
+# stats come out right.
+
+import threading
+import numpy as np
+import pynari as anari
+
+device = anari.newDevice('default')
+before = device.getLiveObjectStats()
+numThreads = 8
+numPerThread = 1000
+results = [ None ] * numThreads
+
+def worker(tid):
+    surfaces = []
+    for i in range(numPerThread):
+        vertices = np.array([0,0,0, 1,0,0, 0,1,0],dtype=np.float32)
+        geom = device.newGeometry('triangle')
+        geom.setParameters({
+            'vertex.position' : (anari.ARRAY1D,
+                                 device.newArray1D(anari.float3,vertices))},
+                           commit=True)
+        mat = device.newMaterial('matte')
+        mat.setParameters({ 'color' : (anari.float3,(tid/numThreads,.5,.5)) },
+                          commit=True)
+        surf = device.newSurface()
+        surf.setParameters({ 'geometry' : (anari.GEOMETRY,geom),
+                             'material' : (anari.MATERIAL,mat) },
+                           commit=True)
+        surfaces.append(surf)
+    results[tid] = surfaces
+
+threads = [ threading.Thread(target=worker,args=(t,))
+            for t in range(numThreads) ]
+for t in threads: t.start()
+for t in threads: t.join()
+
+stats = device.getLiveObjectStats()
+print('live objects while holding surfaces:', stats)
+assert stats['ANARI_SURFACE']['count'] == numThreads*numPerThread
+results = None
+after = device.getLiveObjectStats()
+print('live objects after:', after)
+assert before == after
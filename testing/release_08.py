@@ -0,0 +1,83 @@
+#!/usr/bin/python3
+
+# test case for device.loadArrays(): writes .npz archives (stored and
+# compressed) and a plain .npy file with numpy, loads them natively,
+# and checks every array comes back with the right type, shape, and
+# values.
+
+import os
+import tempfile
+import numpy as np
+import pynari as anari
+
+device = anari.newDevice('default')
+rng = np.random.default_rng(42)
+
+arrays = {
+    # same layout as anari - gets shared straight out of the file
+    'positions' : rng.random((1000,3),dtype=np.float32),
+    # gets converted on the way in
+    'doubles'   : rng.random((257,),dtype=np.float64),
+    'int64s'    : rng.integers(-1000,1000,(33,2),dtype=np.int64),
+    'bigendian' : rng.random((17,4)).astype('>f4'),
+    'bytes'     : rng.integers(0,256,(5,7,9),dtype=np.uint8),
+    'shorts'    : rng.integers(0,65536,(64,64),dtype=np.uint16),
+    'flags'     : rng.random(100) > .5,
+    'scalar'    : np.float32(3.5),
+    # loaded with an explicit type, below
+    'indices'   : rng.integers(0,1000,(300,3),dtype=np.int64),
+    'volume'    : rng.integers(0,256,(8,4,2),dtype=np.uint8),
+}
+types = { 'indices' : anari.UINT32_VEC3,
+          'volume'  : anari.UFIXED8 }
+
+# what each array has to read back as: numpy's dtype conversions
+# match the ones loadArrays() does
+expected = {
+    'positions' : arrays['positions'],
+    'doubles'   : arrays['doubles'].astype(np.float32),
+    'int64s'    : arrays['int64s'].astype(np.int32),
+    'bigendian' : arrays['bigendian'].astype(np.float32),
+    'bytes'     : arrays['bytes'],
+    'shorts'    : arrays['shorts'],
+    'flags'     : arrays['flags'].astype(np.uint8),
+    'scalar'    : np.array([3.5],dtype=np.float32),
+    'indices'   : arrays['indices'].astype(np.uint32),
+    'volume'    : arrays['volume'],
+}
+
+def check(loaded, names):
+    assert sorted(loaded.keys()) == sorted(names), loaded.keys()
+    for name in names:
+        got  = loaded[name].read()
+        want = expected[name]
+        assert got.dtype == want.dtype, (name,got.dtype,want.dtype)
+        assert got.shape == want.shape, (name,got.shape,want.shape)
+        assert np.array_equal(got,want), name
+
+with tempfile.TemporaryDirectory() as tmp:
+    stored = os.path.join(tmp,'stored.npz')
+    np.savez(stored,**arrays)
+    check(device.loadArrays(stored,types=types),arrays.keys())
+
+    compressed = os.path.join(tmp,'compressed.npz')
+    np.savez_compressed(compressed,**arrays)
+    check(device.loadArrays(compressed,types=types),arrays.keys())
+
+    single = os.path.join(tmp,'positions.npy')
+    np.save(single,arrays['positions'])
+    check(device.loadArrays(single),['positions'])
+
+    # a truncated archive has to fail cleanly, not crash
+    with open(compressed,'rb') as f:
+        data = f.read()
+    truncated = os.path.join(tmp,'truncated.npz')
+    with open(truncated,'wb') as f:
+        f.write(data[:len(data)//2])
+    try:
+        device.loadArrays(truncated)
+        assert False, 'loading a truncated archive should have failed'
+    except RuntimeError:
+        pass
+
+print('loadArrays() round-trips ok')
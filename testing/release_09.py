@@ -0,0 +1,110 @@
+#!/usr/bin/python3
+
+# test case for device.saveScene()/loadScene(): builds a small world,
+# writes it to a .pnsc file, loads it back, and checks that every
+# object reachable from the loaded world has the same parameters and
+# array contents as the original.
+
+import os
+import tempfile
+import numpy as np
+import pynari as anari
+
+device = anari.newDevice('default')
+
+def build_world():
+    vertices = np.array([0,0,0, 1,0,0, 0,1,0, 1,1,0],dtype=np.float32)
+    colors   = np.array([1,0,0,1, 0,1,0,1, 0,0,1,1, 1,1,1,1],dtype=np.float32)
+    indices  = np.array([0,1,2, 2,1,3],dtype=np.uint32)
+    mesh = device.newGeometry('triangle')
+    mesh.setParameter('vertex.position',anari.ARRAY1D,
+                      device.newArray1D(anari.float3,vertices))
+    mesh.setParameter('vertex.color',anari.ARRAY1D,
+                      device.newArray1D(anari.float4,colors))
+    mesh.setParameter('primitive.index',anari.ARRAY1D,
+                      device.newArray1D(anari.uint3,indices))
+    mesh.commitParameters()
+
+    # a string-valued parameter
+    textured = device.newMaterial('matte')
+    textured.setParameter('color',anari.STRING,'color')
+    textured.commitParameters()
+
+    centers = np.random.default_rng(7).random((50,3),dtype=np.float32)
+    spheres = device.newGeometry('sphere')
+    spheres.setParameter('vertex.position',anari.ARRAY1D,
+                         device.newArray1D(anari.float3,centers))
+    spheres.setParameter('radius',anari.FLOAT32,.05)
+    spheres.commitParameters()
+
+    plain = device.newMaterial('matte')
+    plain.setParameter('color',anari.float3,(.2,.4,.6))
+    plain.setParameter('opacity',anari.FLOAT32,.75)
+    plain.commitParameters()
+
+    surfaces = []
+    for geom, mat in [ (mesh,textured), (spheres,plain), (mesh,plain) ]:
+        surf = device.newSurface()
+        surf.setParameter('geometry',anari.GEOMETRY,geom)
+        surf.setParameter('material',anari.MATERIAL,mat)
+        surf.commitParameters()
+        surfaces.append(surf)
+
+    light = device.newLight('directional')
+    light.setParameter('direction',anari.float3,(1,-1,-1))
+    light.commitParameters()
+
+    world = device.newWorld()
+    # an array of objects
+    world.setParameterArray1D('surface',anari.SURFACE,surfaces)
+    world.setParameterArray1D('light',anari.LIGHT,[ light ])
+    world.commitParameters()
+    return world
+
+def is_object(value):
+    return hasattr(value,'getParameters')
+
+def compare(a, b, path):
+    assert type(a) == type(b), (path,type(a),type(b))
+    if hasattr(a,'read'):
+        dataA, dataB = a.read(), b.read()
+        if isinstance(dataA,list):
+            assert len(dataA) == len(dataB), path
+            for i, (elemA, elemB) in enumerate(zip(dataA,dataB)):
+                compare(elemA,elemB,'%s[%d]' % (path,i))
+        else:
+            assert dataA.dtype == dataB.dtype, path
+            assert dataA.shape == dataB.shape, path
+            assert np.array_equal(dataA,dataB), path
+    paramsA, paramsB = a.getParameters(), b.getParameters()
+    assert sorted(paramsA.keys()) == sorted(paramsB.keys()), \
+        (path,paramsA.keys(),paramsB.keys())
+    for name in paramsA:
+        (typeA, valueA), (typeB, valueB) = paramsA[name], paramsB[name]
+        assert typeA == typeB, (path+'.'+name,typeA,typeB)
+        if is_object(valueA):
+            compare(valueA,valueB,path+'.'+name)
+        else:
+            assert valueA == valueB, (path+'.'+name,valueA,valueB)
+
+world = build_world()
+with tempfile.TemporaryDirectory() as tmp:
+    fileName = os.path.join(tmp,'scene.pnsc')
+    device.saveScene(world,fileName)
+    loaded = device.loadScene(fileName)
+    compare(world,loaded,'world')
+
+    # a file that got cut short has to fail cleanly, not crash
+    with open(fileName,'rb') as f:
+        data = f.read()
+    truncated = os.path.join(tmp,'truncated.pnsc')
+    with open(truncated,'wb') as f:
+        f.write(data[:len(data)//2])
+    try:
+        device.loadScene(truncated)
+        assert False, 'loading a truncated scene should have failed'
+    except RuntimeError:
+        pass
+    loaded = None
+
+print('saveScene()/loadScene() round-trips ok')
@@ -84,20 +84,22 @@ class AnariSceneBase:
 
         self.update_world(self.device, self.world)
 
-        self.camera.setParameter('aspect', anari.FLOAT32, self.fb_size[0]/self.fb_size[1])
-        self.camera.setParameter('position',anari.FLOAT32_VEC3, eye)
-        self.camera.setParameter('direction',anari.float3, dir)
-        self.camera.setParameter('up',anari.float3, up)
-        self.camera.setParameter('fovy',anari.FLOAT32,fovy*3.14/180)
-        self.camera.commitParameters()
-
-        self.frame.setParameter('size', anari.uint2, self.fb_size)
-        #self.frame.setParameter('channel.color', anari.DATA_TYPE, anari.UFIXED8_VEC4)
-        self.frame.setParameter('channel.color', anari.DATA_TYPE, anari.UFIXED8_RGBA_SRGB)
-        self.frame.setParameter('renderer', anari.OBJECT, self.renderer)
-        self.frame.setParameter('camera', anari.OBJECT, self.camera)
-        self.frame.setParameter('world', anari.OBJECT, self.world)
-        self.frame.commitParameters()
+        self.camera.setParameters({
+            'aspect'    : (anari.FLOAT32, self.fb_size[0]/self.fb_size[1]),
+            'position'  : (anari.FLOAT32_VEC3, eye),
+            'direction' : (anari.float3, dir),
+            'up'        : (anari.float3, up),
+            'fovy'      : (anari.FLOAT32, fovy*3.14/180) },
+            commit=True)
+
+        self.frame.setParameters([
+            ('size', anari.uint2, self.fb_size),
+            #('channel.color', anari.DATA_TYPE, anari.UFIXED8_VEC4),
+            ('channel.color', anari.DATA_TYPE, anari.UFIXED8_RGBA_SRGB),
+            ('renderer', anari.OBJECT, self.renderer),
+            ('camera', anari.OBJECT, self.camera),
+            ('world', anari.OBJECT, self.world) ],
+            commit=True)
 
         self.frame.render()
 
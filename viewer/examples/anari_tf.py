@@ -15,7 +15,6 @@
 # // limitations under the License.                                           //
 # // ======================================================================== //
 
-import numpy as np
 import dearpygui.dearpygui as dpg
 
 # Initial control points (normalized X in [0,1], Y as opacity in [0,1])
@@ -31,42 +30,31 @@ color_start = [0.0, 0.0, 1.0]  # Blue
 color_end = [1.0, 0.0, 0.0]   # Red
 
 RESOLUTION = 128  # Number of points in the transfer function
-# Create a float4 array for color+opacity transfer function
-color_tf = np.zeros((RESOLUTION, 4), dtype=np.float32).flatten()
 
-# Update curve line and recompute opacity transfer function
+# What the editor currently shows: the colors to ramp between, and the
+# (x, opacity) control points. Scenes feed these into a
+# pynari.TransferFunction, which evaluates the actual table natively.
+color_map = [color_start, color_end]
+opacity_points = [tuple(p) for p in control_points]
+
+# Update curve line and opacity control points
 def update_transfer_function():
-    global color_tf, control_points, color_start, color_end
+    global opacity_points, control_points
 
     xs = [dpg.get_value(f"pt_{i}")[0] for i in range(len(control_points))]
     ys = [dpg.get_value(f"pt_{i}")[1] for i in range(len(control_points))]
     dpg.set_value("opacity_curve", [xs, ys])
-    interp_x = np.linspace(0.0, 1.0, RESOLUTION)
-    interp_y = np.interp(interp_x, xs, ys)    
-
-    tf = np.zeros((RESOLUTION, 4), dtype=np.float32)
-
-    # Calculate color ramp
-    for i, t in enumerate(interp_x):
-        # Color from blue to red gradient
-        r = color_start[0] + t * (color_end[0] - color_start[0])
-        g = color_start[1] + t * (color_end[1] - color_start[1])
-        b = color_start[2] + t * (color_end[2] - color_start[2])        
-        a = interp_y[i]  # Alpha from the opacity curve
-        
-        tf[i] = [r, g, b, a]
-    
-    # Clip all values to [0,1] range
-    color_tf = np.clip(tf, 0.0, 1.0).flatten()
+    opacity_points = list(zip(xs, ys))
 
 # Drag point callback
 def on_drag(sender, app_data, user_data):
     update_transfer_function()
 
 def init_show(anari_scene):
-    global color_start, color_end, control_points
+    global color_start, color_end, control_points, color_map
 
     color_start, color_end = anari_scene.get_color_tf()
+    color_map = [color_start[:3], color_end[:3]]
 
     # Setup
     dpg.create_context()
@@ -40,18 +40,15 @@ class AnariScene(AnariSceneBase):
         return color_start, color_end    
     
     def update_world(self, device, world):
-        xf = anari_tf.color_tf
-
-        # Fast comparison of transfer functions
-        if hasattr(self, 'xf') and np.array_equal(xf, self.xf):
+        tf_state = (anari_tf.color_map, anari_tf.opacity_points)
+        if tf_state == self.tf_state:
             return  # Skip update if transfer function hasn't changed
-                
-        # Store current transfer function for future comparisons        
-        self.xf = xf
-        xf_array = device.newArray(anari.float4,xf)        
+        self.tf_state = tf_state
 
-        self.volume.setParameter('color',anari.ARRAY,xf_array)
-        self.volume.commitParameters()
+        # re-evaluates the table in place, in the array the volume
+        # already uses
+        self.tf.setColorMap(anari_tf.color_map)
+        self.tf.setOpacityPoints(anari_tf.opacity_points)
 
     def create_world(self, device):
         """Create and populate the scene with objects."""
@@ -87,50 +84,10 @@ class AnariScene(AnariSceneBase):
             return target_dir + '/DICOM'
 
         def get_volume_unstructured_hexahedra():
-            #-------------------------------------------------------------------------------
-            # Define 8 vertices for a single hexahedron (cube-like volume)
-            positions = np.array([
-                [0, 0, 0],   # 0
-                [1, 0, 0],   # 1
-                [1, 1, 0],   # 2
-                [0, 1, 0],   # 3
-                [0, 0, 1],   # 4
-                [1, 0, 1],   # 5
-                [1, 1, 1],   # 6
-                [0, 1, 1]    # 7
-            ], dtype=np.float32)            
-
-            # One hexahedral cell with 8 vertex indices (assumes CCW ordering)
-            indices = np.array([0, 1, 2, 3, 4, 5, 6, 7], dtype=np.uint32)
-
-            # Scalar value associated with the cell (e.g. density)
-            data = np.array([0.5], dtype=np.float32)
-
-            # Cell type array — one entry per cell
-            VTK_HEXAHEDRON = 12
-            cell_types = np.array([VTK_HEXAHEDRON], dtype=np.uint8)
-
-            # Offset into index array per cell (0 since one cell starts at beginning)
-            cell_index = np.array([0], dtype=np.uint32)
-
-            spatial_field = device.newSpatialField('unstructured')
-
-            array_vertex = device.newArray(anari.FLOAT32_VEC3,positions)
-            spatial_field.setParameter('vertex.position',anari.ARRAY,array_vertex)
-        
-            array_new_cells_np = device.newArray(anari.UINT32,indices)        
-            spatial_field.setParameter('index',anari.ARRAY,array_new_cells_np)
-        
-            array_cell_temperature = device.newArray(anari.FLOAT32,data)        
-            spatial_field.setParameter('cell.data',anari.ARRAY,array_cell_temperature)
-
-            print('------------------------------------------------------- CELL TYPE')
-            array_cell_types_np = device.newArray(anari.UINT8,cell_types)
-            spatial_field.setParameter('cell.type',anari.ARRAY,array_cell_types_np)
-
-            array_cells_index_first_np = device.newArray(anari.UINT32,cell_index)
-            spatial_field.setParameter('cell.index',anari.ARRAY,array_cells_index_first_np)
-            spatial_field.commitParameters()
+            # a single hexahedral cell (e.g. density 0.5) - larger
+            # grids work the same way, with empty cells dropped via 'mask'
+            data = np.array([[[0.5]]], dtype=np.float32)
+            spatial_field = anari.volume.gridToHexMesh(device, data)
             return spatial_field
         
         
@@ -158,22 +115,18 @@ class AnariScene(AnariSceneBase):
             image_data = sitk.GetArrayFromImage(sitk_image3d)
             image_data = image_data.astype(np.float32)
             
-            # Print some info about the loaded data
             print(f"Loaded volume with shape: {image_data.shape}")
-            print(f"Data range: {image_data.min()} to {image_data.max()}")
-
-            # Min-max normalization to [0,1] range
-            min_val = image_data.min()
-            max_val = image_data.max()
-            image_data = (image_data - min_val) / (max_val - min_val)            
-            
             return image_data, image_data.shape
 
         def get_volume_structured():
             cell_values, volume_dims = get_volume_sitk()
             cell_array = np.array(cell_values,dtype=np.float32).reshape(volume_dims)
 
-            structured_data = device.newArray(anari.float,cell_array)
+            # the data's range comes out of the upload itself, rather
+            # than from extra passes over the array
+            structured_data = device.newArray3D(anari.float,cell_array,stats=True)
+            stats = structured_data.stats
+            print(f"Data range: {stats['min']} to {stats['max']}")
 
             cellSize = (2.0/(volume_dims[0]-1),2.0/(volume_dims[1]-1),2.0/(volume_dims[2]-1))
             spatial_field = device.newSpatialField('structuredRegular')
@@ -181,18 +134,21 @@ class AnariScene(AnariSceneBase):
             spatial_field.setParameter('spacing',anari.float3,cellSize)
             spatial_field.setParameter('data',anari.ARRAY3D,structured_data)
             spatial_field.commitParameters()
-            return spatial_field
+            return spatial_field, (stats['min'], stats['max'])
 
-        spatial_field = get_volume_structured()
-        #spatial_field = get_volume_unstructured_hexahedra()
+        spatial_field, value_range = get_volume_structured()
+        #spatial_field, value_range = get_volume_unstructured_hexahedra(), (0., 1.)
         #####TF####
         # Create transfer function using the DearPyGui library
-        self.xf = anari_tf.color_tf
-        xf_array = device.newArray(anari.float4,self.xf)
+        self.tf = anari.TransferFunction(device, anari_tf.RESOLUTION)
+        self.tf_state = (anari_tf.color_map, anari_tf.opacity_points)
+        self.tf.setColorMap(anari_tf.color_map)
+        self.tf.setOpacityPoints(anari_tf.opacity_points)
 
         self.volume = device.newVolume('transferFunction1D')
-        self.volume.setParameter('color',anari.ARRAY,xf_array)
+        self.volume.setParameter('color',anari.ARRAY1D,self.tf)
         self.volume.setParameter('value',anari.SPATIAL_FIELD,spatial_field)
+        self.volume.setParameter('valueRange',anari.FLOAT32_BOX1,value_range)
         self.volume.setParameter('unitDistance',anari.FLOAT32,100.)
         self.volume.commitParameters()
                                                             
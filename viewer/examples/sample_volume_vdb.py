@@ -18,7 +18,6 @@
 import numpy as np
 import pynari as anari
 from pathlib import Path
-import pyopenvdb as vdb
 
 from .anari_scene_base import AnariSceneBase
 from . import anari_tf
@@ -31,18 +30,15 @@ class AnariScene(AnariSceneBase):
         return True  # Whether to use DearPyGui
     
     def update_world(self, device, world):
-        xf = anari_tf.color_tf
-
-        # Fast comparison of transfer functions
-        if hasattr(self, 'xf') and np.array_equal(xf, self.xf):
+        tf_state = (anari_tf.color_map, anari_tf.opacity_points)
+        if tf_state == self.tf_state:
             return  # Skip update if transfer function hasn't changed
-                
-        # Store current transfer function for future comparisons        
-        self.xf = xf
-        xf_array = device.newArray(anari.float4,xf)        
+        self.tf_state = tf_state
 
-        self.volume.setParameter('color',anari.ARRAY,xf_array)
-        self.volume.commitParameters()
+        # re-evaluates the table in place, in the array the volume
+        # already uses
+        self.tf.setColorMap(anari_tf.color_map)
+        self.tf.setOpacityPoints(anari_tf.opacity_points)
 
     def create_world(self, device):
         """Create and populate the scene with objects."""
@@ -114,6 +110,7 @@ class AnariScene(AnariSceneBase):
 
             
         def get_volume_vdb():
+            import pyopenvdb as vdb
             target_file, gridname = download_vdb()
 
             # Read all grids from the file
@@ -122,23 +119,31 @@ class AnariScene(AnariSceneBase):
 
             return array, array.shape
 
-        cell_values, volume_dims = get_volume_vdb()
-        cell_array = np.array(cell_values,dtype=np.float32).reshape(volume_dims)
-
-        structured_data = device.newArray(anari.float,cell_array)
-
-        cellSize = (2.0/(volume_dims[0]-1),2.0/(volume_dims[1]-1),2.0/(volume_dims[2]-1))
-        spatial_field = device.newSpatialField('structuredRegular')
-        spatial_field.setParameter('origin',anari.float3,(-1,-1,-1))
-        spatial_field.setParameter('spacing',anari.float3,cellSize)
-        spatial_field.setParameter('data',anari.ARRAY3D,structured_data)
-        spatial_field.commitParameters()
-
-        self.xf = anari_tf.color_tf
-        xf_array = device.newArray(anari.float4,self.xf)
+        if Path('bunny_cloud.nvdb').exists():
+            # a nanovdb version of the file (eg, from nanovdb_convert)
+            # loads natively, and stays sparse if the device can
+            # render sparse fields
+            spatial_field = device.loadNanoVDB('bunny_cloud.nvdb', 'density')
+        else:
+            cell_values, volume_dims = get_volume_vdb()
+            cell_array = np.array(cell_values,dtype=np.float32).reshape(volume_dims)
+
+            structured_data = device.newArray(anari.float,cell_array)
+
+            cellSize = (2.0/(volume_dims[0]-1),2.0/(volume_dims[1]-1),2.0/(volume_dims[2]-1))
+            spatial_field = device.newSpatialField('structuredRegular')
+            spatial_field.setParameter('origin',anari.float3,(-1,-1,-1))
+            spatial_field.setParameter('spacing',anari.float3,cellSize)
+            spatial_field.setParameter('data',anari.ARRAY3D,structured_data)
+            spatial_field.commitParameters()
+
+        self.tf = anari.TransferFunction(device, anari_tf.RESOLUTION)
+        self.tf_state = (anari_tf.color_map, anari_tf.opacity_points)
+        self.tf.setColorMap(anari_tf.color_map)
+        self.tf.setOpacityPoints(anari_tf.opacity_points)
 
         self.volume = device.newVolume('transferFunction1D')
-        self.volume.setParameter('color',anari.ARRAY,xf_array)
+        self.volume.setParameter('color',anari.ARRAY1D,self.tf)
         self.volume.setParameter('value',anari.SPATIAL_FIELD,spatial_field)
         self.volume.setParameter('unitDistance',anari.FLOAT32,50.)
         self.volume.commitParameters()